@@ -0,0 +1,499 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include <numeric/batch.h>
+#include <numeric/dualquat.h>
+#include <numeric/fast.h>
+#include <numeric/frustum.h>
+#include <numeric/half.h>
+#include <numeric/intersect.h>
+#include <numeric/mat3.h>
+#include <numeric/lut.h>
+#include <numeric/mat4.h>
+#include <numeric/morton.h>
+#include <numeric/packed_float.h>
+#include <numeric/packing.h>
+#include <numeric/quat.h>
+#include <numeric/rebase.h>
+#include <numeric/skinning.h>
+#include <numeric/transform.h>
+
+#include <system/profiler.h>
+
+/*
+ * Micro-benchmarks of the numeric kernels.
+ *
+ *  bench_numeric [--filter <substring>] [--out <file.json>]
+ *
+ * Each kernel runs over arrays of SIZES elements, that fit in L1, in L2 and in neither, for
+ * at least MIN_TIME after a warm-up call. The results are printed as JSON (to stdout or to
+ * the given file) with the time per element and, when the perf counters are available, the
+ * IPC and the cache and branch miss rates of sys::Profiler. Build in release mode.
+ */
+
+using namespace numeric;
+
+namespace {
+
+constexpr size_t SIZES[] = { 256, 4096, 65536 };
+constexpr std::chrono::milliseconds MIN_TIME(50);
+
+// keeps the compiler from removing or merging the kernel calls
+inline void clobber() noexcept {
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+class Bench {
+public:
+    explicit Bench(const char* filter)
+            : m_filter(filter ? filter : ""),
+              m_profiler(sys::Profiler::EV_CPU_CYCLES | sys::Profiler::EV_L1D_RATES |
+                         sys::Profiler::EV_BPU_RATES) {
+        m_results = Json::Value(Json::arrayValue);
+    }
+
+    // runs kernel(count) which must process count elements
+    template<typename KERNEL>
+    void run(const char* name, size_t count, KERNEL kernel) {
+        if (!m_filter.empty() && !strstr(name, m_filter.c_str())) {
+            return;
+        }
+        typedef std::chrono::steady_clock clock;
+
+        kernel(count);
+        clobber();
+
+        // about MIN_TIME worth of iterations, from the time of a single one
+        clock::time_point const c0 = clock::now();
+        kernel(count);
+        clobber();
+        clock::duration const once = std::max(clock::now() - c0, clock::duration(1));
+        size_t const iterations = std::max(size_t(1), size_t(MIN_TIME / once));
+
+        m_profiler.reset();
+        m_profiler.start();
+        clock::time_point const t0 = clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            kernel(count);
+            clobber();
+        }
+        clock::time_point const t1 = clock::now();
+        m_profiler.stop();
+        sys::Profiler::Counters const counters = m_profiler.read_counters();
+
+        double const ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        Json::Value r;
+        r["name"] = name;
+        r["count"] = Json::UInt64(count);
+        r["iterations"] = Json::UInt64(iterations);
+        r["ns_per_element"] = ns / double(iterations * count);
+
+        uint32_t const events = m_profiler.is_valid() ? m_profiler.enabled_events() : 0;
+        Json::Value const null;
+        r["ipc"] = (events & sys::Profiler::EV_CPU_CYCLES) ?
+                Json::Value(counters.get_ipc()) : null;
+        r["l1d_miss_rate"] = (events & sys::Profiler::EV_L1D_RATES) ==
+                sys::Profiler::EV_L1D_RATES ? Json::Value(counters.get_l1d_missrate()) : null;
+        r["branch_miss_rate"] = (events & sys::Profiler::EV_BPU_RATES) ==
+                sys::Profiler::EV_BPU_RATES ? Json::Value(counters.get_branch_missrate()) : null;
+        m_results.append(r);
+
+        fprintf(stderr, "%-28s %8zu %10.3f ns/element\n", name, count,
+                r["ns_per_element"].asDouble());
+    }
+
+    Json::Value report() const {
+        Json::Value root;
+        root["simd"] = NUM_SIMD_AVX512 ? "avx512" : NUM_SIMD_AVX2 ? "avx2" :
+                       NUM_SIMD_AVX ? "avx" : NUM_SIMD_SSE ? "sse2" :
+                       NUM_SIMD_NEON ? "neon" : "none";
+        root["packet_size"] = Json::UInt64(details::NATIVE_PACKET_SIZE);
+        root["perf_counters"] = m_profiler.is_valid();
+        root["benchmarks"] = m_results;
+        return root;
+    }
+
+private:
+    std::string m_filter;
+    sys::Profiler m_profiler;
+    Json::Value m_results;
+};
+
+// input arrays for the largest size, filled once
+struct Data {
+    static constexpr size_t JOINT_COUNT = 64;
+
+    std::default_random_engine engine{ 777 };
+    std::uniform_real_distribution<float> dist{ -1.0f, 1.0f };
+
+    std::vector<float> f0, f1, f2;
+    std::vector<half> h;
+    std::vector<float3> v3, o3;
+    std::vector<mat3f> m3, o3m;
+    std::vector<mat4f> m4, o4;
+    std::vector<mat4> m4d;
+    std::vector<quatf> q;
+    std::vector<Aabb> boxes, out_boxes;
+    std::vector<float> soa[3][4];
+    std::vector<uint32_t> u32;
+    std::vector<uint64_t> u64;
+    std::vector<short2> oct;
+    std::vector<ushort4> joint_indices;
+    std::vector<float4> joint_weights;
+    std::vector<dualquatf> dq;
+    std::vector<Transform> trs, out_trs;
+    std::vector<float> trs_soa[3][10];
+
+    float rand() { return dist(engine); }
+
+    explicit Data(size_t n) : f0(n), f1(n), f2(n), h(n), v3(n), o3(n), m3(n), o3m(n), m4(n),
+            o4(n), m4d(n), q(n), boxes(n), out_boxes(n), u32(n), u64(n), oct(n),
+            joint_indices(n), joint_weights(n), dq(JOINT_COUNT),
+            trs(n), out_trs(n) {
+        for (size_t i = 0; i < n; i++) {
+            f0[i] = rand() * 10.0f;
+            f1[i] = std::abs(rand()) + 0.001f;
+            v3[i] = normalize(float3(rand(), rand(), rand()) + float3(0.01f));
+            q[i] = normalize(quatf(rand(), rand(), rand(), rand()));
+            m3[i] = mat3f(q[i]) * 2.0f;
+            m4[i] = mat4f::translate(v3[i]) * mat4f(m3[i]);
+            m4d[i] = mat4::translate(double3(6378137.0, 0.0, 1000.0 * i)) * mat4(m4[i]);
+            m4[i][0][3] = 0.01f * rand();    // not affine, the general inverse
+            float3 const c = v3[i] * 100.0f;
+            boxes[i] = Aabb::from_center_extent(c, abs(float3(rand(), rand(), rand())));
+            joint_indices[i] = ushort4(i % JOINT_COUNT, (i * 7) % JOINT_COUNT,
+                                       (i * 13) % JOINT_COUNT, (i * 29) % JOINT_COUNT);
+            joint_weights[i] = float4(0.4f, 0.3f, 0.2f, 0.1f);
+        }
+        for (size_t i = 0; i < JOINT_COUNT; i++) {
+            dq[i] = dualquatf(q[i], v3[i]);
+        }
+        for (size_t i = 0; i < n; i++) {
+            trs[i] = Transform(v3[i], q[i], float3(f1[i]));
+        }
+        for (size_t i = 0; i < n; i++) {
+            for (size_t s = 0; s < 3; s++) {
+                Transform const& t = trs[(i + s * 5) % n];
+                float const v[10] = { t.translation.x, t.translation.y, t.translation.z,
+                                      t.rotation.x, t.rotation.y, t.rotation.z, t.rotation.w,
+                                      t.scale.x, t.scale.y, t.scale.z };
+                for (size_t c = 0; c < 10; c++) {
+                    trs_soa[s][c].push_back(v[c]);
+                }
+            }
+        }
+        for (size_t s = 0; s < 3; s++) {
+            for (size_t c = 0; c < 4; c++) {
+                soa[s][c].resize(n);
+                for (size_t i = 0; i < n; i++) {
+                    soa[s][c][i] = s < 2 ? q[(i + s * 7) % n][c] : 0.0f;
+                }
+            }
+        }
+    }
+};
+
+void run_all(Bench& bench, Data& d) {
+    for (size_t n : SIZES) {
+        bench.run("mat4f/inverse", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.o4[i] = inverse(d.m4[i]);
+            }
+        });
+        bench.run("mat4f/inverse_fast", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.o4[i] = inverse_fast(d.m4[i]);
+            }
+        });
+        bench.run("mat4f/multiply", n, [&](size_t count) {
+            mat4f const& a = d.m4[count - 1];
+            for (size_t i = 0; i < count; i++) {
+                d.o4[i] = a * d.m4[i];
+            }
+        });
+        bench.run("mat3f/inverse", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.o3m[i] = inverse(d.m3[i]);
+            }
+        });
+
+        float const* const p[4] = { d.soa[0][0].data(), d.soa[0][1].data(),
+                                     d.soa[0][2].data(), d.soa[0][3].data() };
+        float const* const q[4] = { d.soa[1][0].data(), d.soa[1][1].data(),
+                                     d.soa[1][2].data(), d.soa[1][3].data() };
+        float* const out[4] = { d.soa[2][0].data(), d.soa[2][1].data(),
+                                d.soa[2][2].data(), d.soa[2][3].data() };
+        bench.run("quatf/slerp", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                quatf const a(p[3][i], p[0][i], p[1][i], p[2][i]);
+                quatf const b(q[3][i], q[0][i], q[1][i], q[2][i]);
+                quatf const r = slerp(a, b, 0.3f);
+                out[0][i] = r.x; out[1][i] = r.y; out[2][i] = r.z; out[3][i] = r.w;
+            }
+        });
+        bench.run("quatf/slerp_n", n, [&](size_t count) {
+            slerp_n(p, q, 0.3f, out, count);
+        });
+        bench.run("quatf/slerp_fast_n", n, [&](size_t count) {
+            slerp_fast_n(p, q, 0.3f, out, count);
+        });
+        bench.run("quatf/nlerp", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                quatf const a(p[3][i], p[0][i], p[1][i], p[2][i]);
+                quatf const b(q[3][i], q[0][i], q[1][i], q[2][i]);
+                quatf const r = nlerp(a, b, 0.3f);
+                out[0][i] = r.x; out[1][i] = r.y; out[2][i] = r.z; out[3][i] = r.w;
+            }
+        });
+        bench.run("quatf/nlerp_n", n, [&](size_t count) {
+            nlerp_n(p, q, 0.3f, out, count);
+        });
+        bench.run("quatf/to_mat4", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.o4[i] = mat4f(d.q[i]);
+            }
+        });
+        bench.run("quatf/quat_to_mat4_n", n, [&](size_t count) {
+            quat_to_mat4_n(p, d.o4.data(), count);
+        });
+
+        bench.run("half/f32_to_f16", n, [&](size_t count) {
+            convert_f32_to_f16(d.f0.data(), d.h.data(), count);
+        });
+        bench.run("half/f16_to_f32", n, [&](size_t count) {
+            convert_f16_to_f32(d.h.data(), d.f2.data(), count);
+        });
+
+        bench.run("fast/sin", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.f2[i] = fast::sin(d.f0[i]);
+            }
+        });
+        bench.run("fast/cos", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.f2[i] = fast::cos(d.f0[i]);
+            }
+        });
+        bench.run("fast/exp", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.f2[i] = fast::exp(d.f0[i]);
+            }
+        });
+        bench.run("fast/isqrt", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.f2[i] = fast::isqrt(d.f1[i]);
+            }
+        });
+        bench.run("fast/log2", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.f2[i] = fast::log2(d.f1[i]);
+            }
+        });
+
+        // the packet versions, n is a multiple of the packet size
+        typedef details::Packet<details::NATIVE_PACKET_SIZE> packet;
+        bench.run("fast/sin_packet", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i += packet::SIZE) {
+                fast::sin(packet::load(d.f0.data() + i)).store(d.f2.data() + i);
+            }
+        });
+        bench.run("fast/cos_packet", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i += packet::SIZE) {
+                fast::cos(packet::load(d.f0.data() + i)).store(d.f2.data() + i);
+            }
+        });
+        bench.run("fast/exp2_packet", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i += packet::SIZE) {
+                fast::exp2(packet::load(d.f0.data() + i)).store(d.f2.data() + i);
+            }
+        });
+        bench.run("fast/isqrt_packet", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i += packet::SIZE) {
+                fast::isqrt(packet::load(d.f1.data() + i)).store(d.f2.data() + i);
+            }
+        });
+        bench.run("fast/log2_packet", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i += packet::SIZE) {
+                fast::log2(packet::load(d.f1.data() + i)).store(d.f2.data() + i);
+            }
+        });
+
+        mat4f const m = mat4f::translate(float3(1, 2, 3)) * mat4f(d.q[0]);
+        bench.run("batch/transform_points", n, [&](size_t count) {
+            transform_points(m, d.v3.data(), d.o3.data(), count);
+        });
+        bench.run("batch/transform_aabbs", n, [&](size_t count) {
+            transform_aabbs(m, d.boxes.data(), d.out_boxes.data(), count);
+        });
+        Frustum const frustum(mat4f::perspective(60.0f, 1.5f, 0.1f, 100.0f));
+        bench.run("frustum/cull_aabbs", n, [&](size_t count) {
+            cull_aabbs(frustum, d.boxes.data(), count, d.u32.data());
+        });
+
+        // one ray against the boxes, one at a time and a packet at a time
+        typedef details::Vector3<packet> packet3;
+        std::vector<packet3> box_min((n + packet::SIZE - 1) / packet::SIZE);
+        std::vector<packet3> box_max(box_min.size());
+        for (size_t i = 0; i < n; i++) {
+            for (size_t c = 0; c < 3; c++) {
+                box_min[i / packet::SIZE][c][i % packet::SIZE] = d.boxes[i].min[c];
+                box_max[i / packet::SIZE][c][i % packet::SIZE] = d.boxes[i].max[c];
+            }
+        }
+        Ray const ray{ float3(0.0f), normalize(float3(1.0f, 2.0f, 3.0f)) };
+        bench.run("intersect/ray_aabb", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.f2[i] = intersect(ray, d.boxes[i], d.f0[i]) ? 1.0f : 0.0f;
+            }
+        });
+        bench.run("intersect/ray_aabb_packet", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i += packet::SIZE) {
+                packet t;
+                d.u32[i / packet::SIZE] = intersect(ray, box_min[i / packet::SIZE],
+                        box_max[i / packet::SIZE], t);
+                t.store(d.f2.data() + i);
+            }
+        });
+
+        bench.run("packing/pack_oct32", n, [&](size_t count) {
+            pack_oct32(d.v3.data(), d.oct.data(), count);
+        });
+        bench.run("packing/unpack_oct32", n, [&](size_t count) {
+            unpack_oct32(d.oct.data(), d.o3.data(), count);
+        });
+        bench.run("packed_float/pack_r11g11b10f", n, [&](size_t count) {
+            pack_r11g11b10f(d.v3.data(), d.u32.data(), count);
+        });
+        bench.run("packed_float/pack_rgb9e5", n, [&](size_t count) {
+            pack_rgb9e5(d.v3.data(), d.u32.data(), count);
+        });
+        Aabb const bounds{ float3(-1), float3(1) };
+        bench.run("morton/morton_codes", n, [&](size_t count) {
+            morton_codes(d.v3.data(), bounds, d.u64.data(), count);
+        });
+
+        bench.run("transform/compose", n, [&](size_t count) {
+            Transform const a = d.trs[count - 1];
+            for (size_t i = 0; i < count; i++) {
+                d.out_trs[i] = a * d.trs[i];
+            }
+        });
+        bench.run("transform/decompose", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                d.out_trs[i] = Transform(d.m4[i]);
+            }
+        });
+        auto const streams = [&](size_t s) {
+            TransformStreams r;
+            for (size_t c = 0; c < 3; c++) {
+                r.translation[c] = d.trs_soa[s][c].data();
+                r.scale[c] = d.trs_soa[s][c + 7].data();
+            }
+            for (size_t c = 0; c < 4; c++) {
+                r.rotation[c] = d.trs_soa[s][c + 3].data();
+            }
+            return r;
+        };
+        bench.run("transform/compose_streams", n, [&](size_t count) {
+            compose(streams(0), streams(1), streams(2), count);
+        });
+
+        // f1 is in [0.001, 1.001]
+        bench.run("lut/linear_to_srgb_pow", n, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                float const x = d.f1[i];
+                d.f2[i] = x <= 0.0031308f ? x * 12.92f : 1.055f * std::pow(x, 1.0f / 2.4f) - 0.055f;
+            }
+        });
+        bench.run("lut/linear_to_srgb", n, [&](size_t count) {
+            auto const& table = linear_to_srgb_lut();
+            for (size_t i = 0; i < count; i++) {
+                d.f2[i] = table(d.f1[i]);
+            }
+        });
+        bench.run("lut/linear_to_srgb_n", n, [&](size_t count) {
+            linear_to_srgb_lut()(d.f1.data(), d.f2.data(), count);
+        });
+
+        // camera-relative matrices of a geo-scale scene
+        double3 const eye(6378000.0, 10.0, 500.0);
+        bench.run("rebase/matrices", n, [&](size_t count) {
+            rebase(d.m4d.data(), eye, d.o4.data(), count);
+        });
+        bench.run("rebase/local", n, [&](size_t count) {
+            rebase(d.m4d[0], eye, d.m4.data(), d.o4.data(), count);
+        });
+        bench.run("rebase/local_double", n, [&](size_t count) {
+            mat4 const& parent = d.m4d[0];
+            for (size_t i = 0; i < count; i++) {
+                d.o4[i] = rebase(parent * mat4(d.m4[i]), eye);
+            }
+        });
+
+        std::vector<mat4f> joints(Data::JOINT_COUNT);
+        for (size_t i = 0; i < Data::JOINT_COUNT; i++) {
+            joints[i] = d.dq[i].to_matrix();
+        }
+        bench.run("skinning/skin_linear", n, [&](size_t count) {
+            skin_linear(joints.data(), d.joint_indices.data(), d.joint_weights.data(),
+                    d.v3.data(), d.v3.data(), d.o3.data(), d.o3.data(), count);
+        });
+        bench.run("skinning/skin_dualquat", n, [&](size_t count) {
+            skin_dualquat(d.dq.data(), d.joint_indices.data(), d.joint_weights.data(),
+                    d.v3.data(), d.v3.data(), d.o3.data(), d.o3.data(), count);
+        });
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    const char* filter = nullptr;
+    const char* out = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            out = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--filter <substring>] [--out <file.json>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Bench bench(filter);
+    std::unique_ptr<Data> data(new Data(*std::max_element(std::begin(SIZES), std::end(SIZES))));
+    run_all(bench, *data);
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "    ";
+    std::unique_ptr<Json::StreamWriter> const writer(builder.newStreamWriter());
+    if (out) {
+        std::ofstream file(out);
+        if (!file) {
+            fprintf(stderr, "cannot write %s\n", out);
+            return 1;
+        }
+        writer->write(bench.report(), &file);
+        file << std::endl;
+    } else {
+        writer->write(bench.report(), &std::cout);
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,502 @@
+#ifndef CHROMA_NUMERIC_BATCH_H
+#define CHROMA_NUMERIC_BATCH_H
+
+#include "bounds.h"
+#include "mat3.h"
+#include "mat4.h"
+#include "packet.h"
+#include "quat.h"
+#include "vec3.h"
+#include "details/compiler.h"
+
+#include <stddef.h>
+
+/*
+ * Array versions of the common transforms. The arrays are processed NATIVE_PACKET_SIZE
+ * elements at a time using the SoA packets of packet.h, the remainder goes through the same
+ * code with a partially filled packet.
+ *
+ * Each function exists in two flavors:
+ *  - array-of-structures: const float3* in, float3* out
+ *  - structure-of-arrays: float const* const in[3], float* const out[3], where in[0], in[1]
+ *    and in[2] point to the x, y and z streams. This is the fastest form, no shuffling is
+ *    needed to fill the packets.
+ *
+ * in and out can be the same array, but must not otherwise overlap.
+ */
+
+namespace numeric {
+namespace details {
+namespace batch {
+
+    typedef Packet<NATIVE_PACKET_SIZE> packet;
+    typedef Vector3<packet> packet3;
+
+    inline packet3 load(float3 const* in, size_t count) noexcept {
+        packet3 r(packet(0.0f), packet(0.0f), packet(0.0f));
+        for (size_t i = 0; i < count; i++) {
+            r.x[i] = in[i].x;
+            r.y[i] = in[i].y;
+            r.z[i] = in[i].z;
+        }
+        return r;
+    }
+
+    inline void store(float3* out, packet3 const& v, size_t count) noexcept {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = float3(v.x[i], v.y[i], v.z[i]);
+        }
+    }
+
+    inline packet3 load(float const* const in[3], size_t offset, size_t count) noexcept {
+        if (NUM_LIKELY(count == packet::SIZE)) {
+            return packet3(packet::load(in[0] + offset),
+                           packet::load(in[1] + offset),
+                           packet::load(in[2] + offset));
+        }
+        packet3 r(packet(0.0f), packet(0.0f), packet(0.0f));
+        for (size_t i = 0; i < count; i++) {
+            r.x[i] = in[0][offset + i];
+            r.y[i] = in[1][offset + i];
+            r.z[i] = in[2][offset + i];
+        }
+        return r;
+    }
+
+    inline void store(float* const out[3], size_t offset, packet3 const& v, size_t count) noexcept {
+        if (NUM_LIKELY(count == packet::SIZE)) {
+            v.x.store(out[0] + offset);
+            v.y.store(out[1] + offset);
+            v.z.store(out[2] + offset);
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            out[0][offset + i] = v.x[i];
+            out[1][offset + i] = v.y[i];
+            out[2][offset + i] = v.z[i];
+        }
+    }
+
+    inline packet3 normalize_packet(packet3 const& n) noexcept {
+        packet l2 = madd(n.x, n.x, madd(n.y, n.y, n.z * n.z));
+        packet s = packet(1.0f) / sqrt(l2);
+        return packet3(n.x * s, n.y * s, n.z * s);
+    }
+
+    /*
+     * Quaternions are stored as 4 streams x, y, z and w. packet4 holds them in the same order
+     * as Quaternion, i.e. the real part is w.
+     */
+    typedef Vector4<packet> packet4;
+
+    inline packet load(float const* in, size_t offset, size_t count) noexcept {
+        if (NUM_LIKELY(count == packet::SIZE)) {
+            return packet::load(in + offset);
+        }
+        packet r(0.0f);
+        for (size_t i = 0; i < count; i++) {
+            r[i] = in[offset + i];
+        }
+        return r;
+    }
+
+    inline packet4 load_quat(float const* const in[4], size_t offset, size_t count) noexcept {
+        return packet4(load(in[0], offset, count), load(in[1], offset, count),
+                       load(in[2], offset, count), load(in[3], offset, count));
+    }
+
+    inline void store_quat(float* const out[4], size_t offset, packet4 const& v,
+            size_t count) noexcept {
+        for (size_t c = 0; c < 4; c++) {
+            if (NUM_LIKELY(count == packet::SIZE)) {
+                v[c].store(out[c] + offset);
+            } else {
+                for (size_t i = 0; i < count; i++) {
+                    out[c][offset + i] = v[c][i];
+                }
+            }
+        }
+    }
+
+    // interpolation factor, either the same for every element or one per element
+    struct uniform_weight {
+        float t;
+        packet load(size_t, size_t) const noexcept { return packet(t); }
+    };
+
+    struct weight_array {
+        float const* t;
+        packet load(size_t offset, size_t count) const noexcept {
+            return batch::load(t, offset, count);
+        }
+    };
+
+    inline NUM_ALWAYS_INLINE packet dot_quat(packet4 const& p, packet4 const& q) noexcept {
+        return madd(p.x, q.x, madd(p.y, q.y, madd(p.z, q.z, p.w * q.w)));
+    }
+
+    inline NUM_ALWAYS_INLINE packet4 normalize_quat(packet4 const& q) noexcept {
+        packet const s = packet(1.0f) / sqrt(dot_quat(q, q));
+        return packet4(q.x * s, q.y * s, q.z * s, q.w * s);
+    }
+
+    // p * s0 + q * s1
+    inline NUM_ALWAYS_INLINE packet4 blend_quat(packet4 const& p, packet const& s0,
+            packet4 const& q, packet const& s1) noexcept {
+        return packet4(madd(p.x, s0, q.x * s1), madd(p.y, s0, q.y * s1),
+                       madd(p.z, s0, q.z * s1), madd(p.w, s0, q.w * s1));
+    }
+
+    // p * q, with the real parts in w
+    inline NUM_ALWAYS_INLINE packet4 mul_quat(packet4 const& p, packet4 const& q) noexcept {
+        return packet4(
+                madd(p.w, q.x, madd(p.x, q.w, madd(p.y, q.z, -(p.z * q.y)))),
+                madd(p.w, q.y, madd(p.y, q.w, madd(p.z, q.x, -(p.x * q.z)))),
+                madd(p.w, q.z, madd(p.z, q.w, madd(p.x, q.y, -(p.y * q.x)))),
+                madd(p.w, q.w, -madd(p.x, q.x, madd(p.y, q.y, p.z * q.z))));
+    }
+
+    inline packet3 scale(packet3 const& v, packet s) noexcept {
+        return packet3(v.x * s, v.y * s, v.z * s);
+    }
+
+    inline packet4 scale(packet4 const& v, packet s) noexcept {
+        return packet4(v.x * s, v.y * s, v.z * s, v.w * s);
+    }
+
+    // the rotation of the unit quaternion r applied to v
+    inline packet3 rotate(packet4 const& r, packet3 const& v) noexcept {
+        packet3 const q(r.x, r.y, r.z);
+        packet3 const t = cross(q, v) + scale(v, r.w);
+        return v + scale(cross(q, t), packet(2.0f));
+    }
+
+    /*
+     * The interpolation kernels are function objects so that they are inlined in the
+     * apply_quat() loop.
+     */
+    struct nlerp_kernel {
+        NUM_ALWAYS_INLINE
+        packet4 operator()(packet4 const& p, packet4 const& q, packet const& t) const noexcept {
+            return normalize_quat(blend_quat(p, packet(1.0f) - t, q, t));
+        }
+    };
+
+    struct slerp_kernel {
+        NUM_ALWAYS_INLINE
+        packet4 operator()(packet4 const& p, packet4 const& q, packet const& t) const noexcept {
+            packet const d = dot_quat(p, q);
+            packet const c = min(abs(d) / sqrt(dot_quat(p, p) * dot_quat(q, q)), packet(1.0f));
+            packet const a = packet::map(c, [](auto v) { return simd::fast_acos_positive(v); });
+            packet const isina = packet(1.0f) / fast::sin(a);
+            packet s0 = fast::sin(a * (packet(1.0f) - t)) * isina;
+            packet s1 = fast::sin(a * t) * isina;
+            // below ~1e-3 radians slerp and lerp agree to float precision, and 1/sin(a) blows up
+            packet const small(1e-3f);
+            s0 = select_lt(a, small, packet(1.0f) - t, s0);
+            s1 = select_lt(a, small, t, s1);
+            // take the short side
+            s1 = select_lt(d, packet(0.0f), -s1, s1);
+            return normalize_quat(blend_quat(p, s0, q, s1));
+        }
+    };
+
+    // nlerp with t adjusted by a polynomial in |dot(p, q)|, see slerp_fast_n()
+    struct slerp_fast_kernel {
+        NUM_ALWAYS_INLINE
+        packet4 operator()(packet4 const& p, packet4 const& q, packet const& t) const noexcept {
+            packet const d = dot_quat(p, q);
+            packet const ad = abs(d);
+            packet const a = madd(ad, madd(ad, madd(ad, packet(-1.43519f), packet(3.55645f)),
+                    packet(-3.2452f)), packet(1.0904f));
+            packet const b = madd(ad, madd(ad, packet(0.215638f), packet(-1.06021f)),
+                    packet(0.848013f));
+            packet const h = t - packet(0.5f);
+            packet const k = madd(a * h, h, b);
+            packet const u = madd(t * h * (t - packet(1.0f)), k, t);
+            packet const s1 = select_lt(d, packet(0.0f), -u, u);
+            return normalize_quat(blend_quat(p, packet(1.0f) - u, q, s1));
+        }
+    };
+
+    template<typename WEIGHT, typename KERNEL>
+    inline void apply_quat(float const* const p[4], float const* const q[4], WEIGHT t,
+            float* const out[4], size_t count, KERNEL kernel) noexcept {
+        // full packets, with the stream pointers kept in registers
+        float const* const px = p[0], * const py = p[1], * const pz = p[2], * const pw = p[3];
+        float const* const qx = q[0], * const qy = q[1], * const qz = q[2], * const qw = q[3];
+        float* const ox = out[0], * const oy = out[1], * const oz = out[2], * const ow = out[3];
+        size_t i = 0;
+        for (; i + packet::SIZE <= count; i += packet::SIZE) {
+            packet4 const r = kernel(
+                    packet4(packet::load(px + i), packet::load(py + i),
+                            packet::load(pz + i), packet::load(pw + i)),
+                    packet4(packet::load(qx + i), packet::load(qy + i),
+                            packet::load(qz + i), packet::load(qw + i)),
+                    t.load(i, packet::SIZE));
+            r.x.store(ox + i);
+            r.y.store(oy + i);
+            r.z.store(oz + i);
+            r.w.store(ow + i);
+        }
+        if (i < count) {
+            size_t const n = count - i;
+            store_quat(out, i, kernel(load_quat(p, i, n), load_quat(q, i, n), t.load(i, n)), n);
+        }
+    }
+
+    // transposes the 9 packets of rotation coefficients into count matrices
+    inline void store_rotation(mat3f* out, packet const m[9], size_t count) noexcept {
+        for (size_t j = 0; j < count; j++) {
+            float* const d = &out[j][0][0];
+            for (size_t k = 0; k < 9; k++) {
+                d[k] = m[k].v[j];
+            }
+        }
+    }
+
+    inline void store_rotation(mat4f* out, packet const m[9], size_t count) noexcept {
+        for (size_t j = 0; j < count; j++) {
+            float* const d = &out[j][0][0];
+            d[0] = m[0].v[j]; d[1] = m[1].v[j]; d[2] = m[2].v[j]; d[3] = 0;
+            d[4] = m[3].v[j]; d[5] = m[4].v[j]; d[6] = m[5].v[j]; d[7] = 0;
+            d[8] = m[6].v[j]; d[9] = m[7].v[j]; d[10] = m[8].v[j]; d[11] = 0;
+            d[12] = 0; d[13] = 0; d[14] = 0; d[15] = 1;
+        }
+    }
+
+    // same formula as the Matrix33 and Matrix44 quaternion constructors
+    template<typename MATRIX>
+    inline void quat_to_matrix(float const* const q[4], MATRIX* out, size_t count) noexcept {
+        for (size_t i = 0; i < count; i += packet::SIZE) {
+            size_t const n = std::min(packet::SIZE, count - i);
+            packet4 const v = load_quat(q, i, n);
+            packet const nq = dot_quat(v, v);
+            packet const s = select_lt(packet(0.0f), nq, packet(2.0f) / nq, packet(0.0f));
+            packet const x = s * v.x;
+            packet const y = s * v.y;
+            packet const z = s * v.z;
+            packet const xx = x * v.x;
+            packet const xy = x * v.y;
+            packet const xz = x * v.z;
+            packet const xw = x * v.w;
+            packet const yy = y * v.y;
+            packet const yz = y * v.z;
+            packet const yw = y * v.w;
+            packet const zz = z * v.z;
+            packet const zw = z * v.w;
+            packet const one(1.0f);
+            packet const m[9] = {
+                    one - yy - zz, xy + zw, xz - yw,
+                    xy - zw, one - xx - zz, yz + xw,
+                    xz + yw, yz - xw, one - xx - yy };
+            store_rotation(out + i, m, n);
+        }
+    }
+
+    // transform_aabb() on packets, a is the absolute value of the upper-left 3x3 of m
+    struct aabb_kernel {
+        mat4f const& m;
+        mat3f const a;
+
+        explicit aabb_kernel(const mat4f& m) noexcept : m(m), a(abs(m.upper_left())) { }
+
+        NUM_ALWAYS_INLINE
+        void operator()(packet3 const& lo, packet3 const& hi,
+                packet3& out_lo, packet3& out_hi) const noexcept {
+            packet const half(0.5f);
+            packet3 const c = transform_point(m, packet3(
+                    (lo.x + hi.x) * half, (lo.y + hi.y) * half, (lo.z + hi.z) * half));
+            packet3 const e = a * packet3(
+                    (hi.x - lo.x) * half, (hi.y - lo.y) * half, (hi.z - lo.z) * half);
+            out_lo = packet3(c.x - e.x, c.y - e.y, c.z - e.z);
+            out_hi = packet3(c.x + e.x, c.y + e.y, c.z + e.z);
+        }
+    };
+
+    template<typename IN, typename OUT, typename KERNEL>
+    inline void apply(IN in, OUT out, size_t count, KERNEL kernel) noexcept {
+        for (size_t i = 0; i < count; i += packet::SIZE) {
+            size_t const n = std::min(packet::SIZE, count - i);
+            store(out + i, kernel(load(in + i, n)), n);
+        }
+    }
+
+    template<typename KERNEL>
+    inline void apply(float const* const in[3], float* const out[3], size_t count,
+            KERNEL kernel) noexcept {
+        for (size_t i = 0; i < count; i += packet::SIZE) {
+            size_t const n = std::min(packet::SIZE, count - i);
+            store(out, i, kernel(load(in, i, n)), n);
+        }
+    }
+
+} // namespace batch
+} // namespace details
+
+/*
+ * Returns the matrix that transforms normals for the given model matrix, that is, the
+ * inverse-transpose of its upper-left 3x3.
+ */
+inline NUM_PURE
+mat3f
+normal_matrix(const mat4f& m) noexcept {
+    return transpose(inverse(m.upper_left()));
+}
+
+// out[i] = (m * { in[i], 1 }).xyz, m must be affine
+inline void
+transform_points(const mat4f& m, float3 const* in, float3* out, size_t count) noexcept {
+    using namespace details::batch;
+    apply(in, out, count, [&m](packet3 const& p) { return transform_point(m, p); });
+}
+
+inline void
+transform_points(const mat4f& m, float const* const in[3], float* const out[3],
+        size_t count) noexcept {
+    using namespace details::batch;
+    apply(in, out, count, [&m](packet3 const& p) { return transform_point(m, p); });
+}
+
+// out[i] = m * in[i], for directions (no translation)
+inline void
+transform_vectors(const mat3f& m, float3 const* in, float3* out, size_t count) noexcept {
+    using namespace details::batch;
+    apply(in, out, count, [&m](packet3 const& v) { return m * v; });
+}
+
+inline void
+transform_vectors(const mat3f& m, float const* const in[3], float* const out[3],
+        size_t count) noexcept {
+    using namespace details::batch;
+    apply(in, out, count, [&m](packet3 const& v) { return m * v; });
+}
+
+/*
+ * out[i] = transform_aabb(m, in[i]), m must be affine. The structure-of-arrays form takes the
+ * x, y and z streams of the min and max corners.
+ */
+inline void
+transform_aabbs(const mat4f& m, Aabb const* in, Aabb* out, size_t count) noexcept {
+    using namespace details::batch;
+    aabb_kernel const kernel(m);
+    for (size_t i = 0; i < count; i += packet::SIZE) {
+        size_t const n = std::min(packet::SIZE, count - i);
+        packet3 lo(packet(0.0f), packet(0.0f), packet(0.0f));
+        packet3 hi(lo);
+        for (size_t j = 0; j < n; j++) {
+            for (size_t c = 0; c < 3; c++) {
+                lo[c][j] = in[i + j].min[c];
+                hi[c][j] = in[i + j].max[c];
+            }
+        }
+        packet3 out_lo, out_hi;
+        kernel(lo, hi, out_lo, out_hi);
+        for (size_t j = 0; j < n; j++) {
+            out[i + j] = Aabb{ float3(out_lo.x[j], out_lo.y[j], out_lo.z[j]),
+                               float3(out_hi.x[j], out_hi.y[j], out_hi.z[j]) };
+        }
+    }
+}
+
+inline void
+transform_aabbs(const mat4f& m, float const* const in_min[3], float const* const in_max[3],
+        float* const out_min[3], float* const out_max[3], size_t count) noexcept {
+    using namespace details::batch;
+    aabb_kernel const kernel(m);
+    for (size_t i = 0; i < count; i += packet::SIZE) {
+        size_t const n = std::min(packet::SIZE, count - i);
+        packet3 lo, hi;
+        kernel(load(in_min, i, n), load(in_max, i, n), lo, hi);
+        store(out_min, i, lo, n);
+        store(out_max, i, hi, n);
+    }
+}
+
+/*
+ * out[i] = normalize(n * in[i]) where n is a normal matrix, see normal_matrix().
+ * The result is renormalized, which is needed as soon as the model matrix has a scale.
+ */
+inline void
+transform_normals(const mat3f& n, float3 const* in, float3* out, size_t count) noexcept {
+    using namespace details::batch;
+    apply(in, out, count, [&n](packet3 const& v) { return normalize_packet(n * v); });
+}
+
+inline void
+transform_normals(const mat3f& n, float const* const in[3], float* const out[3],
+        size_t count) noexcept {
+    using namespace details::batch;
+    apply(in, out, count, [&n](packet3 const& v) { return normalize_packet(n * v); });
+}
+
+/*
+ * Quaternion interpolation, out[i] = interpolate(p[i], q[i], t) where p, q and out are
+ * quaternions in structure-of-arrays form: p[0], p[1], p[2] and p[3] point to the x, y, z
+ * and w streams. t is either the same for all the elements or an array of count weights.
+ * out can be the same arrays as p or q.
+ *
+ * nlerp_n()        normalize(lerp(p, q, t)) like nlerp(), no short side correction.
+ * slerp_n()        slerp(), within 1e-6 of the double precision result for unit quaternions.
+ *                  Unlike the scalar version it also handles p == q.
+ * slerp_fast_n()   nlerp on the short side, with t corrected by a polynomial in dot(p, q)
+ *                  so that the result follows slerp within 4e-4 (measured on unit
+ *                  quaternions, plain nlerp is off by up to 7e-2). About as fast as nlerp.
+ */
+inline void
+nlerp_n(float const* const p[4], float const* const q[4], float t, float* const out[4],
+        size_t count) noexcept {
+    using namespace details::batch;
+    apply_quat(p, q, uniform_weight{ t }, out, count, nlerp_kernel());
+}
+
+inline void
+nlerp_n(float const* const p[4], float const* const q[4], float const* t, float* const out[4],
+        size_t count) noexcept {
+    using namespace details::batch;
+    apply_quat(p, q, weight_array{ t }, out, count, nlerp_kernel());
+}
+
+inline void
+slerp_n(float const* const p[4], float const* const q[4], float t, float* const out[4],
+        size_t count) noexcept {
+    using namespace details::batch;
+    apply_quat(p, q, uniform_weight{ t }, out, count, slerp_kernel());
+}
+
+inline void
+slerp_n(float const* const p[4], float const* const q[4], float const* t, float* const out[4],
+        size_t count) noexcept {
+    using namespace details::batch;
+    apply_quat(p, q, weight_array{ t }, out, count, slerp_kernel());
+}
+
+inline void
+slerp_fast_n(float const* const p[4], float const* const q[4], float t, float* const out[4],
+        size_t count) noexcept {
+    using namespace details::batch;
+    apply_quat(p, q, uniform_weight{ t }, out, count, slerp_fast_kernel());
+}
+
+inline void
+slerp_fast_n(float const* const p[4], float const* const q[4], float const* t,
+        float* const out[4], size_t count) noexcept {
+    using namespace details::batch;
+    apply_quat(p, q, weight_array{ t }, out, count, slerp_fast_kernel());
+}
+
+// out[i] = mat3f(q[i]), q in structure-of-arrays form as above
+inline void
+quat_to_mat3_n(float const* const q[4], mat3f* out, size_t count) noexcept {
+    details::batch::quat_to_matrix(q, out, count);
+}
+
+// out[i] = mat4f(q[i])
+inline void
+quat_to_mat4_n(float const* const q[4], mat4f* out, size_t count) noexcept {
+    details::batch::quat_to_matrix(q, out, count);
+}
+
+} // namespace numeric
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef CHROMA_NUMERIC_BOUNDS_H
+#define CHROMA_NUMERIC_BOUNDS_H
+
+#include "mat3.h"
+#include "mat4.h"
+#include "vec3.h"
+#include "details/compiler.h"
+
+namespace numeric {
+
+// axis-aligned bounding box, given by its two extreme corners
+struct Aabb {
+    float3 min;
+    float3 max;
+
+    inline constexpr float3 center() const noexcept { return (min + max) * 0.5f; }
+
+    // half the size along each axis
+    inline constexpr float3 extent() const noexcept { return (max - min) * 0.5f; }
+
+    static inline constexpr Aabb from_center_extent(const float3& c, const float3& e) noexcept {
+        return Aabb{ c - e, c + e };
+    }
+};
+
+struct Sphere {
+    float3 center;
+    float radius;
+};
+
+/*
+ * Bounds of the box transformed by the affine matrix m, without going through the 8 corners
+ * (J. Arvo, Transforming Axis-Aligned Bounding Boxes, Graphics Gems 1990): the center is
+ * transformed as a point and the extent by the absolute value of the linear part. The result
+ * is the tightest box around the transformed one.
+ */
+inline NUM_PURE
+Aabb
+transform_aabb(const mat4f& m, const Aabb& b) noexcept {
+    float3 const c = b.center();
+    float3 const e = b.extent();
+    mat3f const a = abs(m.upper_left());
+    float3 const tc = m[0].xyz * c.x + m[1].xyz * c.y + m[2].xyz * c.z + m[3].xyz;
+    float3 const te = a[0] * e.x + a[1] * e.y + a[2] * e.z;
+    return Aabb::from_center_extent(tc, te);
+}
+
+} // namespace numeric
+
+#endif
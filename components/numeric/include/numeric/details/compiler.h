@@ -27,6 +27,14 @@
 #   define NUM_PURE
 #endif
 
+#if __has_attribute(always_inline)
+#   define NUM_ALWAYS_INLINE __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#   define NUM_ALWAYS_INLINE __forceinline
+#else
+#   define NUM_ALWAYS_INLINE
+#endif
+
 #ifdef _MSC_VER
 #   define NUM_EMPTY_BASES __declspec(empty_bases)
 // MSVC does not support loop unrolling hints
@@ -0,0 +1,129 @@
+#ifndef CHROMA_NUMERIC_FAST_SIMD_H
+#define CHROMA_NUMERIC_FAST_SIMD_H
+
+/*
+ * No user serviceable parts here.
+ *
+ * Kernels of the packet versions of the fast:: functions (see packet.h). They are written
+ * once against the overloaded primitives of simd.h, so the same code runs on float, SSE,
+ * AVX and NEON registers. The polynomials are the single-precision Cephes ones.
+ */
+
+#include "simd.h"
+
+namespace numeric {
+namespace details {
+namespace simd {
+
+template<typename V>
+inline V k(float c) noexcept {
+    return register_traits<V>::splat(c);
+}
+
+// sin(x + j * pi/2) for x in [-pi/4, pi/4] and an integral j
+template<typename V>
+inline V fast_sin_quadrant(V x, V j) noexcept {
+    V const z = mul(x, x);
+
+    V s = madd(z, k<V>(-1.9515295891e-4f), k<V>(8.3321608736e-3f));
+    s = madd(s, z, k<V>(-1.6666654611e-1f));
+    s = madd(mul(s, z), x, x);
+
+    V c = madd(z, k<V>(2.443315711809948e-5f), k<V>(-1.388731625493765e-3f));
+    c = madd(c, z, k<V>(4.166664568298827e-2f));
+    c = madd(mul(c, z), z, madd(z, k<V>(-0.5f), k<V>(1.0f)));
+
+    // odd quadrants use cos, quadrants 2 and 3 are negated
+    V const h = floor(mul(j, k<V>(0.5f)));
+    V const r = select(lt(add(h, h), j), c, s);
+    V const q = floor(mul(h, k<V>(0.5f)));
+    return select(lt(add(q, q), h), neg(r), r);
+}
+
+// x - j * pi/2 in three steps, the first two products are exact for |j| < 2^15
+template<typename V>
+inline V fast_reduce_half_pi(V x, V j) noexcept {
+    x = madd(j, k<V>(-1.5703125f), x);
+    x = madd(j, k<V>(-4.837512969970703125e-4f), x);
+    return madd(j, k<V>(-7.54978995489188216e-8f), x);
+}
+
+template<typename V>
+inline V fast_sin(V x) noexcept {
+    V const j = round(mul(x, k<V>(0.636619772367581343f)));
+    return fast_sin_quadrant(fast_reduce_half_pi(x, j), j);
+}
+
+template<typename V>
+inline V fast_cos(V x) noexcept {
+    // cos(x) = sin(x + pi/2)
+    V const j = round(mul(x, k<V>(0.636619772367581343f)));
+    return fast_sin_quadrant(fast_reduce_half_pi(x, j), add(j, k<V>(1.0f)));
+}
+
+template<typename V>
+inline V fast_exp2(V x) noexcept {
+    x = min(max(x, k<V>(-127.0f)), k<V>(127.0f));
+    V const n = round(x);
+    V const f = sub(x, n);
+    V p = madd(f, k<V>(1.535336188319500e-4f), k<V>(1.339887440266574e-3f));
+    p = madd(p, f, k<V>(9.618437357674640e-3f));
+    p = madd(p, f, k<V>(5.550332471162809e-2f));
+    p = madd(p, f, k<V>(2.402264791363012e-1f));
+    p = madd(p, f, k<V>(6.931472028550421e-1f));
+    p = madd(p, f, k<V>(1.0f));
+    return mul(p, exp2i(n));
+}
+
+template<typename V>
+inline V fast_log2(V x) noexcept {
+    V e = exponent(x);
+    V m = mantissa(x);
+
+    // m in [sqrt(1/2), sqrt(2)) so that z is small on both sides of 1
+    V const big = lt(k<V>(1.41421356237309504880f), m);
+    m = select(big, mul(m, k<V>(0.5f)), m);
+    e = select(big, add(e, k<V>(1.0f)), e);
+
+    V const z = sub(m, k<V>(1.0f));
+    V const z2 = mul(z, z);
+    V p = madd(z, k<V>(7.0376836292e-2f), k<V>(-1.1514610310e-1f));
+    p = madd(p, z, k<V>(1.1676998740e-1f));
+    p = madd(p, z, k<V>(-1.2420140846e-1f));
+    p = madd(p, z, k<V>(1.4249322787e-1f));
+    p = madd(p, z, k<V>(-1.6668057665e-1f));
+    p = madd(p, z, k<V>(2.0000714765e-1f));
+    p = madd(p, z, k<V>(-2.4999993993e-1f));
+    p = madd(p, z, k<V>(3.3333331174e-1f));
+    V const y = madd(mul(z, z2), p, mul(z2, k<V>(-0.5f)));
+
+    // log2(e) - 1 is applied separately to keep the bits of y + z
+    V const log2ea = k<V>(0.44269504088896340736f);
+    V r = madd(y, log2ea, mul(z, log2ea));
+    r = add(add(r, y), z);
+    return add(r, e);
+}
+
+// acos(x) for x in [0, 1], from Abramowitz and Stegun 4.4.46, about 2e-7 absolute
+template<typename V>
+inline V fast_acos_positive(V x) noexcept {
+    V p = madd(x, k<V>(-0.0012624911f), k<V>(0.0066700901f));
+    p = madd(p, x, k<V>(-0.0170881256f));
+    p = madd(p, x, k<V>(0.0308918810f));
+    p = madd(p, x, k<V>(-0.0501743046f));
+    p = madd(p, x, k<V>(0.0889789874f));
+    p = madd(p, x, k<V>(-0.2145988016f));
+    p = madd(p, x, k<V>(1.5707963050f));
+    return mul(p, sqrt(sub(k<V>(1.0f), x)));
+}
+
+template<typename V>
+inline V fast_pow(V x, V y) noexcept {
+    return fast_exp2(mul(y, fast_log2(x)));
+}
+
+} // namespace simd
+} // namespace details
+} // namespace numeric
+
+#endif
@@ -15,6 +15,7 @@
 #include <exception>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <string>
 
@@ -195,6 +196,23 @@ namespace matrix {
              gauss_jordan_inverse<MATRIX>(matrix));
     }
 
+    // true if m^T * m is the identity, within tolerance on each element
+    template<typename MATRIX>
+    NUM_PURE
+    bool
+    is_orthonormal(const MATRIX& m, typename MATRIX::value_type tolerance) {
+        typedef typename MATRIX::value_type T;
+        for (size_t i = 0; i < MATRIX::NUM_COLS; ++i) {
+            for (size_t j = 0; j < MATRIX::NUM_COLS; ++j) {
+                T const d = dot(m[i], m[j]) - T(i == j ? 1 : 0);
+                if (!(std::abs(d) <= tolerance)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
     template<typename MATRIX_R, typename MATRIX_A, typename MATRIX_B>
     NUM_PURE
     MATRIX_R 
@@ -218,6 +236,41 @@ namespace matrix {
         return res;
     }
 
+    // Reference matrix * column-vector product. The public operators may dispatch to a SIMD
+    // kernel instead (see simd.h), this one always runs the scalar code.
+    template<typename MATRIX, typename VECTOR>
+    constexpr NUM_PURE
+    typename MATRIX::col_type
+    transform_scalar(const MATRIX& lhs, const VECTOR& rhs) {
+        typedef typename MATRIX::value_type T;
+        typename MATRIX::col_type result = {};
+        for (size_t col = 0; col < MATRIX::NUM_COLS; ++col) {
+            for (size_t row = 0; row < MATRIX::NUM_ROWS; ++row) {
+                result[row] += lhs[col][row] * T(rhs[col]);
+            }
+        }
+        return result;
+    }
+
+    // Reference matrix product, see transform_scalar().
+    template<typename MATRIX_R, typename MATRIX_A, typename MATRIX_B>
+    NUM_PURE
+    MATRIX_R
+    multiply_scalar(const MATRIX_A& lhs, const MATRIX_B& rhs) {
+        static_assert(MATRIX_A::NUM_COLS == MATRIX_B::NUM_ROWS,
+                      "matrices can't be multiplied. invalid dimensions.");
+        static_assert(MATRIX_R::NUM_COLS == MATRIX_B::NUM_COLS,
+                      "invalid dimension of matrix multiply result.");
+        static_assert(MATRIX_R::NUM_ROWS == MATRIX_A::NUM_ROWS,
+                      "invalid dimension of matrix multiply result.");
+
+        MATRIX_R res(MATRIX_R::NO_INIT);
+        for (size_t col = 0; col < MATRIX_R::NUM_COLS; ++col) {
+            res[col] = transform_scalar(lhs, rhs[col]);
+        }
+        return res;
+    }
+
     template <typename MATRIX>
     NUM_PURE
     MATRIX  
@@ -302,6 +355,91 @@ namespace matrix {
         return quat;
     }
 
+    /*
+     * Polar decomposition of the 3x3 matrix a = q * s, q orthogonal and s symmetric positive
+     * semi-definite: q is the closest orthogonal matrix to a, s holds the scale and the shear.
+     * Uses the Newton iteration q = (g q + q^-T / g) / 2 scaled by g = sqrt(|q^-1| / |q|)
+     * (Higham, Computing the Polar Decomposition, 1986), which converges in less than 10
+     * iterations. Returns false, leaving q and s undefined, if a is singular.
+     */
+    template<typename MATRIX>
+    bool
+    polar_decompose(const MATRIX& a, MATRIX& q, MATRIX& s) {
+        typedef typename MATRIX::value_type T;
+        static_assert(MATRIX::NUM_ROWS == 3 && MATRIX::NUM_COLS == 3, "3x3 matrices only");
+        constexpr T eps = std::numeric_limits<T>::epsilon();
+
+        // relative to the size of the columns, so that it doesn't depend on the scale
+        T const det = dot(a[0], cross(a[1], a[2]));
+        if (!(std::abs(det) > eps * length(a[0]) * length(a[1]) * length(a[2]))) {
+            return false;
+        }
+
+        q = a;
+        for (size_t k = 0; k < 20; ++k) {
+            // q^-T is the matrix of the cofactors divided by the determinant
+            MATRIX cof(MATRIX::NO_INIT);
+            cof[0] = cross(q[1], q[2]);
+            cof[1] = cross(q[2], q[0]);
+            cof[2] = cross(q[0], q[1]);
+            T const d = dot(q[0], cof[0]);
+            T nq = 0;
+            T ncof = 0;
+            for (size_t col = 0; col < 3; ++col) {
+                nq += dot(q[col], q[col]);
+                ncof += dot(cof[col], cof[col]);
+            }
+            T const g = std::sqrt(std::sqrt(ncof / nq) / std::abs(d));
+            T const h = T(1) / (g * d);
+            T delta = 0;
+            for (size_t col = 0; col < 3; ++col) {
+                auto const next = (q[col] * g + cof[col] * h) * T(0.5);
+                auto const diff = next - q[col];
+                delta += dot(diff, diff);
+                q[col] = next;
+            }
+            if (delta <= 9 * eps * eps) {
+                break;
+            }
+        }
+
+        // q^T a, made exactly symmetric
+        MATRIX const qta = transpose(q) * a;
+        s = (qta + transpose(qta)) * T(0.5);
+        return true;
+    }
+
+    /*
+     * Splits the affine 4x4 matrix m into translation * rotation * scale. The rotation is the
+     * orthogonal factor of the polar decomposition of the upper-left 3x3, the scale is the
+     * diagonal of the other factor; a shear, which a scale can't hold, is dropped. A mirroring
+     * gives a negative scale on every axis. When the 3x3 is singular the rotation is the
+     * identity, the scale holds the lengths of the columns and it returns false.
+     */
+    template<typename MATRIX, typename VECTOR, typename T>
+    bool
+    decompose(const MATRIX& m, VECTOR& translation, Quaternion<T>& rotation, VECTOR& scale) {
+        static_assert(MATRIX::NUM_ROWS == 4 && MATRIX::NUM_COLS == 4, "4x4 matrices only");
+        typedef decltype(m.upper_left()) MATRIX3;
+        translation = m[3].xyz;
+
+        MATRIX3 a = m.upper_left();
+        T const sign = dot(a[0], cross(a[1], a[2])) < 0 ? T(-1) : T(1);
+        for (size_t col = 0; col < 3; ++col) {
+            a[col] *= sign;
+        }
+        MATRIX3 q(MATRIX3::NO_INIT);
+        MATRIX3 s(MATRIX3::NO_INIT);
+        if (!polar_decompose(a, q, s)) {
+            rotation = Quaternion<T>(1, 0, 0, 0);
+            scale = VECTOR(length(a[0]), length(a[1]), length(a[2]));
+            return false;
+        }
+        rotation = normalize(extract_quat(q));
+        scale = VECTOR(s[0][0], s[1][1], s[2][2]) * sign;
+        return true;
+    }
+
 }  // namespace matrix
 
 
@@ -0,0 +1,634 @@
+#ifndef CHROMA_NUMERIC_SIMD_H
+#define CHROMA_NUMERIC_SIMD_H
+
+/*
+ * No user serviceable parts here.
+ *
+ * SIMD backend selection and the float kernels used by the public types. The backend is
+ * chosen at compile time from the target flags (-msse2, -mavx, -mfma, NEON...); defining
+ * NUM_DISABLE_SIMD forces the portable scalar code everywhere.
+ *
+ *  NUM_SIMD_SSE    SSE2 (always true on x86-64)
+ *  NUM_SIMD_SSE41  SSE4.1
+ *  NUM_SIMD_AVX    256-bit AVX
+ *  NUM_SIMD_AVX2   256-bit integer operations
+ *  NUM_SIMD_FMA    fused multiply-add (x86 FMA3 or ARMv8)
+ *  NUM_SIMD_F16C   x86 half-float conversions (vcvtps2ph / vcvtph2ps)
+ *  NUM_SIMD_AVX512 512-bit AVX-512F
+ *  NUM_SIMD_BMI2   x86 bit deposit / extract (pdep / pext), scalar but decided the same way
+ *  NUM_SIMD_NEON   ARM NEON
+ *  NUM_SIMD        any of the above
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "compiler.h"
+
+#if !defined(NUM_DISABLE_SIMD)
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       include <immintrin.h>
+#       define NUM_SIMD_SSE 1
+#       if defined(__SSE4_1__)
+#           define NUM_SIMD_SSE41 1
+#       endif
+#       if defined(__AVX__)
+#           define NUM_SIMD_AVX 1
+#       endif
+#       if defined(__AVX2__)
+#           define NUM_SIMD_AVX2 1
+#       endif
+#       if defined(__FMA__)
+#           define NUM_SIMD_FMA 1
+#       endif
+#       if defined(__F16C__)
+#           define NUM_SIMD_F16C 1
+#       endif
+#       if defined(__AVX512F__)
+#           define NUM_SIMD_AVX512 1
+#       endif
+#       if defined(__BMI2__)
+#           define NUM_SIMD_BMI2 1
+#       endif
+#   elif defined(__ARM_NEON)
+#       include <arm_neon.h>
+#       define NUM_SIMD_NEON 1
+#       if defined(__aarch64__)
+#           define NUM_SIMD_FMA 1
+#       endif
+#   endif
+#endif
+
+#if defined(NUM_SIMD_SSE) || defined(NUM_SIMD_NEON)
+#   define NUM_SIMD 1
+#else
+#   define NUM_SIMD 0
+#endif
+
+#ifndef NUM_SIMD_SSE
+#   define NUM_SIMD_SSE 0
+#endif
+#ifndef NUM_SIMD_SSE41
+#   define NUM_SIMD_SSE41 0
+#endif
+#ifndef NUM_SIMD_AVX
+#   define NUM_SIMD_AVX 0
+#endif
+#ifndef NUM_SIMD_AVX2
+#   define NUM_SIMD_AVX2 0
+#endif
+#ifndef NUM_SIMD_FMA
+#   define NUM_SIMD_FMA 0
+#endif
+#ifndef NUM_SIMD_F16C
+#   define NUM_SIMD_F16C 0
+#endif
+#ifndef NUM_SIMD_AVX512
+#   define NUM_SIMD_AVX512 0
+#endif
+#ifndef NUM_SIMD_BMI2
+#   define NUM_SIMD_BMI2 0
+#endif
+#ifndef NUM_SIMD_NEON
+#   define NUM_SIMD_NEON 0
+#endif
+
+namespace numeric {
+namespace details {
+namespace simd {
+
+#if NUM_SIMD_SSE
+
+    inline __m128 madd(__m128 a, __m128 b, __m128 c) noexcept {
+#if NUM_SIMD_FMA
+        return _mm_fmadd_ps(a, b, c);
+#else
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+
+#if NUM_SIMD_AVX
+    inline __m256 madd(__m256 a, __m256 b, __m256 c) noexcept {
+#if NUM_SIMD_FMA
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+#endif
+
+    // out = m * v, m is a column-major 4x4 matrix. out may alias v.
+    inline void mul_m4v4(float const* m, float const* v, float* out) noexcept {
+        __m128 r = _mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(v[0]));
+        r = madd(_mm_loadu_ps(m + 4),  _mm_set1_ps(v[1]), r);
+        r = madd(_mm_loadu_ps(m + 8),  _mm_set1_ps(v[2]), r);
+        r = madd(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3]), r);
+        _mm_storeu_ps(out, r);
+    }
+
+    // out = a * b, all column-major 4x4 matrices. out must not alias a or b.
+    inline void mul_m4m4(float const* a, float const* b, float* out) noexcept {
+#if NUM_SIMD_AVX
+        // two columns of the result per iteration, the columns of a are duplicated in
+        // both 128-bit lanes.
+        __m256 const a0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(a));
+        __m256 const a1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(a + 4));
+        __m256 const a2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(a + 8));
+        __m256 const a3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(a + 12));
+        for (size_t col = 0; col < 4; col += 2) {
+            __m256 const bc = _mm256_loadu_ps(b + col * 4);
+            __m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(bc, 0x00));
+            r = madd(a1, _mm256_permute_ps(bc, 0x55), r);
+            r = madd(a2, _mm256_permute_ps(bc, 0xAA), r);
+            r = madd(a3, _mm256_permute_ps(bc, 0xFF), r);
+            _mm256_storeu_ps(out + col * 4, r);
+        }
+#else
+        __m128 const a0 = _mm_loadu_ps(a);
+        __m128 const a1 = _mm_loadu_ps(a + 4);
+        __m128 const a2 = _mm_loadu_ps(a + 8);
+        __m128 const a3 = _mm_loadu_ps(a + 12);
+        for (size_t col = 0; col < 4; col++) {
+            float const* bc = b + col * 4;
+            __m128 r = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+            r = madd(a1, _mm_set1_ps(bc[1]), r);
+            r = madd(a2, _mm_set1_ps(bc[2]), r);
+            r = madd(a3, _mm_set1_ps(bc[3]), r);
+            _mm_storeu_ps(out + col * 4, r);
+        }
+#endif
+    }
+
+    // a.yzx * b.zxy - a.zxy * b.yzx, w is 0 when a.w or b.w is 0
+    inline __m128 cross3(__m128 a, __m128 b) noexcept {
+        __m128 const a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 const b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 const c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    // out = { c0, c1, c2, -(c0 * t.x + c1 * t.y + c2 * t.z) + { 0, 0, 0, 1 } }
+    inline void store_inverse_m4(__m128 c0, __m128 c1, __m128 c2, float const* t,
+            float* out) noexcept {
+        __m128 r = _mm_mul_ps(c0, _mm_set1_ps(t[0]));
+        r = madd(c1, _mm_set1_ps(t[1]), r);
+        r = madd(c2, _mm_set1_ps(t[2]), r);
+        r = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), r);
+        _mm_storeu_ps(out, c0);
+        _mm_storeu_ps(out + 4, c1);
+        _mm_storeu_ps(out + 8, c2);
+        _mm_storeu_ps(out + 12, r);
+    }
+
+    // out = inverse(m), m is an affine column-major 4x4 matrix. out must not alias m.
+    inline void inverse_affine_m4(float const* m, float* out) noexcept {
+        // clear w so that the cross products and the transpose have a 0 there
+        __m128 const mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        __m128 const a0 = _mm_and_ps(_mm_loadu_ps(m), mask);
+        __m128 const a1 = _mm_and_ps(_mm_loadu_ps(m + 4), mask);
+        __m128 const a2 = _mm_and_ps(_mm_loadu_ps(m + 8), mask);
+
+        // the rows of the inverse are the cross products of the columns over the determinant
+        __m128 r0 = cross3(a1, a2);
+        __m128 r1 = cross3(a2, a0);
+        __m128 r2 = cross3(a0, a1);
+        __m128 d = _mm_mul_ps(a0, r0);
+        d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+        d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+        __m128 const inv_det = _mm_div_ps(_mm_set1_ps(1.0f), d);
+        r0 = _mm_mul_ps(r0, inv_det);
+        r1 = _mm_mul_ps(r1, inv_det);
+        r2 = _mm_mul_ps(r2, inv_det);
+
+        __m128 r3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        store_inverse_m4(r0, r1, r2, m + 12, out);
+    }
+
+    // out = inverse(m), m is a rotation and a translation. out must not alias m.
+    inline void inverse_rigid_m4(float const* m, float* out) noexcept {
+        __m128 c0 = _mm_loadu_ps(m);
+        __m128 c1 = _mm_loadu_ps(m + 4);
+        __m128 c2 = _mm_loadu_ps(m + 8);
+        __m128 c3 = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        store_inverse_m4(c0, c1, c2, m + 12, out);
+    }
+
+    /*
+     * out = a * b with the layout of numeric::Transform: translation, rotation (x, y, z, w)
+     * and scale at 0, 4 and 8 floats, the 4th float of the translation and the scale being
+     * padding. out may alias a or b.
+     */
+    inline void compose_trs(float const* a, float const* b, float* out) noexcept {
+        __m128 const mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        __m128 const at = _mm_and_ps(_mm_loadu_ps(a), mask);
+        __m128 const ar = _mm_loadu_ps(a + 4);
+        __m128 const as = _mm_and_ps(_mm_loadu_ps(a + 8), mask);
+        __m128 const bt = _mm_and_ps(_mm_loadu_ps(b), mask);
+        __m128 const br = _mm_loadu_ps(b + 4);
+        __m128 const bs = _mm_and_ps(_mm_loadu_ps(b + 8), mask);
+
+        // v + 2 w (r x v) + 2 r x (r x v), the rotation of v = as * bt
+        __m128 const v = _mm_mul_ps(as, bt);
+        __m128 const aw = _mm_shuffle_ps(ar, ar, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 const c = cross3(ar, v);
+        __m128 const c2 = _mm_add_ps(c, c);
+        __m128 const t = _mm_add_ps(madd(c2, aw, v), cross3(ar, c2));
+
+        // ar * br, the w lane of the 2nd and 3rd terms is negated
+        __m128 const sign = _mm_setr_ps(0.0f, 0.0f, 0.0f, -0.0f);
+        __m128 r = _mm_mul_ps(aw, br);
+        r = madd(_mm_xor_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(0, 2, 1, 0)), sign),
+                 _mm_shuffle_ps(br, br, _MM_SHUFFLE(0, 3, 3, 3)), r);
+        r = madd(_mm_xor_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(1, 0, 2, 1)), sign),
+                 _mm_shuffle_ps(br, br, _MM_SHUFFLE(1, 1, 0, 2)), r);
+        r = _mm_sub_ps(r, _mm_mul_ps(_mm_shuffle_ps(ar, ar, _MM_SHUFFLE(2, 1, 0, 2)),
+                                     _mm_shuffle_ps(br, br, _MM_SHUFFLE(2, 0, 2, 1))));
+
+        _mm_storeu_ps(out, _mm_add_ps(t, at));
+        _mm_storeu_ps(out + 4, r);
+        _mm_storeu_ps(out + 8, _mm_mul_ps(as, bs));
+    }
+
+    /*
+     * out = float(translate(-origin) * m), m is a column-major affine 4x4 matrix of doubles
+     * and origin a point (x, y, z). Only the translation is subtracted, in double.
+     */
+    inline void rebase_m4(double const* m, double const* origin, float* out) noexcept {
+#if NUM_SIMD_AVX
+        for (size_t col = 0; col < 3; col++) {
+            _mm_storeu_ps(out + col * 4, _mm256_cvtpd_ps(_mm256_loadu_pd(m + col * 4)));
+        }
+        __m256d const o = _mm256_setr_pd(origin[0], origin[1], origin[2], 0.0);
+        _mm_storeu_ps(out + 12, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(m + 12), o)));
+#else
+        for (size_t col = 0; col < 3; col++) {
+            __m128 const lo = _mm_cvtpd_ps(_mm_loadu_pd(m + col * 4));
+            __m128 const hi = _mm_cvtpd_ps(_mm_loadu_pd(m + col * 4 + 2));
+            _mm_storeu_ps(out + col * 4, _mm_movelh_ps(lo, hi));
+        }
+        __m128 const lo = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(m + 12), _mm_loadu_pd(origin)));
+        __m128 const hi = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(m + 14),
+                                                  _mm_setr_pd(origin[2], 0.0)));
+        _mm_storeu_ps(out + 12, _mm_movelh_ps(lo, hi));
+#endif
+    }
+
+#elif NUM_SIMD_NEON
+
+    inline float32x4_t madd(float32x4_t a, float32x4_t b, float32x4_t c) noexcept {
+#if NUM_SIMD_FMA
+        return vfmaq_f32(c, a, b);
+#else
+        return vmlaq_f32(c, a, b);
+#endif
+    }
+
+    inline void mul_m4v4(float const* m, float const* v, float* out) noexcept {
+        float32x4_t r = vmulq_n_f32(vld1q_f32(m), v[0]);
+        r = madd(vld1q_f32(m + 4),  vdupq_n_f32(v[1]), r);
+        r = madd(vld1q_f32(m + 8),  vdupq_n_f32(v[2]), r);
+        r = madd(vld1q_f32(m + 12), vdupq_n_f32(v[3]), r);
+        vst1q_f32(out, r);
+    }
+
+    inline void mul_m4m4(float const* a, float const* b, float* out) noexcept {
+        float32x4_t const a0 = vld1q_f32(a);
+        float32x4_t const a1 = vld1q_f32(a + 4);
+        float32x4_t const a2 = vld1q_f32(a + 8);
+        float32x4_t const a3 = vld1q_f32(a + 12);
+        for (size_t col = 0; col < 4; col++) {
+            float const* bc = b + col * 4;
+            float32x4_t r = vmulq_n_f32(a0, bc[0]);
+            r = madd(a1, vdupq_n_f32(bc[1]), r);
+            r = madd(a2, vdupq_n_f32(bc[2]), r);
+            r = madd(a3, vdupq_n_f32(bc[3]), r);
+            vst1q_f32(out + col * 4, r);
+        }
+    }
+
+#endif
+
+/*
+ * Native registers used by the SoA packets (see packet.h). Every operation is overloaded on
+ * the register type so that the same code works for float (no SIMD), 128-bit and 256-bit
+ * registers. register_traits<> gives the width and the memory accessors; it is found by
+ * overloading register_traits_of() rather than by specialization, because GCC drops the
+ * attributes of __m128 and co. when they are template arguments (and says so).
+ *
+ * Besides the arithmetic, a few primitives are used by the fast:: math kernels:
+ *  floor, round   round to an integral value (|a| < 2^31), round() to nearest
+ *  lt, select     a < b as a mask (bool for float), and mask ? a : b
+ *  rsqrt          1/sqrt(a) to about 22 bits, for positive normal a
+ *  exp2i          2^n for an integral n in [-127, 127], 2^-127 gives 0
+ *  exponent       unbiased exponent of a positive normal a, as a float
+ *  mantissa       significand of a positive normal a, in [1, 2)
+ *  sign_bits      sign bit of lane i in bit i, e.g. to build visibility masks
+ */
+
+struct float_register_traits {
+    static constexpr size_t WIDTH = 1;
+    static float load(float const* p) noexcept { return *p; }
+    static void store(float* p, float v) noexcept { *p = v; }
+    static float splat(float v) noexcept { return v; }
+};
+
+float_register_traits register_traits_of(float);
+
+inline float add(float a, float b) noexcept { return a + b; }
+inline float sub(float a, float b) noexcept { return a - b; }
+inline float mul(float a, float b) noexcept { return a * b; }
+inline float div(float a, float b) noexcept { return a / b; }
+inline float min(float a, float b) noexcept { return a < b ? a : b; }
+inline float max(float a, float b) noexcept { return a > b ? a : b; }
+inline float madd(float a, float b, float c) noexcept { return a * b + c; }
+inline float neg(float a) noexcept { return -a; }
+inline float abs(float a) noexcept { return std::abs(a); }
+inline float sqrt(float a) noexcept { return std::sqrt(a); }
+inline float floor(float a) noexcept { return std::floor(a); }
+inline float round(float a) noexcept { return std::nearbyint(a); }
+inline bool lt(float a, float b) noexcept { return a < b; }
+inline float select(bool m, float a, float b) noexcept { return m ? a : b; }
+inline float rsqrt(float a) noexcept { return 1.0f / std::sqrt(a); }
+
+inline float exp2i(float n) noexcept {
+    uint32_t const bits = uint32_t(int32_t(n) + 127) << 23;
+    float r;
+    memcpy(&r, &bits, sizeof(r));
+    return r;
+}
+
+inline float exponent(float a) noexcept {
+    uint32_t bits;
+    memcpy(&bits, &a, sizeof(bits));
+    return float(int32_t(bits >> 23) - 127);
+}
+
+inline float mantissa(float a) noexcept {
+    uint32_t bits;
+    memcpy(&bits, &a, sizeof(bits));
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+    memcpy(&a, &bits, sizeof(a));
+    return a;
+}
+
+inline uint32_t sign_bits(float a) noexcept { return std::signbit(a) ? 1u : 0u; }
+
+#if NUM_SIMD_SSE
+
+struct sse_register_traits {
+    static constexpr size_t WIDTH = 4;
+    static __m128 load(float const* p) noexcept { return _mm_loadu_ps(p); }
+    static void store(float* p, __m128 v) noexcept { _mm_storeu_ps(p, v); }
+    static __m128 splat(float v) noexcept { return _mm_set1_ps(v); }
+};
+
+sse_register_traits register_traits_of(__m128);
+
+inline __m128 add(__m128 a, __m128 b) noexcept { return _mm_add_ps(a, b); }
+inline __m128 sub(__m128 a, __m128 b) noexcept { return _mm_sub_ps(a, b); }
+inline __m128 mul(__m128 a, __m128 b) noexcept { return _mm_mul_ps(a, b); }
+inline __m128 div(__m128 a, __m128 b) noexcept { return _mm_div_ps(a, b); }
+inline __m128 min(__m128 a, __m128 b) noexcept { return _mm_min_ps(a, b); }
+inline __m128 max(__m128 a, __m128 b) noexcept { return _mm_max_ps(a, b); }
+inline __m128 neg(__m128 a) noexcept { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+inline __m128 abs(__m128 a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline __m128 sqrt(__m128 a) noexcept { return _mm_sqrt_ps(a); }
+inline __m128 lt(__m128 a, __m128 b) noexcept { return _mm_cmplt_ps(a, b); }
+inline uint32_t sign_bits(__m128 a) noexcept { return uint32_t(_mm_movemask_ps(a)); }
+
+#if NUM_SIMD_SSE41
+inline __m128 floor(__m128 a) noexcept { return _mm_floor_ps(a); }
+inline __m128 round(__m128 a) noexcept {
+    return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+inline __m128 select(__m128 m, __m128 a, __m128 b) noexcept { return _mm_blendv_ps(b, a, m); }
+#else
+inline __m128 floor(__m128 a) noexcept {
+    __m128 const t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+}
+inline __m128 round(__m128 a) noexcept { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+inline __m128 select(__m128 m, __m128 a, __m128 b) noexcept {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+#endif
+
+inline __m128 rsqrt(__m128 a) noexcept {
+    // 12-bit estimate and one newton-raphson step
+    __m128 const y = _mm_rsqrt_ps(a);
+    __m128 const h = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), a), y);
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(h, y)));
+}
+
+inline __m128 exp2i(__m128 n) noexcept {
+    __m128i const e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+}
+
+inline __m128 exponent(__m128 a) noexcept {
+    __m128i const e = _mm_srli_epi32(_mm_castps_si128(a), 23);
+    return _mm_cvtepi32_ps(_mm_sub_epi32(e, _mm_set1_epi32(127)));
+}
+
+inline __m128 mantissa(__m128 a) noexcept {
+    __m128 const m = _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x007fffff)));
+    return _mm_or_ps(m, _mm_set1_ps(1.0f));
+}
+
+#if NUM_SIMD_AVX
+struct avx_register_traits {
+    static constexpr size_t WIDTH = 8;
+    static __m256 load(float const* p) noexcept { return _mm256_loadu_ps(p); }
+    static void store(float* p, __m256 v) noexcept { _mm256_storeu_ps(p, v); }
+    static __m256 splat(float v) noexcept { return _mm256_set1_ps(v); }
+};
+
+avx_register_traits register_traits_of(__m256);
+
+inline __m256 add(__m256 a, __m256 b) noexcept { return _mm256_add_ps(a, b); }
+inline __m256 sub(__m256 a, __m256 b) noexcept { return _mm256_sub_ps(a, b); }
+inline __m256 mul(__m256 a, __m256 b) noexcept { return _mm256_mul_ps(a, b); }
+inline __m256 div(__m256 a, __m256 b) noexcept { return _mm256_div_ps(a, b); }
+inline __m256 min(__m256 a, __m256 b) noexcept { return _mm256_min_ps(a, b); }
+inline __m256 max(__m256 a, __m256 b) noexcept { return _mm256_max_ps(a, b); }
+inline __m256 neg(__m256 a) noexcept { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+inline __m256 abs(__m256 a) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+inline __m256 sqrt(__m256 a) noexcept { return _mm256_sqrt_ps(a); }
+inline __m256 floor(__m256 a) noexcept { return _mm256_floor_ps(a); }
+inline __m256 round(__m256 a) noexcept {
+    return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+inline __m256 lt(__m256 a, __m256 b) noexcept { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline __m256 select(__m256 m, __m256 a, __m256 b) noexcept { return _mm256_blendv_ps(b, a, m); }
+inline uint32_t sign_bits(__m256 a) noexcept { return uint32_t(_mm256_movemask_ps(a)); }
+
+inline __m256 rsqrt(__m256 a) noexcept {
+    __m256 const y = _mm256_rsqrt_ps(a);
+    __m256 const h = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), a), y);
+    return _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(h, y)));
+}
+
+inline __m256 mantissa(__m256 a) noexcept {
+    __m256 const m = _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff)));
+    return _mm256_or_ps(m, _mm256_set1_ps(1.0f));
+}
+
+#if NUM_SIMD_AVX2
+inline __m256 exp2i(__m256 n) noexcept {
+    __m256i const e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+}
+
+inline __m256 exponent(__m256 a) noexcept {
+    __m256i const e = _mm256_srli_epi32(_mm256_castps_si256(a), 23);
+    return _mm256_cvtepi32_ps(_mm256_sub_epi32(e, _mm256_set1_epi32(127)));
+}
+#else
+// no 256-bit integer operations, do each half with SSE
+inline __m256 exp2i(__m256 n) noexcept {
+    __m128 const lo = exp2i(_mm256_castps256_ps128(n));
+    __m128 const hi = exp2i(_mm256_extractf128_ps(n, 1));
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+inline __m256 exponent(__m256 a) noexcept {
+    __m128 const lo = exponent(_mm256_castps256_ps128(a));
+    __m128 const hi = exponent(_mm256_extractf128_ps(a, 1));
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+#endif
+#endif
+
+#elif NUM_SIMD_NEON
+
+struct neon_register_traits {
+    static constexpr size_t WIDTH = 4;
+    static float32x4_t load(float const* p) noexcept { return vld1q_f32(p); }
+    static void store(float* p, float32x4_t v) noexcept { vst1q_f32(p, v); }
+    static float32x4_t splat(float v) noexcept { return vdupq_n_f32(v); }
+};
+
+neon_register_traits register_traits_of(float32x4_t);
+
+inline float32x4_t add(float32x4_t a, float32x4_t b) noexcept { return vaddq_f32(a, b); }
+inline float32x4_t sub(float32x4_t a, float32x4_t b) noexcept { return vsubq_f32(a, b); }
+inline float32x4_t mul(float32x4_t a, float32x4_t b) noexcept { return vmulq_f32(a, b); }
+// a < b ? a : b like minps, vminq_f32 would return NaN when either input is
+inline float32x4_t min(float32x4_t a, float32x4_t b) noexcept {
+    return vbslq_f32(vcltq_f32(a, b), a, b);
+}
+inline float32x4_t max(float32x4_t a, float32x4_t b) noexcept {
+    return vbslq_f32(vcgtq_f32(a, b), a, b);
+}
+inline float32x4_t neg(float32x4_t a) noexcept { return vnegq_f32(a); }
+inline float32x4_t abs(float32x4_t a) noexcept { return vabsq_f32(a); }
+#if defined(__aarch64__)
+inline float32x4_t div(float32x4_t a, float32x4_t b) noexcept { return vdivq_f32(a, b); }
+inline float32x4_t sqrt(float32x4_t a) noexcept { return vsqrtq_f32(a); }
+#else
+inline float32x4_t div(float32x4_t a, float32x4_t b) noexcept {
+    // two newton-raphson steps are needed to be within 1 ulp or so of the real division
+    float32x4_t r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+inline float32x4_t sqrt(float32x4_t a) noexcept {
+    float32x4_t r = vrsqrteq_f32(a);
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+    // a * 1/sqrt(a), and 0 where a == 0
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vmulq_f32(a, r)),
+            vtstq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(a))));
+}
+#endif
+
+inline uint32x4_t lt(float32x4_t a, float32x4_t b) noexcept { return vcltq_f32(a, b); }
+inline float32x4_t select(uint32x4_t m, float32x4_t a, float32x4_t b) noexcept {
+    return vbslq_f32(m, a, b);
+}
+
+#if defined(__aarch64__)
+inline float32x4_t floor(float32x4_t a) noexcept { return vrndmq_f32(a); }
+inline float32x4_t round(float32x4_t a) noexcept { return vrndnq_f32(a); }
+#else
+inline float32x4_t floor(float32x4_t a) noexcept {
+    float32x4_t const t = vcvtq_f32_s32(vcvtq_s32_f32(a));
+    return vsubq_f32(t, select(vcgtq_f32(t, a), vdupq_n_f32(1.0f), vdupq_n_f32(0.0f)));
+}
+inline float32x4_t round(float32x4_t a) noexcept { return floor(vaddq_f32(a, vdupq_n_f32(0.5f))); }
+#endif
+
+inline float32x4_t rsqrt(float32x4_t a) noexcept {
+    // 8-bit estimate and two newton-raphson steps
+    float32x4_t r = vrsqrteq_f32(a);
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+    return vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+}
+
+inline float32x4_t exp2i(float32x4_t n) noexcept {
+    int32x4_t const e = vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127));
+    return vreinterpretq_f32_s32(vshlq_n_s32(e, 23));
+}
+
+inline float32x4_t exponent(float32x4_t a) noexcept {
+    int32x4_t const e = vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_f32(a), 23));
+    return vcvtq_f32_s32(vsubq_s32(e, vdupq_n_s32(127)));
+}
+
+inline float32x4_t mantissa(float32x4_t a) noexcept {
+    uint32x4_t const m = vandq_u32(vreinterpretq_u32_f32(a), vdupq_n_u32(0x007fffff));
+    return vreinterpretq_f32_u32(vorrq_u32(m, vdupq_n_u32(0x3f800000)));
+}
+
+inline uint32_t sign_bits(float32x4_t a) noexcept {
+    static const int32_t shift[4] = { 0, 1, 2, 3 };
+    uint32x4_t const b = vshlq_u32(vshrq_n_u32(vreinterpretq_u32_f32(a), 31), vld1q_s32(shift));
+#if defined(__aarch64__)
+    return vaddvq_u32(b);
+#else
+    uint32x2_t const h = vorr_u32(vget_low_u32(b), vget_high_u32(b));
+    return vget_lane_u32(h, 0) | vget_lane_u32(h, 1);
+#endif
+}
+
+#endif
+
+// width and memory accessors of the register type V
+template<typename V>
+using register_traits = decltype(register_traits_of(std::declval<V>()));
+
+// widest register that evenly divides a packet of N floats, and its traits
+template<size_t N, bool WIDE = N % 8 == 0>
+struct native_register {
+#if NUM_SIMD_SSE
+    typedef __m128 type;
+    typedef sse_register_traits traits;
+#elif NUM_SIMD_NEON
+    typedef float32x4_t type;
+    typedef neon_register_traits traits;
+#else
+    typedef float type;
+    typedef float_register_traits traits;
+#endif
+};
+
+#if NUM_SIMD_AVX
+template<size_t N>
+struct native_register<N, true> {
+    typedef __m256 type;
+    typedef avx_register_traits traits;
+};
+#endif
+
+} // namespace simd
+} // namespace details
+} // namespace numeric
+
+#endif
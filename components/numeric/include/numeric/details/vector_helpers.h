@@ -22,6 +22,56 @@
 namespace numeric {
 namespace details {
 
+/*
+ * Element-wise kernels behind the operators taking two vectors of the same type. They loop
+ * over the elements, vec4.h specializes VectorKernels to use SIMD registers for float4 and
+ * int4. The mixed-type operators always use the loops.
+ */
+template<typename V>
+class VectorLoops {
+public:
+    static constexpr void add(V& lhs, const V& rhs) {
+        for (size_t i = 0; i < lhs.size(); i++) {
+            lhs[i] += rhs[i];
+        }
+    }
+    static constexpr void sub(V& lhs, const V& rhs) {
+        for (size_t i = 0; i < lhs.size(); i++) {
+            lhs[i] -= rhs[i];
+        }
+    }
+    static constexpr void mul(V& lhs, const V& rhs) {
+        for (size_t i = 0; i < lhs.size(); i++) {
+            lhs[i] *= rhs[i];
+        }
+    }
+    static constexpr void div(V& lhs, const V& rhs) {
+        for (size_t i = 0; i < lhs.size(); i++) {
+            lhs[i] /= rhs[i];
+        }
+    }
+    static constexpr void neg(V& v) {
+        for (size_t i = 0; i < v.size(); i++) {
+            v[i] = -v[i];
+        }
+    }
+    // v = min(u, v) and v = max(u, v), with the semantics of std::min and std::max
+    static constexpr void min(V& v, const V& u) {
+        for (size_t i = 0; i < v.size(); i++) {
+            v[i] = std::min(u[i], v[i]);
+        }
+    }
+    static constexpr void max(V& v, const V& u) {
+        for (size_t i = 0; i < v.size(); i++) {
+            v[i] = std::max(u[i], v[i]);
+        }
+    }
+};
+
+template<typename V>
+class VectorKernels : public VectorLoops<V> {
+};
+
 /*
  * VectorAddOperators implements basic arithmetic and basic compound assignments operators.
  * Child class only needs to implement operator[] and size().
@@ -54,18 +104,14 @@ public:
     VECTOR<T>&
     operator+=(const VECTOR<T>& v) {
         VECTOR<T>& lhs = static_cast<VECTOR<T>&>(*this);
-        for (size_t i = 0; i < lhs.size(); i++) {
-            lhs[i] += v[i];
-        }
+        VectorKernels<VECTOR<T>>::add(lhs, v);
         return lhs;
     }
     constexpr 
     VECTOR<T>& 
     operator-=(const VECTOR<T>& v) {
         VECTOR<T>& lhs = static_cast<VECTOR<T>&>(*this);
-        for (size_t i = 0; i < lhs.size(); i++) {
-            lhs[i] -= v[i];
-        }
+        VectorKernels<VECTOR<T>>::sub(lhs, v);
         return lhs;
     }
 
@@ -125,18 +171,14 @@ public:
     VECTOR<T>& 
     operator*=(const VECTOR<T>& v) {
         VECTOR<T>& lhs = static_cast<VECTOR<T>&>(*this);
-        for (size_t i = 0; i < lhs.size(); i++) {
-            lhs[i] *= v[i];
-        }
+        VectorKernels<VECTOR<T>>::mul(lhs, v);
         return lhs;
     }
     constexpr 
     VECTOR<T>& 
     operator/=(const VECTOR<T>& v) {
         VECTOR<T>& lhs = static_cast<VECTOR<T>&>(*this);
-        for (size_t i = 0; i < lhs.size(); i++) {
-            lhs[i] /= v[i];
-        }
+        VectorKernels<VECTOR<T>>::div(lhs, v);
         return lhs;
     }
 
@@ -177,11 +219,8 @@ class VectorUnaryOperators {
 public:
     VECTOR<T> 
     operator-() const {
-        VECTOR<T> r;
-        VECTOR<T> const& rv(static_cast<VECTOR<T> const&>(*this));
-        for (size_t i = 0; i < r.size(); i++) {
-            r[i] = -rv[i];
-        }
+        VECTOR<T> r(static_cast<VECTOR<T> const&>(*this));
+        VectorKernels<VECTOR<T>>::neg(r);
         return r;
     }
 };
@@ -483,18 +522,14 @@ public:
     friend inline NUM_PURE
     VECTOR<T>  
     min(const VECTOR<T>& u, VECTOR<T> v) {
-        for (size_t i = 0; i < v.size(); i++) {
-            v[i] = std::min(u[i], v[i]);
-        }
+        VectorKernels<VECTOR<T>>::min(v, u);
         return v;
     }
 
     friend inline NUM_PURE
     VECTOR<T>  
     max(const VECTOR<T>& u, VECTOR<T> v) {
-        for (size_t i = 0; i < v.size(); i++) {
-            v[i] = std::max(u[i], v[i]);
-        }
+        VectorKernels<VECTOR<T>>::max(v, u);
         return v;
     }
 
@@ -0,0 +1,129 @@
+#ifndef CHROMA_NUMERIC_DUALQUAT_H
+#define CHROMA_NUMERIC_DUALQUAT_H
+
+#include "mat3.h"
+#include "mat4.h"
+#include "quat.h"
+#include "vec3.h"
+#include "details/compiler.h"
+
+#include <stddef.h>
+
+namespace numeric {
+namespace details {
+
+/*
+ * Unit dual quaternion q = real + e dual, a rigid transform: the rotation real followed by
+ * the translation t, with dual = (t, 0) * real / 2. Blending dual quaternions instead of
+ * matrices doesn't shrink the skin around twisted joints (Kavan et al., Geometric Skinning
+ * with Approximate Dual Quaternion Blending, 2008), and takes 32 bytes instead of 48 per
+ * joint.
+ *
+ * Like the matrices, a * b applies b first.
+ */
+template<typename T>
+class DualQuaternion {
+public:
+    typedef T value_type;
+
+    Quaternion<T> real;
+    Quaternion<T> dual;
+
+    // identity
+    constexpr DualQuaternion() : real(T(1)), dual(T(0)) {}
+
+    constexpr DualQuaternion(const Quaternion<T>& real, const Quaternion<T>& dual)
+            : real(real), dual(dual) {}
+
+    // the rotation q (a unit quaternion) followed by the translation t
+    constexpr DualQuaternion(const Quaternion<T>& q, const Vector3<T>& t)
+            : real(q), dual(Quaternion<T>(t, T(0)) * q * T(0.5)) {}
+
+    // m must be a rigid transform, rotation and translation only
+    explicit DualQuaternion(const Matrix44<T>& m)
+            : DualQuaternion(normalize(m.upper_left().to_quaternion()), m[3].xyz) {}
+
+    static constexpr DualQuaternion translation(const Vector3<T>& t) {
+        return DualQuaternion(Quaternion<T>(T(1)), t);
+    }
+
+    constexpr Quaternion<T> rotation() const { return real; }
+
+    constexpr Vector3<T> translation() const {
+        return (dual * conj(real)).xyz * T(2);
+    }
+
+    Matrix44<T> to_matrix() const {
+        return Matrix44<T>(Matrix33<T>(real), translation());
+    }
+
+    friend inline constexpr NUM_PURE
+    DualQuaternion operator*(const DualQuaternion& a, const DualQuaternion& b) {
+        return DualQuaternion(a.real * b.real, a.real * b.dual + a.dual * b.real);
+    }
+
+    friend inline constexpr NUM_PURE
+    DualQuaternion operator+(const DualQuaternion& a, const DualQuaternion& b) {
+        return DualQuaternion(a.real + b.real, a.dual + b.dual);
+    }
+
+    friend inline constexpr NUM_PURE
+    DualQuaternion operator*(const DualQuaternion& a, T s) {
+        return DualQuaternion(a.real * s, a.dual * s);
+    }
+
+    // the inverse of a unit dual quaternion
+    friend inline constexpr NUM_PURE
+    DualQuaternion conj(const DualQuaternion& a) {
+        return DualQuaternion(conj(a.real), conj(a.dual));
+    }
+
+    /*
+     * Closest unit dual quaternion: real is normalized and the part of dual along real, which
+     * isn't a rigid transform, is removed.
+     */
+    friend inline NUM_PURE
+    DualQuaternion normalize(const DualQuaternion& a) {
+        T const n = T(1) / length(a.real);
+        Quaternion<T> const r = a.real * n;
+        Quaternion<T> const d = a.dual * n;
+        return DualQuaternion(r, d - r * dot(r, d));
+    }
+
+    // the point p transformed by a unit dual quaternion
+    friend inline constexpr NUM_PURE
+    Vector3<T> transform_point(const DualQuaternion& a, const Vector3<T>& p) {
+        return a.real * p + a.translation();
+    }
+
+    // the direction or normal n transformed by a unit dual quaternion, the rotation only
+    friend inline constexpr NUM_PURE
+    Vector3<T> transform_normal(const DualQuaternion& a, const Vector3<T>& n) {
+        return a.real * n;
+    }
+};
+
+} // namespace details
+
+typedef details::DualQuaternion<double> dualquat;
+typedef details::DualQuaternion<float> dualquatf;
+
+/*
+ * Dual quaternion linear blending of count transforms, normalize(sum(w[i] * q[i])). Each q[i]
+ * is first flipped to the same hemisphere as q[0], as q and -q are the same transform.
+ */
+template<typename T>
+inline NUM_PURE
+details::DualQuaternion<T>
+blend(details::DualQuaternion<T> const* q, T const* w, size_t count) noexcept {
+    details::DualQuaternion<T> r(q[0].real * w[0], q[0].dual * w[0]);
+    for (size_t i = 1; i < count; i++) {
+        T const s = dot(q[0].real, q[i].real) < 0 ? -w[i] : w[i];
+        r = r + q[i] * s;
+    }
+    return normalize(r);
+}
+
+} // namespace numeric
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef CHROMA_NUMERIC_FRUSTUM_H
+#define CHROMA_NUMERIC_FRUSTUM_H
+
+#include "batch.h"
+#include "bounds.h"
+#include "mat4.h"
+#include "packet.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "details/compiler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace numeric {
+
+/*
+ * The 6 planes of a view frustum, extracted from a projection (or view-projection) matrix
+ * with the OpenGL clip space convention used by mat4f::frustum() and friends, -w <= z <= w.
+ *
+ * Each plane is { n, d } with n pointing inside and normalized, so that dot(n, p) + d is the
+ * signed distance of p to the plane. The planes are in the order left, right, bottom, top,
+ * near, far.
+ */
+class Frustum {
+public:
+    static constexpr size_t PLANE_COUNT = 6;
+
+    Frustum() = default;
+
+    explicit Frustum(const mat4f& pv) noexcept {
+        set_projection(pv);
+    }
+
+    void set_projection(const mat4f& pv) noexcept {
+        float4 r[4];
+        for (size_t i = 0; i < 4; i++) {
+            r[i] = float4(pv[0][i], pv[1][i], pv[2][i], pv[3][i]);
+        }
+        m_planes[0] = r[3] + r[0];
+        m_planes[1] = r[3] - r[0];
+        m_planes[2] = r[3] + r[1];
+        m_planes[3] = r[3] - r[1];
+        m_planes[4] = r[3] + r[2];
+        m_planes[5] = r[3] - r[2];
+        for (float4& p : m_planes) {
+            p /= length(p.xyz);
+        }
+    }
+
+    float4 const& plane(size_t i) const noexcept { return m_planes[i]; }
+    float4 const* planes() const noexcept { return m_planes; }
+
+    // false when the volume is entirely on the outer side of one of the planes
+    bool intersects(const Sphere& s) const noexcept {
+        for (float4 const& p : m_planes) {
+            if (distance(p, s.center) + s.radius < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool intersects(const Aabb& b) const noexcept {
+        float3 const c = b.center();
+        float3 const e = b.extent();
+        for (float4 const& p : m_planes) {
+            // summed in the same order as the batch version, which fuses the multiply-adds
+            float const d = std::abs(p.x) * e.x +
+                    (std::abs(p.y) * e.y + (std::abs(p.z) * e.z + distance(p, c)));
+            if (d < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static float distance(const float4& p, const float3& c) noexcept {
+        return p.x * c.x + (p.y * c.y + (p.z * c.z + p.w));
+    }
+
+    float4 m_planes[PLANE_COUNT];
+};
+
+namespace details {
+namespace batch {
+
+    // the frustum planes splatted once, outside of the culling loops
+    struct frustum_planes {
+        packet n[Frustum::PLANE_COUNT][4];
+
+        explicit frustum_planes(const Frustum& f) noexcept {
+            for (size_t i = 0; i < Frustum::PLANE_COUNT; i++) {
+                for (size_t c = 0; c < 4; c++) {
+                    n[i][c] = packet(f.plane(i)[c]);
+                }
+            }
+        }
+
+        NUM_ALWAYS_INLINE packet distance(size_t i, packet3 const& c) const noexcept {
+            return madd(n[i][0], c.x, madd(n[i][1], c.y, madd(n[i][2], c.z, n[i][3])));
+        }
+
+        // smallest signed distance of the spheres to the planes, negative when culled
+        NUM_ALWAYS_INLINE packet spheres(packet3 const& c, packet const& r) const noexcept {
+            packet d = distance(0, c);
+            for (size_t i = 1; i < Frustum::PLANE_COUNT; i++) {
+                d = min(d, distance(i, c));
+            }
+            return d + r;
+        }
+
+        // same for boxes, the extent projected on the normal plays the part of the radius
+        NUM_ALWAYS_INLINE packet boxes(packet3 const& c, packet3 const& e) const noexcept {
+            packet d = madd(abs(n[0][0]), e.x,
+                    madd(abs(n[0][1]), e.y, madd(abs(n[0][2]), e.z, distance(0, c))));
+            for (size_t i = 1; i < Frustum::PLANE_COUNT; i++) {
+                d = min(d, madd(abs(n[i][0]), e.x,
+                        madd(abs(n[i][1]), e.y, madd(abs(n[i][2]), e.z, distance(i, c)))));
+            }
+            return d;
+        }
+    };
+
+    /*
+     * Sets the bits of the lanes where d is not negative. d < 0 is tested explicitly rather
+     * than taking the sign bits of d, so that -0 and nan count as visible like in the scalar
+     * test. Packets never straddle two mask words since their size divides 32.
+     */
+    inline NUM_ALWAYS_INLINE void store_visible(uint32_t* mask, size_t offset, packet const& d,
+            size_t count) noexcept {
+        static_assert(32 % packet::SIZE == 0, "packets must not straddle mask words");
+        uint32_t const lanes = (uint32_t(1) << count) - 1u;
+        uint32_t const culled = sign_bits(select_lt(d, packet(0.0f), packet(-1.0f), packet(1.0f)));
+        mask[offset / 32] |= (~culled & lanes) << (offset % 32);
+    }
+
+    inline void clear_mask(uint32_t* mask, size_t count) noexcept {
+        memset(mask, 0, ((count + 31) / 32) * sizeof(uint32_t));
+    }
+
+    inline packet3 load_centers(Aabb const* in, size_t count) noexcept {
+        packet3 r(packet(0.0f), packet(0.0f), packet(0.0f));
+        for (size_t i = 0; i < count; i++) {
+            float3 const c = in[i].center();
+            r.x[i] = c.x;
+            r.y[i] = c.y;
+            r.z[i] = c.z;
+        }
+        return r;
+    }
+
+    inline packet3 load_extents(Aabb const* in, size_t count) noexcept {
+        packet3 r(packet(0.0f), packet(0.0f), packet(0.0f));
+        for (size_t i = 0; i < count; i++) {
+            float3 const e = in[i].extent();
+            r.x[i] = e.x;
+            r.y[i] = e.y;
+            r.z[i] = e.z;
+        }
+        return r;
+    }
+
+} // namespace batch
+} // namespace details
+
+/*
+ * Frustum culling of count volumes, NATIVE_PACKET_SIZE at a time. Bit i % 32 of
+ * out_mask[i / 32] is set when volume i intersects the frustum, out_mask must hold
+ * (count + 31) / 32 words and the bits past count are cleared. The test is the one of
+ * Frustum::intersects(), but the distances are computed with fused multiply-adds where the
+ * target has them, so a volume within an ulp or so of a plane can be classified differently. The mask can be used directly to compact the visible elements, e.g. by
+ * iterating the set bits of each word.
+ *
+ * The spheres are given as count centers and count radii, either as float3 or as the x, y and
+ * z streams centers[0], centers[1] and centers[2] (the fastest form).
+ */
+inline void
+cull_spheres(const Frustum& frustum, float3 const* centers, float const* radii, size_t count,
+        uint32_t* out_mask) noexcept {
+    using namespace details::batch;
+    frustum_planes const planes(frustum);
+    clear_mask(out_mask, count);
+    for (size_t i = 0; i < count; i += packet::SIZE) {
+        size_t const n = std::min(packet::SIZE, count - i);
+        store_visible(out_mask, i, planes.spheres(load(centers + i, n), load(radii, i, n)), n);
+    }
+}
+
+inline void
+cull_spheres(const Frustum& frustum, float const* const centers[3], float const* radii,
+        size_t count, uint32_t* out_mask) noexcept {
+    using namespace details::batch;
+    frustum_planes const planes(frustum);
+    clear_mask(out_mask, count);
+    for (size_t i = 0; i < count; i += packet::SIZE) {
+        size_t const n = std::min(packet::SIZE, count - i);
+        store_visible(out_mask, i, planes.spheres(load(centers, i, n), load(radii, i, n)), n);
+    }
+}
+
+inline void
+cull_aabbs(const Frustum& frustum, Aabb const* boxes, size_t count, uint32_t* out_mask) noexcept {
+    using namespace details::batch;
+    frustum_planes const planes(frustum);
+    clear_mask(out_mask, count);
+    for (size_t i = 0; i < count; i += packet::SIZE) {
+        size_t const n = std::min(packet::SIZE, count - i);
+        store_visible(out_mask, i,
+                planes.boxes(load_centers(boxes + i, n), load_extents(boxes + i, n)), n);
+    }
+}
+
+} // namespace numeric
+
+#endif
@@ -1,10 +1,13 @@
 #ifndef CHROMA_NUMERIC_HALF_H
 #define CHROMA_NUMERIC_HALF_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include <limits>
 #include <type_traits>
 #include "details/compiler.h"
+#include "details/simd.h"
 
 namespace numeric {
 
@@ -133,6 +136,182 @@ inline constexpr numeric::half operator"" _h(long double v) {
     return numeric::half(static_cast<float>(v));
 }
 
+namespace details {
+namespace half_convert {
+
+/*
+ * Portable array conversions. These implement exactly the same bit manipulations as
+ * half::ftoh() and half::htof() (SSE2 when available), so they give bit-identical results.
+ */
+#if NUM_SIMD_SSE
+
+    inline __m128i select(__m128i mask, __m128i a, __m128i b) noexcept {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    // 4 floats to 4 halves, in the low 16 bits of each 32-bit lane
+    inline __m128i ftoh(__m128 f) noexcept {
+        __m128i const in = _mm_castps_si128(f);
+        __m128i const sign = _mm_and_si128(in, _mm_set1_epi32(int32_t(0x80000000u)));
+        __m128i const a = _mm_xor_si128(in, sign);
+        __m128i const infnan = _mm_cmpgt_epi32(a, _mm_set1_epi32(0x7F7FFFFF));
+        __m128i const nan = _mm_cmpgt_epi32(a, _mm_set1_epi32(0x7F800000));
+        __m128i const infinity = _mm_set1_epi32(31 << 23);
+        __m128 const magic = _mm_castsi128_ps(_mm_set1_epi32(15 << 23));
+
+        __m128i t = _mm_and_si128(a, _mm_set1_epi32(~0xFFF));
+        t = _mm_castps_si128(_mm_mul_ps(_mm_castsi128_ps(t), magic));
+        t = _mm_add_epi32(t, _mm_set1_epi32(0x1000));
+        t = select(_mm_cmpgt_epi32(t, infinity), infinity, t);
+        t = _mm_srli_epi32(t, 13);
+        t = select(infnan,
+                _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(nan, _mm_set1_epi32(0x200))), t);
+        return _mm_or_si128(t, _mm_srli_epi32(sign, 16));
+    }
+
+    // 4 halves, in the low 16 bits of each 32-bit lane, to 4 floats
+    inline __m128 htof(__m128i h) noexcept {
+        __m128 const magic = _mm_castsi128_ps(_mm_set1_epi32((0xFE - 0xF) << 23));
+        __m128 const infnan = _mm_castsi128_ps(_mm_set1_epi32(0x8F << 23));
+        __m128i const o = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13);
+        __m128 f = _mm_mul_ps(_mm_castsi128_ps(o), magic);
+        f = _mm_or_ps(f, _mm_and_ps(_mm_cmpge_ps(f, infnan),
+                _mm_castsi128_ps(_mm_set1_epi32(0xFF << 23))));
+        return _mm_or_ps(f, _mm_castsi128_ps(
+                _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16)));
+    }
+
+    inline void f32_to_f16(float const* in, uint16_t* out, size_t count) noexcept {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            // sign-extend the 16-bit results so that packs doesn't saturate them
+            __m128i const lo = _mm_srai_epi32(_mm_slli_epi32(ftoh(_mm_loadu_ps(in + i)), 16), 16);
+            __m128i const hi = _mm_srai_epi32(_mm_slli_epi32(ftoh(_mm_loadu_ps(in + i + 4)), 16), 16);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(lo, hi));
+        }
+        for (; i < count; i++) {
+            out[i] = uint16_t(_mm_cvtsi128_si32(ftoh(_mm_set_ss(in[i]))));
+        }
+    }
+
+    inline void f16_to_f32(uint16_t const* in, float* out, size_t count) noexcept {
+        // a block bound of i + 8 <= count makes GCC warn about the tail overflowing
+        size_t const blocks = count & ~size_t(7);
+        size_t i = 0;
+        __m128i const zero = _mm_setzero_si128();
+        for (; i < blocks; i += 8) {
+            __m128i const h = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+            _mm_storeu_ps(out + i,     htof(_mm_unpacklo_epi16(h, zero)));
+            _mm_storeu_ps(out + i + 4, htof(_mm_unpackhi_epi16(h, zero)));
+        }
+        for (; i < count; i++) {
+            out[i] = _mm_cvtss_f32(htof(_mm_cvtsi32_si128(in[i])));
+        }
+    }
+
+#else
+
+    inline void f32_to_f16(float const* in, uint16_t* out, size_t count) noexcept {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = getbits(half(in[i]));
+        }
+    }
+
+    inline void f16_to_f32(uint16_t const* in, float* out, size_t count) noexcept {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = float(makehalf(in[i]));
+        }
+    }
+
+#endif
+
+} // namespace half_convert
+} // namespace details
+
+/*
+ * Converts count floats to halves.
+ *
+ * With F16C (x86), AVX-512F or NEON (aarch64) the hardware conversion is used, it rounds to
+ * nearest-even and can therefore differ by one ulp from half(float), which rounds ties away
+ * from zero, on exact ties. NaN payloads are preserved by the hardware. Otherwise the result
+ * is bit-identical to half(float).
+ */
+inline void
+convert_f32_to_f16(float const* in, half* out, size_t count) noexcept {
+    uint16_t* const dst = reinterpret_cast<uint16_t*>(out);
+#if NUM_SIMD_F16C
+    size_t i = 0;
+#if NUM_SIMD_AVX512
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                _mm512_cvtps_ph(_mm512_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+#endif
+    for (; i + 4 <= count; i += 4) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i),
+                _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+    if (i < count) {
+        // the tail goes through the same instruction so that rounding is consistent
+        float tmp[4] = {};
+        uint16_t h[8];
+        memcpy(tmp, in + i, (count - i) * sizeof(float));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(h),
+                _mm_cvtps_ph(_mm_loadu_ps(tmp), _MM_FROUND_TO_NEAREST_INT));
+        memcpy(dst + i, h, (count - i) * sizeof(uint16_t));
+    }
+#elif NUM_SIMD_NEON && defined(__aarch64__)
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+    }
+    if (i < count) {
+        // the tail goes through the same instruction so that rounding is consistent
+        float tmp[4] = {};
+        uint16_t h[4];
+        memcpy(tmp, in + i, (count - i) * sizeof(float));
+        vst1_u16(h, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(tmp))));
+        memcpy(dst + i, h, (count - i) * sizeof(uint16_t));
+    }
+#else
+    details::half_convert::f32_to_f16(in, dst, count);
+#endif
+}
+
+/*
+ * Converts count halves to floats. This conversion is exact and identical on all paths.
+ */
+inline void
+convert_f16_to_f32(half const* in, float* out, size_t count) noexcept {
+    uint16_t const* const src = reinterpret_cast<uint16_t const*>(in);
+#if NUM_SIMD_F16C
+    size_t i = 0;
+#if NUM_SIMD_AVX512
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(out + i,
+                _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i))));
+    }
+#endif
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i,
+                _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + i))));
+    }
+    for (; i < count; i++) {
+        out[i] = _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(src[i])));
+    }
+#elif NUM_SIMD_NEON && defined(__aarch64__)
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    }
+    for (; i < count; i++) {
+        out[i] = float(in[i]);
+    }
+#else
+    details::half_convert::f16_to_f32(src, out, count);
+#endif
+}
+
 } // namespace numeric
 
 namespace std {
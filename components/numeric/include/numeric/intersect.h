@@ -0,0 +1,239 @@
+#ifndef CHROMA_NUMERIC_INTERSECT_H
+#define CHROMA_NUMERIC_INTERSECT_H
+
+#include "bounds.h"
+#include "packet.h"
+#include "vec3.h"
+#include "details/compiler.h"
+
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace numeric {
+
+/*
+ * The points origin + t * direction for t in [t_min, t_max]. The direction doesn't need to be
+ * normalized, t is in units of its length.
+ */
+struct Ray {
+    float3 origin;
+    float3 direction;
+    float t_min = 0.0f;
+    float t_max = std::numeric_limits<float>::infinity();
+};
+
+namespace details {
+
+// N rays in structure-of-arrays form, the lanes of each member belong to the same ray
+template<size_t N>
+struct RayPacket {
+    Vector3<Packet<N>> origin;
+    Vector3<Packet<N>> direction;
+    Packet<N> t_min = Packet<N>(0.0f);
+    Packet<N> t_max = Packet<N>(std::numeric_limits<float>::infinity());
+};
+
+/*
+ * The tests are written once for S = float and S = Packet<N>. Each one returns a value that
+ * is negative for a miss; the comparisons are arranged so that the NaNs coming from
+ * degenerate cases (0 * inf in the slabs, a flat triangle) end up as misses, the
+ * operations below having the semantic of minps/maxps: the 2nd operand is returned when one
+ * is NaN.
+ */
+namespace intersect {
+
+    inline float min(float a, float b) noexcept { return a < b ? a : b; }
+    inline float max(float a, float b) noexcept { return a > b ? a : b; }
+    inline float abs(float a) noexcept { return std::abs(a); }
+    inline float sqrt(float a) noexcept { return std::sqrt(a); }
+    inline float madd(float a, float b, float c) noexcept { return a * b + c; }
+    inline float select_lt(float a, float b, float x, float y) noexcept { return a < b ? x : y; }
+
+    inline bool hits(float m) noexcept { return !(m < 0.0f); }
+
+    template<size_t N>
+    inline uint32_t hits(const Packet<N>& m) noexcept {
+        static_assert(N < 32, "at most 31 lanes");
+        return ~sign_bits(select_lt(m, Packet<N>(0.0f), Packet<N>(-1.0f), Packet<N>(1.0f))) &
+                ((uint32_t(1) << N) - 1u);
+    }
+
+    template<typename S>
+    inline NUM_ALWAYS_INLINE Vector3<S> scale(const Vector3<S>& v, const S& s) noexcept {
+        return Vector3<S>(v.x * s, v.y * s, v.z * s);
+    }
+
+    template<typename S>
+    inline NUM_ALWAYS_INLINE Vector3<S> splat(const float3& v) noexcept {
+        return Vector3<S>(S(v.x), S(v.y), S(v.z));
+    }
+
+    // slab test, t is where the ray enters the box (t_min when it starts inside)
+    template<typename S>
+    inline NUM_ALWAYS_INLINE S aabb(const Vector3<S>& origin, const Vector3<S>& inv_direction,
+            const S& t_min, const S& t_max, const Vector3<S>& box_min, const Vector3<S>& box_max,
+            S& t) noexcept {
+        Vector3<S> const t0 = (box_min - origin) * inv_direction;
+        Vector3<S> const t1 = (box_max - origin) * inv_direction;
+        S const near = max(max(min(t0.x, t1.x), min(t0.y, t1.y)), max(min(t0.z, t1.z), t_min));
+        S const far = min(min(max(t0.x, t1.x), max(t0.y, t1.y)), min(max(t0.z, t1.z), t_max));
+        t = near;
+        return far - near;
+    }
+
+    /*
+     * Closest intersection in [t_min, t_max], with the discriminant computed from the distance
+     * of the center to the line rather than b^2 - ac, which loses all precision for small
+     * spheres far away (Haines et al., Precision Improvements for Ray/Sphere Intersection,
+     * Ray Tracing Gems 2019).
+     */
+    template<typename S>
+    inline NUM_ALWAYS_INLINE S sphere(const Vector3<S>& origin, const Vector3<S>& direction,
+            const S& t_min, const S& t_max, const Vector3<S>& center, const S& radius,
+            S& t) noexcept {
+        Vector3<S> const oc = origin - center;
+        S const a = dot(direction, direction);
+        S const b = dot(oc, direction);
+        S const r2 = radius * radius;
+        Vector3<S> const f = oc - scale(direction, b / a);
+        S const disc = max(r2 - dot(f, f), S(-1.0f));
+        // q = -b - sign(b) sqrt(a disc), the roots are c / q and q / a
+        S const s = sqrt(a * max(disc, S(0.0f)));
+        S const q = select_lt(b, S(0.0f), s - b, S(0.0f) - s - b);
+        S const t0 = (dot(oc, oc) - r2) / q;
+        S const t1 = q / a;
+        S const near = min(t0, t1);
+        S const far = max(t0, t1);
+        t = max(select_lt(near, t_min, far, near), S(-1.0f) - abs(t_min));
+        // t_max - t can be inf - inf, NaN in the 1st operand is dropped
+        return min(min(t - t_min, t_max - t), disc);
+    }
+
+    /*
+     * Moller-Trumbore, both faces. u and v are the barycentric coordinates of b and c. The
+     * edges are included: a ray through an edge shared by two triangles hits at least one of
+     * them, up to the rounding of the barycentrics.
+     */
+    template<typename S>
+    inline NUM_ALWAYS_INLINE S triangle(const Vector3<S>& origin, const Vector3<S>& direction,
+            const S& t_min, const S& t_max, const Vector3<S>& a, const Vector3<S>& b,
+            const Vector3<S>& c, S& t, S& u, S& v) noexcept {
+        Vector3<S> const e1 = b - a;
+        Vector3<S> const e2 = c - a;
+        Vector3<S> const p = cross(direction, e2);
+        S const inv_det = S(1.0f) / dot(e1, p);
+        Vector3<S> const s = origin - a;
+        Vector3<S> const q = cross(s, e1);
+        // a zero determinant gives NaN or infinities, max() turns the NaNs into misses
+        u = max(dot(s, p) * inv_det, S(-1.0f));
+        v = max(dot(direction, q) * inv_det, S(-1.0f));
+        t = max(dot(e2, q) * inv_det, S(-1.0f) - abs(t_min));
+        return min(min(t - t_min, t_max - t), min(min(u, v), S(1.0f) - u - v));
+    }
+
+} // namespace intersect
+} // namespace details
+
+typedef details::RayPacket<4> rayx4;
+typedef details::RayPacket<8> rayx8;
+
+/*
+ * Ray intersection tests, true (or the bit of the lane set) when the ray hits within
+ * [t_min, t_max]. t is then the distance of the hit along the ray, for the boxes where the ray
+ * enters it (t_min if it starts inside), for the spheres the closest hit past t_min. Triangles
+ * are hit from both sides and also give the barycentric coordinates u and v of the hit.
+ *
+ * Each test has a scalar version and two packet versions which give a mask of the lanes that
+ * hit:
+ *  - one ray against N primitives in structure-of-arrays form, e.g. the children of a BVH node
+ *  - N rays (rayx4, rayx8) against one primitive
+ *
+ * The packet versions run the same code as the scalar one. A ray that runs exactly in the
+ * plane of a face of a box may or may not hit it.
+ */
+inline bool
+intersect(const Ray& ray, const Aabb& box, float& t) noexcept {
+    using namespace details::intersect;
+    return hits(aabb(ray.origin, 1.0f / ray.direction, ray.t_min, ray.t_max, box.min, box.max, t));
+}
+
+template<size_t N>
+inline uint32_t
+intersect(const Ray& ray, const details::Vector3<details::Packet<N>>& box_min,
+        const details::Vector3<details::Packet<N>>& box_max, details::Packet<N>& t) noexcept {
+    using namespace details::intersect;
+    typedef details::Packet<N> S;
+    return hits(aabb(splat<S>(ray.origin), splat<S>(1.0f / ray.direction), S(ray.t_min),
+            S(ray.t_max), box_min, box_max, t));
+}
+
+template<size_t N>
+inline uint32_t
+intersect(const details::RayPacket<N>& rays, const Aabb& box, details::Packet<N>& t) noexcept {
+    using namespace details::intersect;
+    typedef details::Packet<N> S;
+    details::Vector3<S> const inv(S(1.0f) / rays.direction.x, S(1.0f) / rays.direction.y,
+            S(1.0f) / rays.direction.z);
+    return hits(aabb(rays.origin, inv, rays.t_min, rays.t_max, splat<S>(box.min),
+            splat<S>(box.max), t));
+}
+
+inline bool
+intersect(const Ray& ray, const Sphere& sphere, float& t) noexcept {
+    using namespace details::intersect;
+    return hits(details::intersect::sphere(ray.origin, ray.direction, ray.t_min, ray.t_max,
+            sphere.center, sphere.radius, t));
+}
+
+template<size_t N>
+inline uint32_t
+intersect(const Ray& ray, const details::Vector3<details::Packet<N>>& centers,
+        const details::Packet<N>& radii, details::Packet<N>& t) noexcept {
+    using namespace details::intersect;
+    typedef details::Packet<N> S;
+    return hits(sphere(splat<S>(ray.origin), splat<S>(ray.direction), S(ray.t_min),
+            S(ray.t_max), centers, radii, t));
+}
+
+template<size_t N>
+inline uint32_t
+intersect(const details::RayPacket<N>& rays, const Sphere& s, details::Packet<N>& t) noexcept {
+    using namespace details::intersect;
+    typedef details::Packet<N> S;
+    return hits(sphere(rays.origin, rays.direction, rays.t_min, rays.t_max,
+            splat<S>(s.center), S(s.radius), t));
+}
+
+inline bool
+intersect(const Ray& ray, const float3& a, const float3& b, const float3& c, float& t, float& u,
+        float& v) noexcept {
+    using namespace details::intersect;
+    return hits(triangle(ray.origin, ray.direction, ray.t_min, ray.t_max, a, b, c, t, u, v));
+}
+
+template<size_t N>
+inline uint32_t
+intersect(const Ray& ray, const details::Vector3<details::Packet<N>>& a,
+        const details::Vector3<details::Packet<N>>& b,
+        const details::Vector3<details::Packet<N>>& c,
+        details::Packet<N>& t, details::Packet<N>& u, details::Packet<N>& v) noexcept {
+    using namespace details::intersect;
+    typedef details::Packet<N> S;
+    return hits(triangle(splat<S>(ray.origin), splat<S>(ray.direction), S(ray.t_min),
+            S(ray.t_max), a, b, c, t, u, v));
+}
+
+template<size_t N>
+inline uint32_t
+intersect(const details::RayPacket<N>& rays, const float3& a, const float3& b, const float3& c,
+        details::Packet<N>& t, details::Packet<N>& u, details::Packet<N>& v) noexcept {
+    using namespace details::intersect;
+    typedef details::Packet<N> S;
+    return hits(triangle(rays.origin, rays.direction, rays.t_min, rays.t_max, splat<S>(a),
+            splat<S>(b), splat<S>(c), t, u, v));
+}
+
+} // namespace numeric
+
+#endif
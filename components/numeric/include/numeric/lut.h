@@ -0,0 +1,209 @@
+#ifndef CHROMA_NUMERIC_LUT_H
+#define CHROMA_NUMERIC_LUT_H
+
+#include "details/compiler.h"
+#include "details/simd.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace numeric {
+
+namespace details {
+namespace lookup {
+
+    // exp, log and pow in double that can run at compile time, to about 1e-15 relative
+    constexpr double LN2 = 0.693147180559945309417;
+    constexpr double SQRT2 = 1.41421356237309504880;
+
+    inline constexpr double exp2i(int k) noexcept {
+        double r = 1.0;
+        for (; k > 0; k--) { r *= 2.0; }
+        for (; k < 0; k++) { r *= 0.5; }
+        return r;
+    }
+
+    // x = k ln2 + r with |r| <= ln2 / 2, then the Taylor series of exp(r)
+    inline constexpr double exp(double x) noexcept {
+        int const k = int(x / LN2 + (x < 0.0 ? -0.5 : 0.5));
+        double const r = x - k * LN2;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int i = 1; i < 20; i++) {
+            term *= r / i;
+            sum += term;
+        }
+        return sum * exp2i(k);
+    }
+
+    // x = 2^k m with m in [sqrt(2)/2, sqrt(2)], then log(m) = 2 atanh((m - 1) / (m + 1))
+    inline constexpr double log(double x) noexcept {
+        int k = 0;
+        for (; x > SQRT2; k++) { x *= 0.5; }
+        for (; x < SQRT2 * 0.5; k--) { x *= 2.0; }
+        double const s = (x - 1.0) / (x + 1.0);
+        double term = s;
+        double sum = 0.0;
+        for (int i = 1; i < 40; i += 2) {
+            sum += term / i;
+            term *= s * s;
+        }
+        return 2.0 * sum + k * LN2;
+    }
+
+    // x^y for x >= 0
+    inline constexpr double pow(double x, double y) noexcept {
+        return x > 0.0 ? exp(y * log(x)) : 0.0;
+    }
+
+    // F, but never in a constant expression: a static lut of it is filled at first use rather
+    // than evaluated by the compiler in every translation unit that sees it
+    template<typename F>
+    struct at_runtime {
+        double operator()(double x) const noexcept { return F()(x); }
+    };
+
+} // namespace lookup
+} // namespace details
+
+/*
+ * A function sampled at N evenly spaced points of [lo, hi] and stored as floats, to replace
+ * an expensive curve by a lerp between two table entries. F is a function object taking and
+ * returning a double; when its operator() is constexpr the table can be built at compile
+ * time:
+ *
+ *     constexpr lut<1024, MyCurve> table(0.0f, 4.0f);
+ *
+ * details::lookup::pow() and friends are available to write such curves. The inputs are
+ * clamped to [lo, hi] (NaN gives f(lo)). The interpolation error is about h^2 / 8 |f''| with
+ * h = (hi - lo) / (N - 1), see the ready-made tables below.
+ */
+template<size_t N, typename F>
+class lut {
+    static_assert(N >= 2, "a lut needs at least 2 entries");
+
+public:
+    static constexpr size_t SIZE = N;
+
+    constexpr explicit lut(float lo = 0.0f, float hi = 1.0f, F f = F()) noexcept
+            : m_lo(lo), m_scale(float(N - 1) / (hi - lo)) {
+        for (size_t i = 0; i < N; i++) {
+            m_table[i] = float(f(lo + (double(hi) - lo) * double(i) / double(N - 1)));
+        }
+    }
+
+    // the sample at lo + i * (hi - lo) / (N - 1)
+    constexpr float operator[](size_t i) const noexcept { return m_table[i]; }
+
+    constexpr float const* data() const noexcept { return m_table; }
+
+    constexpr size_t size() const noexcept { return N; }
+
+    // linear interpolation between the samples around x
+    constexpr float operator()(float x) const noexcept {
+        float t = (x - m_lo) * m_scale;
+        t = t > 0.0f ? t : 0.0f;
+        t = t < float(N - 1) ? t : float(N - 1);
+        size_t const i = size_t(t) < N - 2 ? size_t(t) : N - 2;
+        return m_table[i] + (m_table[i + 1] - m_table[i]) * (t - float(i));
+    }
+
+    // the sample closest to x
+    constexpr float nearest(float x) const noexcept {
+        float t = (x - m_lo) * m_scale + 0.5f;
+        t = t > 0.0f ? t : 0.0f;
+        return m_table[size_t(t) < N - 1 ? size_t(t) : N - 1];
+    }
+
+    // out[i] = (*this)(in[i]), out can be in. Gathers the samples with AVX2.
+    void operator()(float const* in, float* out, size_t count) const noexcept;
+
+private:
+    float m_table[N] = {};
+    float m_lo;
+    float m_scale;
+};
+
+template<size_t N, typename F>
+constexpr size_t lut<N, F>::SIZE;
+
+template<size_t N, typename F>
+void lut<N, F>::operator()(float const* in, float* out, size_t count) const noexcept {
+    size_t i = 0;
+#if NUM_SIMD_AVX2
+    __m256 const lo = _mm256_set1_ps(m_lo);
+    __m256 const scale = _mm256_set1_ps(m_scale);
+    __m256 const last = _mm256_set1_ps(float(N - 1));
+    __m256i const last_index = _mm256_set1_epi32(int32_t(N - 2));
+    for (; i + 8 <= count; i += 8) {
+        __m256 t = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(in + i), lo), scale);
+        // t first in max() so that NaN gives 0
+        t = _mm256_min_ps(_mm256_max_ps(t, _mm256_setzero_ps()), last);
+        __m256i const k = _mm256_min_epi32(_mm256_cvttps_epi32(t), last_index);
+        __m256 const a = _mm256_i32gather_ps(m_table, k, 4);
+        __m256 const b = _mm256_i32gather_ps(m_table + 1, k, 4);
+        __m256 const f = _mm256_sub_ps(t, _mm256_cvtepi32_ps(k));
+        _mm256_storeu_ps(out + i, details::simd::madd(_mm256_sub_ps(b, a), f, a));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = (*this)(in[i]);
+    }
+}
+
+/*
+ * Ready-made curves and tables. The sRGB transfer functions are the exact piecewise ones of
+ * IEC 61966-2-1, the tone curve is the ACES filmic fit of K. Narkowicz, clamped to [0, 1].
+ */
+struct srgb_to_linear {
+    constexpr double operator()(double x) const noexcept {
+        return x <= 0.04045 ? x / 12.92 : details::lookup::pow((x + 0.055) / 1.055, 2.4);
+    }
+};
+
+struct linear_to_srgb {
+    constexpr double operator()(double x) const noexcept {
+        return x <= 0.0031308 ? x * 12.92 : 1.055 * details::lookup::pow(x, 1.0 / 2.4) - 0.055;
+    }
+};
+
+struct aces_tone_curve {
+    constexpr double operator()(double x) const noexcept {
+        double const y = (x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14);
+        return y < 0.0 ? 0.0 : (y > 1.0 ? 1.0 : y);
+    }
+};
+
+// the tables below are built at first use, see details::lookup::at_runtime
+using srgb8_to_linear_table = lut<256, details::lookup::at_runtime<srgb_to_linear>>;
+using srgb_to_linear_table = lut<1024, details::lookup::at_runtime<srgb_to_linear>>;
+using linear_to_srgb_table = lut<4096, details::lookup::at_runtime<linear_to_srgb>>;
+using aces_tone_curve_table = lut<4096, details::lookup::at_runtime<aces_tone_curve>>;
+
+// decodes 8-bit sRGB: srgb8_to_linear_lut()[v] is the linear value of v / 255
+inline srgb8_to_linear_table const& srgb8_to_linear_lut() noexcept {
+    static const srgb8_to_linear_table table;
+    return table;
+}
+
+// sRGB to linear for x in [0, 1], within 3e-6
+inline srgb_to_linear_table const& srgb_to_linear_lut() noexcept {
+    static const srgb_to_linear_table table;
+    return table;
+}
+
+// linear to sRGB for x in [0, 1], within 3e-5
+inline linear_to_srgb_table const& linear_to_srgb_lut() noexcept {
+    static const linear_to_srgb_table table;
+    return table;
+}
+
+// tone mapping of x in [0, 16] (1 above), within 1e-4
+inline aces_tone_curve_table const& aces_tone_curve_lut() noexcept {
+    static const aces_tone_curve_table table(0.0f, 16.0f);
+    return table;
+}
+
+} // namespace numeric
+
+#endif
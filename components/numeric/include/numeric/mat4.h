@@ -7,6 +7,7 @@
 #include "vec3.h"
 #include "vec4.h"
 #include "details/compiler.h"
+#include "details/simd.h"
 
 #include <stdint.h>
 #include <sys/types.h>
@@ -432,14 +433,104 @@ template<typename T, typename U>
 constexpr NUM_PURE
 typename Matrix44<T>::col_type 
 operator*(const Matrix44<T>& lhs, const Vector4<U>& rhs) {
-    // Result is initialized to zero.
-    typename Matrix44<T>::col_type result = {};
-    for (size_t col = 0; col < Matrix44<T>::NUM_COLS; ++col) {
-        result += lhs[col] * T(rhs[col]);
+    return matrix::transform_scalar(lhs, rhs);
+}
+
+#if NUM_SIMD
+// mat4f * float4 and mat4f * mat4f go through the SIMD kernels, the templates above remain
+// the reference for every other type (and for matrix::*_scalar).
+inline NUM_PURE
+Vector4<float>
+operator*(const Matrix44<float>& lhs, const Vector4<float>& rhs) {
+    Vector4<float> result;
+    simd::mul_m4v4(lhs.as_array(), rhs.v, result.v);
+    return result;
+}
+
+namespace matrix {
+template<>
+inline NUM_PURE
+Matrix44<float>
+multiply<Matrix44<float>, Matrix44<float>, Matrix44<float>>(
+        const Matrix44<float>& lhs, const Matrix44<float>& rhs) {
+    Matrix44<float> result(Matrix44<float>::NO_INIT);
+    simd::mul_m4m4(lhs.as_array(), rhs.as_array(), &result[0][0]);
+    return result;
+}
+} // namespace matrix
+#endif
+
+/*
+ * Inverse of an affine transform, i.e. a matrix whose last row is { 0, 0, 0, 1 }. Only the
+ * upper-left 3x3 is inverted, which is much cheaper than the general inverse().
+ */
+template<typename T>
+inline NUM_PURE
+Matrix44<T>
+affine_inverse(const Matrix44<T>& m) {
+    Matrix33<T> const a = inverse(m.upper_left());
+    return Matrix44<T>(a, -(a * m[3].xyz));
+}
+
+/*
+ * Inverse of a rigid transform, i.e. a rotation followed by a translation. The rotation is
+ * inverted by transposing it.
+ */
+template<typename T>
+inline NUM_PURE
+Matrix44<T>
+rigid_inverse(const Matrix44<T>& m) {
+    Matrix33<T> const r = transpose(m.upper_left());
+    return Matrix44<T>(r, -(r * m[3].xyz));
+}
+
+/*
+ * Same as inverse() but checks m at runtime and uses rigid_inverse() or affine_inverse()
+ * when they apply. Use it when the kind of transform isn't known statically, the checks cost
+ * about as much as the affine inverse itself.
+ */
+template<typename T>
+inline NUM_PURE
+Matrix44<T>
+inverse_fast(const Matrix44<T>& m) {
+    if (m[0][3] != 0 || m[1][3] != 0 || m[2][3] != 0 || m[3][3] != 1) {
+        return inverse(m);
+    }
+    if (matrix::is_orthonormal(m.upper_left(), 16 * std::numeric_limits<T>::epsilon())) {
+        return rigid_inverse(m);
     }
+    return affine_inverse(m);
+}
+
+/*
+ * Splits the affine transform m into translate(translation) * rotation * scale, see
+ * matrix::decompose(). Returns false if the upper-left 3x3 of m is singular.
+ */
+template<typename T>
+inline bool
+decompose(const Matrix44<T>& m, Vector3<T>& translation, Quaternion<T>& rotation,
+        Vector3<T>& scale) {
+    return matrix::decompose(m, translation, rotation, scale);
+}
+
+#if NUM_SIMD_SSE
+inline NUM_PURE
+Matrix44<float>
+affine_inverse(const Matrix44<float>& m) {
+    Matrix44<float> result(Matrix44<float>::NO_INIT);
+    simd::inverse_affine_m4(m.as_array(), &result[0][0]);
     return result;
 }
 
+inline NUM_PURE
+Matrix44<float>
+rigid_inverse(const Matrix44<float>& m) {
+    Matrix44<float> result(Matrix44<float>::NO_INIT);
+    simd::inverse_rigid_m4(m.as_array(), &result[0][0]);
+    return result;
+}
+#endif
+
 // mat44 * vec3, result is vec3( mat44 * {vec3, 1} )
 template<typename T, typename U>
 constexpr NUM_PURE
@@ -0,0 +1,252 @@
+#ifndef CHROMA_NUMERIC_MORTON_H
+#define CHROMA_NUMERIC_MORTON_H
+
+#include "batch.h"
+#include "bounds.h"
+#include "packet.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "details/compiler.h"
+#include "details/simd.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+
+#if NUM_SIMD_BMI2 && (defined(__x86_64__) || defined(_M_X64))
+#   define NUM_MORTON_PDEP64 1
+#else
+#   define NUM_MORTON_PDEP64 0
+#endif
+
+namespace numeric {
+
+/*
+ * Morton codes (Z-order curve): the bits of the coordinates are interleaved, x in the lowest
+ * bit, so that points close in space tend to be close in the sorted codes.
+ *
+ *  encode_morton2      2 x 16 bits in 32
+ *  encode_morton2_64   2 x 32 bits in 64
+ *  encode_morton3      3 x 10 bits in 32
+ *  encode_morton3_64   3 x 21 bits in 64
+ *
+ * The higher bits of the coordinates are ignored. With BMI2 the bits are moved by pdep/pext,
+ * otherwise with shifts and masks (the functions in details::morton, which are constexpr).
+ * pdep/pext are microcoded and slower than the shifts on AMD before Zen 3.
+ */
+namespace details {
+namespace morton {
+
+    // 0b---- ---- ---- ---- abcd efgh ijkl mnop -> 0b-a-b -c-d -e-f -g-h -i-j -k-l -m-n -o-p
+    inline constexpr uint32_t part1by1(uint32_t x) noexcept {
+        x &= 0x0000FFFFu;
+        x = (x | (x << 8)) & 0x00FF00FFu;
+        x = (x | (x << 4)) & 0x0F0F0F0Fu;
+        x = (x | (x << 2)) & 0x33333333u;
+        x = (x | (x << 1)) & 0x55555555u;
+        return x;
+    }
+
+    inline constexpr uint32_t compact1by1(uint32_t x) noexcept {
+        x &= 0x55555555u;
+        x = (x | (x >> 1)) & 0x33333333u;
+        x = (x | (x >> 2)) & 0x0F0F0F0Fu;
+        x = (x | (x >> 4)) & 0x00FF00FFu;
+        x = (x | (x >> 8)) & 0x0000FFFFu;
+        return x;
+    }
+
+    // 0b---- ---- ---- ---- ---- --ab cdef ghij -> 0b---- a--b --c- -d-- e--f --g- -h-- i--j
+    inline constexpr uint32_t part1by2(uint32_t x) noexcept {
+        x &= 0x000003FFu;
+        x = (x | (x << 16)) & 0x030000FFu;
+        x = (x | (x << 8)) & 0x0300F00Fu;
+        x = (x | (x << 4)) & 0x030C30C3u;
+        x = (x | (x << 2)) & 0x09249249u;
+        return x;
+    }
+
+    inline constexpr uint32_t compact1by2(uint32_t x) noexcept {
+        x &= 0x09249249u;
+        x = (x | (x >> 2)) & 0x030C30C3u;
+        x = (x | (x >> 4)) & 0x0300F00Fu;
+        x = (x | (x >> 8)) & 0x030000FFu;
+        x = (x | (x >> 16)) & 0x000003FFu;
+        return x;
+    }
+
+    inline constexpr uint64_t part1by1(uint64_t x) noexcept {
+        x &= 0x00000000FFFFFFFFull;
+        x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+        x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+        x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        x = (x | (x << 2)) & 0x3333333333333333ull;
+        x = (x | (x << 1)) & 0x5555555555555555ull;
+        return x;
+    }
+
+    inline constexpr uint64_t compact1by1(uint64_t x) noexcept {
+        x &= 0x5555555555555555ull;
+        x = (x | (x >> 1)) & 0x3333333333333333ull;
+        x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+        x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+        x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+        x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+        return x;
+    }
+
+    inline constexpr uint64_t part1by2(uint64_t x) noexcept {
+        x &= 0x00000000001FFFFFull;
+        x = (x | (x << 32)) & 0x001F00000000FFFFull;
+        x = (x | (x << 16)) & 0x001F0000FF0000FFull;
+        x = (x | (x << 8)) & 0x100F00F00F00F00Full;
+        x = (x | (x << 4)) & 0x10C30C30C30C30C3ull;
+        x = (x | (x << 2)) & 0x1249249249249249ull;
+        return x;
+    }
+
+    inline constexpr uint64_t compact1by2(uint64_t x) noexcept {
+        x &= 0x1249249249249249ull;
+        x = (x | (x >> 2)) & 0x10C30C30C30C30C3ull;
+        x = (x | (x >> 4)) & 0x100F00F00F00F00Full;
+        x = (x | (x >> 8)) & 0x001F0000FF0000FFull;
+        x = (x | (x >> 16)) & 0x001F00000000FFFFull;
+        x = (x | (x >> 32)) & 0x00000000001FFFFFull;
+        return x;
+    }
+
+    constexpr uint32_t MASK2 = 0x55555555u;
+    constexpr uint32_t MASK3 = 0x09249249u;
+    constexpr uint64_t MASK2_64 = 0x5555555555555555ull;
+    constexpr uint64_t MASK3_64 = 0x1249249249249249ull;
+
+} // namespace morton
+} // namespace details
+
+inline uint32_t encode_morton2(uint2 p) noexcept {
+    using namespace details::morton;
+#if NUM_SIMD_BMI2
+    return _pdep_u32(p.x, MASK2) | _pdep_u32(p.y, MASK2 << 1);
+#else
+    return part1by1(p.x) | (part1by1(p.y) << 1);
+#endif
+}
+
+inline uint2 decode_morton2(uint32_t code) noexcept {
+    using namespace details::morton;
+#if NUM_SIMD_BMI2
+    return uint2(_pext_u32(code, MASK2), _pext_u32(code, MASK2 << 1));
+#else
+    return uint2(compact1by1(code), compact1by1(code >> 1));
+#endif
+}
+
+inline uint32_t encode_morton3(uint3 p) noexcept {
+    using namespace details::morton;
+#if NUM_SIMD_BMI2
+    return _pdep_u32(p.x, MASK3) | _pdep_u32(p.y, MASK3 << 1) | _pdep_u32(p.z, MASK3 << 2);
+#else
+    return part1by2(p.x) | (part1by2(p.y) << 1) | (part1by2(p.z) << 2);
+#endif
+}
+
+inline uint3 decode_morton3(uint32_t code) noexcept {
+    using namespace details::morton;
+#if NUM_SIMD_BMI2
+    return uint3(_pext_u32(code, MASK3), _pext_u32(code, MASK3 << 1),
+                 _pext_u32(code, MASK3 << 2));
+#else
+    return uint3(compact1by2(code), compact1by2(code >> 1), compact1by2(code >> 2));
+#endif
+}
+
+inline uint64_t encode_morton2_64(uint2 p) noexcept {
+    using namespace details::morton;
+#if NUM_MORTON_PDEP64
+    return _pdep_u64(p.x, MASK2_64) | _pdep_u64(p.y, MASK2_64 << 1);
+#else
+    return part1by1(uint64_t(p.x)) | (part1by1(uint64_t(p.y)) << 1);
+#endif
+}
+
+inline uint2 decode_morton2_64(uint64_t code) noexcept {
+    using namespace details::morton;
+#if NUM_MORTON_PDEP64
+    return uint2(uint32_t(_pext_u64(code, MASK2_64)), uint32_t(_pext_u64(code, MASK2_64 << 1)));
+#else
+    return uint2(uint32_t(compact1by1(code)), uint32_t(compact1by1(code >> 1)));
+#endif
+}
+
+inline uint64_t encode_morton3_64(uint3 p) noexcept {
+    using namespace details::morton;
+#if NUM_MORTON_PDEP64
+    return _pdep_u64(p.x, MASK3_64) | _pdep_u64(p.y, MASK3_64 << 1) |
+           _pdep_u64(p.z, MASK3_64 << 2);
+#else
+    return part1by2(uint64_t(p.x)) | (part1by2(uint64_t(p.y)) << 1) |
+           (part1by2(uint64_t(p.z)) << 2);
+#endif
+}
+
+inline uint3 decode_morton3_64(uint64_t code) noexcept {
+    using namespace details::morton;
+#if NUM_MORTON_PDEP64
+    return uint3(uint32_t(_pext_u64(code, MASK3_64)), uint32_t(_pext_u64(code, MASK3_64 << 1)),
+                 uint32_t(_pext_u64(code, MASK3_64 << 2)));
+#else
+    return uint3(uint32_t(compact1by2(code)), uint32_t(compact1by2(code >> 1)),
+                 uint32_t(compact1by2(code >> 2)));
+#endif
+}
+
+namespace details {
+namespace batch {
+
+    // the cell of each position in a grid of 2^BITS cells per axis covering bounds
+    template<size_t BITS, typename T, typename ENCODE>
+    inline void morton_codes(float3 const* pos, const Aabb& bounds, T* out, size_t count,
+            ENCODE encode) noexcept {
+        float const cells = float(1u << BITS);
+        float3 const size = bounds.max - bounds.min;
+        packet3 const lo(packet(bounds.min.x), packet(bounds.min.y), packet(bounds.min.z));
+        // flat bounds put everything in cell 0 along that axis
+        packet3 const scale(packet(size.x > 0 ? cells / size.x : 0.0f),
+                            packet(size.y > 0 ? cells / size.y : 0.0f),
+                            packet(size.z > 0 ? cells / size.z : 0.0f));
+        packet const zero(0.0f), last(cells - 1.0f);
+        for (size_t i = 0; i < count; i += packet::SIZE) {
+            size_t const n = std::min(packet::SIZE, count - i);
+            packet3 const p = load(pos + i, n);
+            packet const x = min(max((p.x - lo.x) * scale.x, zero), last);
+            packet const y = min(max((p.y - lo.y) * scale.y, zero), last);
+            packet const z = min(max((p.z - lo.z) * scale.z, zero), last);
+            for (size_t j = 0; j < n; j++) {
+                // truncation is floor() on positive values
+                out[i + j] = encode(uint3(uint32_t(x[j]), uint32_t(y[j]), uint32_t(z[j])));
+            }
+        }
+    }
+
+} // namespace batch
+} // namespace details
+
+/*
+ * 3D Morton codes of the positions quantized on a uniform grid over bounds, 10 or 21 bits per
+ * axis. The positions outside of bounds are clamped to the closest cell.
+ */
+inline void
+morton_codes(float3 const* pos, const Aabb& bounds, uint32_t* out, size_t count) noexcept {
+    details::batch::morton_codes<10>(pos, bounds, out, count, encode_morton3);
+}
+
+inline void
+morton_codes(float3 const* pos, const Aabb& bounds, uint64_t* out, size_t count) noexcept {
+    details::batch::morton_codes<21>(pos, bounds, out, count, encode_morton3_64);
+}
+
+} // namespace numeric
+
+#undef NUM_MORTON_PDEP64
+
+#endif
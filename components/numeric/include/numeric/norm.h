@@ -2,10 +2,14 @@
 #define CHROMA_NUMERIC_NORM_H
 
 #include "scalar.h"
+#include "vec2.h"
 #include "vec4.h"
+#include "details/simd.h"
 
 #include <cmath>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 namespace numeric {
 
@@ -77,6 +81,270 @@ inline float4 unpack_snorm8(byte4 v) noexcept {
     return float4{ unpack_snorm8(v.x), unpack_snorm8(v.y), unpack_snorm8(v.z), unpack_snorm8(v.w) };
 }
 
+namespace details {
+namespace norm_convert {
+
+/*
+ * Kernels for the array versions below, 4 components at a time. They reproduce the scalar
+ * functions above bit for bit: the 16-bit formats are scaled in float and the 8-bit formats
+ * in double (WIDE), then rounded half away from zero like std::round(). NaN packs to the
+ * lower bound, like numeric::clamp().
+ */
+template<bool WIDE, typename T>
+inline T quantize(float v, float lo, float hi, float scale) noexcept {
+    return WIDE ? static_cast<T>(std::round(numeric::clamp(v, lo, hi) * double(scale)))
+                : static_cast<T>(std::round(numeric::clamp(v, lo, hi) * scale));
+}
+
+template<bool SNORM>
+inline float dequantize(float v, float scale) noexcept {
+    return SNORM ? numeric::clamp(v / scale, -1.0f, 1.0f) : v / scale;
+}
+
+#if NUM_SIMD_SSE
+
+    inline __m128 clamp(__m128 v, float lo, float hi) noexcept {
+        // same operand order as std::min/std::max so that NaN gives lo
+        return _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(lo)), _mm_set1_ps(hi));
+    }
+
+    // std::round(), the results must fit in an int32. y - trunc(y) is exact.
+    inline __m128i round(__m128 y) noexcept {
+        __m128i const t = _mm_cvttps_epi32(y);
+        __m128 const f = _mm_sub_ps(y, _mm_cvtepi32_ps(t));
+        __m128i const up = _mm_castps_si128(_mm_cmpge_ps(f, _mm_set1_ps(0.5f)));
+        __m128i const down = _mm_castps_si128(_mm_cmple_ps(f, _mm_set1_ps(-0.5f)));
+        return _mm_add_epi32(_mm_sub_epi32(t, up), down);
+    }
+
+    // same for 2 doubles, the results are in the low 64 bits
+    inline __m128i round(__m128d y) noexcept {
+        __m128i const t = _mm_cvttpd_epi32(y);
+        __m128d const f = _mm_sub_pd(y, _mm_cvtepi32_pd(t));
+        __m128i const up = _mm_shuffle_epi32(
+                _mm_castpd_si128(_mm_cmpge_pd(f, _mm_set1_pd(0.5))), _MM_SHUFFLE(3, 3, 2, 0));
+        __m128i const down = _mm_shuffle_epi32(
+                _mm_castpd_si128(_mm_cmple_pd(f, _mm_set1_pd(-0.5))), _MM_SHUFFLE(3, 3, 2, 0));
+        return _mm_add_epi32(_mm_sub_epi32(t, up), down);
+    }
+
+    template<bool WIDE>
+    inline __m128i quantize(__m128 v, float lo, float hi, float scale) noexcept {
+        __m128 const c = clamp(v, lo, hi);
+        if (!WIDE) {
+            return round(_mm_mul_ps(c, _mm_set1_ps(scale)));
+        }
+        __m128d const s = _mm_set1_pd(scale);
+        __m128i const l = round(_mm_mul_pd(_mm_cvtps_pd(c), s));
+        __m128i const h = round(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(c, c)), s));
+        return _mm_unpacklo_epi64(l, h);
+    }
+
+    template<bool SNORM>
+    inline __m128 dequantize(__m128i v, float scale) noexcept {
+        __m128 const f = _mm_div_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(scale));
+        return SNORM ? clamp(f, -1.0f, 1.0f) : f;
+    }
+
+    inline void store4(uint8_t* out, __m128i v) noexcept {
+        __m128i const w = _mm_packs_epi32(v, v);
+        int32_t const r = _mm_cvtsi128_si32(_mm_packus_epi16(w, w));
+        memcpy(out, &r, sizeof(r));
+    }
+
+    inline void store4(int8_t* out, __m128i v) noexcept {
+        __m128i const w = _mm_packs_epi32(v, v);
+        int32_t const r = _mm_cvtsi128_si32(_mm_packs_epi16(w, w));
+        memcpy(out, &r, sizeof(r));
+    }
+
+    inline void store4(uint16_t* out, __m128i v) noexcept {
+#if NUM_SIMD_SSE41
+        __m128i const w = _mm_packus_epi32(v, v);
+#else
+        // bias to the signed range, pack with signed saturation and unbias
+        __m128i const b = _mm_sub_epi32(v, _mm_set1_epi32(0x8000));
+        __m128i const w = _mm_xor_si128(_mm_packs_epi32(b, b), _mm_set1_epi16(int16_t(0x8000)));
+#endif
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), w);
+    }
+
+    inline void store4(int16_t* out, __m128i v) noexcept {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(v, v));
+    }
+
+    inline __m128i load4(uint8_t const* in) noexcept {
+        int32_t r;
+        memcpy(&r, in, sizeof(r));
+        __m128i const zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(r), zero), zero);
+    }
+
+    inline __m128i load4(int8_t const* in) noexcept {
+        int32_t r;
+        memcpy(&r, in, sizeof(r));
+        __m128i const b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(r), _mm_cvtsi32_si128(r));
+        return _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 24);
+    }
+
+    inline __m128i load4(uint16_t const* in) noexcept {
+        __m128i const h = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(in));
+        return _mm_unpacklo_epi16(h, _mm_setzero_si128());
+    }
+
+    inline __m128i load4(int16_t const* in) noexcept {
+        __m128i const h = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(in));
+        return _mm_srai_epi32(_mm_unpacklo_epi16(h, h), 16);
+    }
+
+    inline __m128 loadf4(float const* in) noexcept { return _mm_loadu_ps(in); }
+    inline void storef4(float* out, __m128 v) noexcept { _mm_storeu_ps(out, v); }
+
+#   define NUM_NORM_SIMD 1
+
+#elif NUM_SIMD_NEON && defined(__aarch64__)
+
+    inline float32x4_t clamp(float32x4_t v, float lo, float hi) noexcept {
+        // maxnm/minnm return the number when the other operand is NaN, NaN gives lo
+        return vminnmq_f32(vmaxnmq_f32(v, vdupq_n_f32(lo)), vdupq_n_f32(hi));
+    }
+
+    template<bool WIDE>
+    inline int32x4_t quantize(float32x4_t v, float lo, float hi, float scale) noexcept {
+        float32x4_t const c = clamp(v, lo, hi);
+        if (!WIDE) {
+            // fcvtas rounds to nearest with ties away from zero, like std::round()
+            return vcvtaq_s32_f32(vmulq_n_f32(c, scale));
+        }
+        float64x2_t const s = vdupq_n_f64(scale);
+        int64x2_t const l = vcvtaq_s64_f64(vmulq_f64(vcvt_f64_f32(vget_low_f32(c)), s));
+        int64x2_t const h = vcvtaq_s64_f64(vmulq_f64(vcvt_high_f64_f32(c), s));
+        return vcombine_s32(vmovn_s64(l), vmovn_s64(h));
+    }
+
+    template<bool SNORM>
+    inline float32x4_t dequantize(int32x4_t v, float scale) noexcept {
+        float32x4_t const f = vdivq_f32(vcvtq_f32_s32(v), vdupq_n_f32(scale));
+        return SNORM ? clamp(f, -1.0f, 1.0f) : f;
+    }
+
+    inline void store4(uint8_t* out, int32x4_t v) noexcept {
+        int16x4_t const w = vqmovn_s32(v);
+        uint32_t const r = vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(w, w))), 0);
+        memcpy(out, &r, sizeof(r));
+    }
+
+    inline void store4(int8_t* out, int32x4_t v) noexcept {
+        int16x4_t const w = vqmovn_s32(v);
+        uint32_t const r = vget_lane_u32(vreinterpret_u32_s8(vqmovn_s16(vcombine_s16(w, w))), 0);
+        memcpy(out, &r, sizeof(r));
+    }
+
+    inline void store4(uint16_t* out, int32x4_t v) noexcept { vst1_u16(out, vqmovun_s32(v)); }
+    inline void store4(int16_t* out, int32x4_t v) noexcept { vst1_s16(out, vqmovn_s32(v)); }
+
+    inline int32x4_t load4(uint8_t const* in) noexcept {
+        uint32_t r;
+        memcpy(&r, in, sizeof(r));
+        uint16x8_t const w = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(r)));
+        return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(w)));
+    }
+
+    inline int32x4_t load4(int8_t const* in) noexcept {
+        uint32_t r;
+        memcpy(&r, in, sizeof(r));
+        int16x8_t const w = vmovl_s8(vreinterpret_s8_u32(vdup_n_u32(r)));
+        return vmovl_s16(vget_low_s16(w));
+    }
+
+    inline int32x4_t load4(uint16_t const* in) noexcept {
+        return vreinterpretq_s32_u32(vmovl_u16(vld1_u16(in)));
+    }
+
+    inline int32x4_t load4(int16_t const* in) noexcept { return vmovl_s16(vld1_s16(in)); }
+
+    inline float32x4_t loadf4(float const* in) noexcept { return vld1q_f32(in); }
+    inline void storef4(float* out, float32x4_t v) noexcept { vst1q_f32(out, v); }
+
+#   define NUM_NORM_SIMD 1
+
+#else
+#   define NUM_NORM_SIMD 0
+#endif
+
+template<bool WIDE, typename T>
+inline void pack(float const* in, T* out, size_t count, float lo, float hi, float scale) noexcept {
+    size_t i = 0;
+#if NUM_NORM_SIMD
+    size_t const blocks = count & ~size_t(3);
+    for (; i < blocks; i += 4) {
+        store4(out + i, quantize<WIDE>(loadf4(in + i), lo, hi, scale));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = quantize<WIDE, T>(in[i], lo, hi, scale);
+    }
+}
+
+template<bool SNORM, typename T>
+inline void unpack(T const* in, float* out, size_t count, float scale) noexcept {
+    size_t i = 0;
+#if NUM_NORM_SIMD
+    size_t const blocks = count & ~size_t(3);
+    for (; i < blocks; i += 4) {
+        storef4(out + i, dequantize<SNORM>(load4(in + i), scale));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = dequantize<SNORM>(float(in[i]), scale);
+    }
+}
+
+#undef NUM_NORM_SIMD
+
+} // namespace norm_convert
+} // namespace details
+
+/*
+ * Array versions of the functions above, they give exactly the same results.
+ */
+
+inline void pack_unorm16(float4 const* in, ushort4* out, size_t count) noexcept {
+    details::norm_convert::pack<false>(&in->x, &out->x, count * 4, 0.0f, 1.0f, 65535.0f);
+}
+
+inline void pack_snorm16(float2 const* in, short2* out, size_t count) noexcept {
+    details::norm_convert::pack<false>(&in->x, &out->x, count * 2, -1.0f, 1.0f, 32767.0f);
+}
+
+inline void pack_snorm16(float4 const* in, short4* out, size_t count) noexcept {
+    details::norm_convert::pack<false>(&in->x, &out->x, count * 4, -1.0f, 1.0f, 32767.0f);
+}
+
+inline void unpack_unorm16(ushort4 const* in, float4* out, size_t count) noexcept {
+    details::norm_convert::unpack<false>(&in->x, &out->x, count * 4, 65535.0f);
+}
+
+inline void unpack_snorm16(short4 const* in, float4* out, size_t count) noexcept {
+    details::norm_convert::unpack<true>(&in->x, &out->x, count * 4, 32767.0f);
+}
+
+inline void pack_unorm8(float4 const* in, ubyte4* out, size_t count) noexcept {
+    details::norm_convert::pack<true>(&in->x, &out->x, count * 4, 0.0f, 1.0f, 255.0f);
+}
+
+inline void pack_snorm8(float4 const* in, byte4* out, size_t count) noexcept {
+    details::norm_convert::pack<true>(&in->x, &out->x, count * 4, -1.0f, 1.0f, 127.0f);
+}
+
+inline void unpack_unorm8(ubyte4 const* in, float4* out, size_t count) noexcept {
+    details::norm_convert::unpack<false>(&in->x, &out->x, count * 4, 255.0f);
+}
+
+inline void unpack_snorm8(byte4 const* in, float4* out, size_t count) noexcept {
+    details::norm_convert::unpack<true>(&in->x, &out->x, count * 4, 127.0f);
+}
+
 } // namespace std
 
 #endif
\ No newline at end of file
@@ -0,0 +1,376 @@
+#ifndef CHROMA_NUMERIC_PACKED_FLOAT_H
+#define CHROMA_NUMERIC_PACKED_FLOAT_H
+
+#include "half.h"
+#include "vec3.h"
+#include "details/compiler.h"
+#include "details/simd.h"
+
+#include <algorithm>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace numeric {
+
+/*
+ * Packed HDR color formats, 32 bits per RGB texel, for positive values only.
+ *
+ * RGB9E5 (GL_EXT_texture_shared_exponent), 3 x 9-bit mantissas sharing a 5-bit exponent:
+ *
+ *     5      9          9          9
+ *  +-----+---------+---------+---------+
+ *  |eeeee|bbbbbbbbb|ggggggggg|rrrrrrrrr|
+ *  +-----+---------+---------+---------+
+ *
+ *  max value 65408, inputs are clamped to [0, 65408] and NaN packs to 0.
+ *
+ * R11G11B10F, 3 unsigned floats with a 5-bit exponent (bias 15) and a 6-bit (r, g) or 5-bit
+ * (b) mantissa:
+ *
+ *      10         11           11
+ *  +----------+-----------+-----------+
+ *  |eeeeemmmmm|eeeeemmmmmm|eeeeemmmmmm|
+ *  +----------+-----------+-----------+
+ *       b           g           r
+ *
+ *  max value 65024 (r, g) and 64512 (b), larger finite values saturate, +inf and NaN are kept,
+ *  negative values pack to 0. Denormals are supported.
+ *
+ * Both round to nearest (RGB9E5 ties up as in the extension, R11G11B10F ties to even). The
+ * scalar functions only use exact arithmetic on floats so that they're constexpr, the array
+ * versions work on the bits with SSE2. They give the same results, but with -ffast-math the
+ * compiler may drop the NaN and infinity tests of the scalar functions: use the array versions
+ * when the input can have them.
+ */
+
+namespace details {
+namespace packed_float {
+
+    // 2^n for |n| <= 31
+    inline constexpr float pow2(int n) noexcept {
+        return n >= 0 ? float(1u << n) : 1.0f / float(1u << -n);
+    }
+
+    // floor(log2(x)) for x > 0, or lo if it is smaller; only scales x by 2 which is exact
+    inline constexpr int ilog2(float x, int lo) noexcept {
+        int e = 0;
+        while (x >= 2.0f && e < 128) {
+            x *= 0.5f;
+            e++;
+        }
+        while (x < 1.0f && e > lo) {
+            x *= 2.0f;
+            e--;
+        }
+        return e;
+    }
+
+    // floor(v + 0.5) for v in [0, 2^31), without the rounding of v + 0.5
+    inline constexpr uint32_t round_half_up(float v) noexcept {
+        uint32_t const t = uint32_t(v);
+        return t + (v - float(t) >= 0.5f ? 1u : 0u);
+    }
+
+    // v rounded to nearest-even, for v in [0, 2^31)
+    inline constexpr uint32_t round_even(float v) noexcept {
+        uint32_t const t = uint32_t(v);
+        float const f = v - float(t);
+        return t + ((f > 0.5f || (f == 0.5f && (t & 1u))) ? 1u : 0u);
+    }
+
+    // float to an unsigned float with a 5-bit exponent and an M-bit mantissa
+    template<int M>
+    inline constexpr uint32_t to_ufloat(float x) noexcept {
+        constexpr uint32_t INF = 0x1Fu << M;
+        constexpr float MAX = float((2u << M) - 1u) * pow2(15 - M);
+        if (x != x) {
+            return INF | ((1u << M) - 1u);
+        }
+        if (!(x > 0.0f)) {
+            return 0;
+        }
+        if (x > std::numeric_limits<float>::max()) {
+            return INF;
+        }
+        if (x > MAX) {
+            return INF - 1u;
+        }
+        int const e = ilog2(x, -15);
+        if (e < -14) {
+            // denormal, can round up to the smallest normal which has the next encoding
+            return round_even(x * pow2(14 + M));
+        }
+        uint32_t const m = round_even(x * pow2(M - e));
+        return (uint32_t(e + 15) << M) + m - (1u << M);
+    }
+
+    template<int M>
+    inline constexpr float from_ufloat(uint32_t v) noexcept {
+        uint32_t const e = (v >> M) & 0x1Fu;
+        uint32_t const m = v & ((1u << M) - 1u);
+        if (e == 0x1Fu) {
+            return m ? std::numeric_limits<float>::quiet_NaN()
+                     : std::numeric_limits<float>::infinity();
+        }
+        return e == 0 ? float(m) * pow2(-14 - M)
+                      : float(m + (1u << M)) * pow2(int(e) - 15 - M);
+    }
+
+    constexpr float RGB9E5_MAX = 65408.0f;
+
+    inline constexpr float clamp_rgb9e5(float v) noexcept {
+        return v > 0.0f ? std::min(v, RGB9E5_MAX) : 0.0f;
+    }
+
+} // namespace packed_float
+} // namespace details
+
+inline constexpr
+uint32_t
+pack_rgb9e5(float3 rgb) noexcept {
+    using namespace details::packed_float;
+    float const r = clamp_rgb9e5(rgb.x);
+    float const g = clamp_rgb9e5(rgb.y);
+    float const b = clamp_rgb9e5(rgb.z);
+    float const maxc = std::max(r, std::max(g, b));
+    int e = ilog2(maxc, -16) + 16;
+    float s = pow2(24 - e);
+    if (round_half_up(maxc * s) == 512) {
+        e++;
+        s *= 0.5f;
+    }
+    return round_half_up(r * s) | (round_half_up(g * s) << 9) | (round_half_up(b * s) << 18) |
+           (uint32_t(e) << 27);
+}
+
+inline constexpr
+float3
+unpack_rgb9e5(uint32_t v) noexcept {
+    float const s = details::packed_float::pow2(int(v >> 27) - 24);
+    return float3(float(v & 0x1FFu) * s, float((v >> 9) & 0x1FFu) * s,
+                  float((v >> 18) & 0x1FFu) * s);
+}
+
+inline constexpr
+uint32_t
+pack_r11g11b10f(float3 rgb) noexcept {
+    using namespace details::packed_float;
+    return to_ufloat<6>(rgb.x) | (to_ufloat<6>(rgb.y) << 11) | (to_ufloat<5>(rgb.z) << 22);
+}
+
+inline constexpr
+float3
+unpack_r11g11b10f(uint32_t v) noexcept {
+    using namespace details::packed_float;
+    return float3(from_ufloat<6>(v & 0x7FFu), from_ufloat<6>((v >> 11) & 0x7FFu),
+                  from_ufloat<5>(v >> 22));
+}
+
+namespace details {
+namespace packed_float {
+
+#if NUM_SIMD_SSE
+
+    inline __m128i select(__m128i mask, __m128i a, __m128i b) noexcept {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    inline __m128 pow2(__m128i n) noexcept {
+        return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+    }
+
+    inline __m128i round_half_up(__m128 v) noexcept {
+        __m128i const t = _mm_cvttps_epi32(v);
+        __m128 const f = _mm_sub_ps(v, _mm_cvtepi32_ps(t));
+        // the comparison mask is -1 where we round up
+        return _mm_sub_epi32(t, _mm_castps_si128(_mm_cmpge_ps(f, _mm_set1_ps(0.5f))));
+    }
+
+    inline __m128i pack_rgb9e5(__m128 r, __m128 g, __m128 b) noexcept {
+        __m128 const zero = _mm_setzero_ps();
+        __m128 const max = _mm_set1_ps(RGB9E5_MAX);
+        // x first in max() so that NaN gives 0
+        r = _mm_min_ps(_mm_max_ps(r, zero), max);
+        g = _mm_min_ps(_mm_max_ps(g, zero), max);
+        b = _mm_min_ps(_mm_max_ps(b, zero), max);
+        __m128 const maxc = _mm_max_ps(r, _mm_max_ps(g, b));
+
+        // max(floor(log2(maxc)), -16) + 16 from the biased exponent
+        __m128i const be = _mm_srli_epi32(_mm_castps_si128(maxc), 23);
+        __m128i e = _mm_sub_epi32(
+                select(_mm_cmpgt_epi32(be, _mm_set1_epi32(111)), be, _mm_set1_epi32(111)),
+                _mm_set1_epi32(111));
+        __m128i const bump = _mm_cmpeq_epi32(
+                round_half_up(_mm_mul_ps(maxc, pow2(_mm_sub_epi32(_mm_set1_epi32(24), e)))),
+                _mm_set1_epi32(512));
+        e = _mm_sub_epi32(e, bump);
+        __m128 const s = pow2(_mm_sub_epi32(_mm_set1_epi32(24), e));
+
+        __m128i v = round_half_up(_mm_mul_ps(r, s));
+        v = _mm_or_si128(v, _mm_slli_epi32(round_half_up(_mm_mul_ps(g, s)), 9));
+        v = _mm_or_si128(v, _mm_slli_epi32(round_half_up(_mm_mul_ps(b, s)), 18));
+        return _mm_or_si128(v, _mm_slli_epi32(e, 27));
+    }
+
+    inline void unpack_rgb9e5(__m128i v, __m128& r, __m128& g, __m128& b) noexcept {
+        __m128i const mask = _mm_set1_epi32(0x1FF);
+        __m128 const s = pow2(_mm_sub_epi32(_mm_srli_epi32(v, 27), _mm_set1_epi32(24)));
+        r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v, mask)), s);
+        g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 9), mask)), s);
+        b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 18), mask)), s);
+    }
+
+    /*
+     * to_ufloat<M>() on the bits: normal values are rebiased and rounded to nearest-even on
+     * the integer representation, denormals are rounded by the FPU when added to a constant
+     * whose ulp is the denormal step.
+     */
+    template<int M>
+    inline __m128i to_ufloat(__m128 x) noexcept {
+        int32_t const INF = 0x1F << M;
+        int32_t const MAX_BITS = (142 << 23) | (((1 << M) - 1) << (23 - M));
+        int32_t const DENORMAL_BIAS = (127 + 9 - M) << 23;     // 2^(9 - M)
+        __m128i const i = _mm_castps_si128(x);
+        __m128i const a = _mm_and_si128(i, _mm_set1_epi32(0x7FFFFFFF));
+
+        __m128i n = _mm_add_epi32(i, _mm_set1_epi32(int32_t(0xC8000000u)));  // -112 << 23
+        n = _mm_add_epi32(n, _mm_add_epi32(_mm_set1_epi32((1 << (22 - M)) - 1),
+                _mm_and_si128(_mm_srli_epi32(n, 23 - M), _mm_set1_epi32(1))));
+        n = _mm_srli_epi32(n, 23 - M);
+
+        __m128i const d = _mm_sub_epi32(
+                _mm_castps_si128(_mm_add_ps(x, _mm_castsi128_ps(_mm_set1_epi32(DENORMAL_BIAS)))),
+                _mm_set1_epi32(DENORMAL_BIAS));
+
+        __m128i r = select(_mm_cmplt_epi32(i, _mm_set1_epi32(0x38800000)), d, n);
+        r = select(_mm_cmpgt_epi32(i, _mm_set1_epi32(MAX_BITS)), _mm_set1_epi32(INF - 1), r);
+        r = select(_mm_cmpeq_epi32(i, _mm_set1_epi32(0x7F800000)), _mm_set1_epi32(INF), r);
+        r = select(_mm_cmplt_epi32(i, _mm_setzero_si128()), _mm_setzero_si128(), r);
+        return select(_mm_cmpgt_epi32(a, _mm_set1_epi32(0x7F800000)),
+                _mm_set1_epi32(INF | ((1 << M) - 1)), r);
+    }
+
+    template<int M>
+    inline __m128 from_ufloat(__m128i v) noexcept {
+        __m128i const e = _mm_and_si128(_mm_srli_epi32(v, M), _mm_set1_epi32(0x1F));
+        __m128i const m = _mm_and_si128(v, _mm_set1_epi32((1 << M) - 1));
+        __m128i const normal = _mm_cmpgt_epi32(e, _mm_setzero_si128());
+        // the implicit 1 and the exponent of the denormals is that of the smallest normal
+        __m128i const full = _mm_or_si128(m, _mm_and_si128(normal, _mm_set1_epi32(1 << M)));
+        __m128i const k = _mm_sub_epi32(_mm_sub_epi32(e, _mm_cmpeq_epi32(e, _mm_setzero_si128())),
+                _mm_set1_epi32(15 + M));
+        __m128 const f = _mm_mul_ps(_mm_cvtepi32_ps(full), pow2(k));
+        __m128i const special = _mm_cmpeq_epi32(e, _mm_set1_epi32(0x1F));
+        __m128i const infnan = _mm_or_si128(_mm_set1_epi32(0x7F800000),
+                _mm_and_si128(_mm_cmpgt_epi32(m, _mm_setzero_si128()), _mm_set1_epi32(0x400000)));
+        return _mm_castsi128_ps(select(special, infnan, _mm_castps_si128(f)));
+    }
+
+    inline __m128i pack_r11g11b10f(__m128 r, __m128 g, __m128 b) noexcept {
+        return _mm_or_si128(_mm_or_si128(to_ufloat<6>(r), _mm_slli_epi32(to_ufloat<6>(g), 11)),
+                _mm_slli_epi32(to_ufloat<5>(b), 22));
+    }
+
+    inline void unpack_r11g11b10f(__m128i v, __m128& r, __m128& g, __m128& b) noexcept {
+        __m128i const mask = _mm_set1_epi32(0x7FF);
+        r = from_ufloat<6>(_mm_and_si128(v, mask));
+        g = from_ufloat<6>(_mm_and_si128(_mm_srli_epi32(v, 11), mask));
+        b = from_ufloat<5>(_mm_srli_epi32(v, 22));
+    }
+
+    // 4 texels at a time, the tail goes through the same code with a partial group
+    template<typename PACK>
+    inline void pack(float3 const* in, uint32_t* out, size_t count, PACK pack) noexcept {
+        for (size_t i = 0; i < count; i += 4) {
+            size_t const n = std::min(size_t(4), count - i);
+            float c[3][4] = {};
+            for (size_t j = 0; j < n; j++) {
+                c[0][j] = in[i + j].r;
+                c[1][j] = in[i + j].g;
+                c[2][j] = in[i + j].b;
+            }
+            uint32_t v[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(v),
+                    pack(_mm_loadu_ps(c[0]), _mm_loadu_ps(c[1]), _mm_loadu_ps(c[2])));
+            for (size_t j = 0; j < n; j++) {
+                out[i + j] = v[j];
+            }
+        }
+    }
+
+    template<typename UNPACK>
+    inline void unpack(uint32_t const* in, float3* out, size_t count, UNPACK unpack) noexcept {
+        for (size_t i = 0; i < count; i += 4) {
+            size_t const n = std::min(size_t(4), count - i);
+            uint32_t v[4] = {};
+            for (size_t j = 0; j < n; j++) {
+                v[j] = in[i + j];
+            }
+            __m128 r, g, b;
+            unpack(_mm_loadu_si128(reinterpret_cast<__m128i const*>(v)), r, g, b);
+            float c[3][4];
+            _mm_storeu_ps(c[0], r);
+            _mm_storeu_ps(c[1], g);
+            _mm_storeu_ps(c[2], b);
+            for (size_t j = 0; j < n; j++) {
+                out[i + j] = float3(c[0][j], c[1][j], c[2][j]);
+            }
+        }
+    }
+
+#endif
+
+} // namespace packed_float
+} // namespace details
+
+/*
+ * Array versions of the functions above, bit-identical to them (NaN payloads aside).
+ */
+inline void
+pack_rgb9e5(float3 const* in, uint32_t* out, size_t count) noexcept {
+#if NUM_SIMD_SSE
+    details::packed_float::pack(in, out, count, details::packed_float::pack_rgb9e5);
+#else
+    for (size_t i = 0; i < count; i++) {
+        out[i] = pack_rgb9e5(in[i]);
+    }
+#endif
+}
+
+inline void
+unpack_rgb9e5(uint32_t const* in, float3* out, size_t count) noexcept {
+#if NUM_SIMD_SSE
+    details::packed_float::unpack(in, out, count, details::packed_float::unpack_rgb9e5);
+#else
+    for (size_t i = 0; i < count; i++) {
+        out[i] = unpack_rgb9e5(in[i]);
+    }
+#endif
+}
+
+inline void
+pack_r11g11b10f(float3 const* in, uint32_t* out, size_t count) noexcept {
+#if NUM_SIMD_SSE
+    details::packed_float::pack(in, out, count, details::packed_float::pack_r11g11b10f);
+#else
+    for (size_t i = 0; i < count; i++) {
+        out[i] = pack_r11g11b10f(in[i]);
+    }
+#endif
+}
+
+inline void
+unpack_r11g11b10f(uint32_t const* in, float3* out, size_t count) noexcept {
+#if NUM_SIMD_SSE
+    details::packed_float::unpack(in, out, count, details::packed_float::unpack_r11g11b10f);
+#else
+    for (size_t i = 0; i < count; i++) {
+        out[i] = unpack_r11g11b10f(in[i]);
+    }
+#endif
+}
+
+} // namespace numeric
+
+#endif
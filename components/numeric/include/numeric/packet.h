@@ -0,0 +1,291 @@
+#ifndef CHROMA_NUMERIC_PACKET_H
+#define CHROMA_NUMERIC_PACKET_H
+
+#include "mat3.h"
+#include "mat4.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "details/compiler.h"
+#include "details/fast_simd.h"
+#include "details/simd.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace numeric {
+namespace details {
+
+/*
+ * Packet<N> holds N floats, one per SIMD lane. It supports the usual arithmetic so it can
+ * be used as the component type of the vector templates, which gives structure-of-arrays
+ * types: Vector3<Packet<8>> is 8 float3 stored as { x[8], y[8], z[8] }, and every operation
+ * on it processes the 8 elements at once.
+ *
+ * Packets are meant to live in registers and on the stack; the storage is a plain float
+ * array and is only 4-byte aligned, the kernels use unaligned loads and stores.
+ */
+template<size_t N>
+class Packet {
+    typedef typename simd::native_register<N>::type native;
+    typedef typename simd::native_register<N>::traits traits;
+    static constexpr size_t WIDTH = traits::WIDTH;
+    static_assert(N % WIDTH == 0, "packet size must be a multiple of the register width");
+
+public:
+    typedef float value_type;
+    typedef size_t size_type;
+    static constexpr size_t SIZE = N;
+
+    float v[N];
+
+    Packet() = default;
+
+    // broadcast, like the scalar constructors of the vector types
+    Packet(float s) noexcept {
+        for (size_t i = 0; i < N; i += WIDTH) {
+            traits::store(v + i, traits::splat(s));
+        }
+    }
+
+    static Packet load(float const* p) noexcept {
+        Packet r;
+        for (size_t i = 0; i < N; i += WIDTH) {
+            traits::store(r.v + i, traits::load(p + i));
+        }
+        return r;
+    }
+
+    void store(float* p) const noexcept {
+        for (size_t i = 0; i < N; i += WIDTH) {
+            traits::store(p + i, traits::load(v + i));
+        }
+    }
+
+    inline constexpr size_type size() const { return SIZE; }
+
+    inline constexpr
+    float const&
+    operator[](size_t i) const {
+        assert(i < SIZE);
+        return v[i];
+    }
+
+    inline constexpr
+    float&
+    operator[](size_t i) {
+        assert(i < SIZE);
+        return v[i];
+    }
+
+    template<typename OP>
+    static Packet map(const Packet& a, OP op) noexcept {
+        Packet r;
+        for (size_t i = 0; i < N; i += WIDTH) {
+            traits::store(r.v + i, op(traits::load(a.v + i)));
+        }
+        return r;
+    }
+
+    template<typename OP>
+    static Packet map(const Packet& a, const Packet& b, OP op) noexcept {
+        Packet r;
+        for (size_t i = 0; i < N; i += WIDTH) {
+            traits::store(r.v + i, op(traits::load(a.v + i), traits::load(b.v + i)));
+        }
+        return r;
+    }
+
+    template<typename OP>
+    static Packet map(const Packet& a, const Packet& b, const Packet& c, OP op) noexcept {
+        Packet r;
+        for (size_t i = 0; i < N; i += WIDTH) {
+            traits::store(r.v + i,
+                    op(traits::load(a.v + i), traits::load(b.v + i), traits::load(c.v + i)));
+        }
+        return r;
+    }
+
+    template<typename OP>
+    static Packet map(const Packet& a, const Packet& b, const Packet& c, const Packet& d,
+            OP op) noexcept {
+        Packet r;
+        for (size_t i = 0; i < N; i += WIDTH) {
+            traits::store(r.v + i, op(traits::load(a.v + i), traits::load(b.v + i),
+                    traits::load(c.v + i), traits::load(d.v + i)));
+        }
+        return r;
+    }
+
+    Packet& operator+=(const Packet& rhs) noexcept { return *this = *this + rhs; }
+    Packet& operator-=(const Packet& rhs) noexcept { return *this = *this - rhs; }
+    Packet& operator*=(const Packet& rhs) noexcept { return *this = *this * rhs; }
+    Packet& operator/=(const Packet& rhs) noexcept { return *this = *this / rhs; }
+
+    Packet operator-() const noexcept {
+        return map(*this, [](native a) { return simd::neg(a); });
+    }
+
+    friend inline NUM_PURE Packet operator+(const Packet& a, const Packet& b) noexcept {
+        return map(a, b, [](native x, native y) { return simd::add(x, y); });
+    }
+    friend inline NUM_PURE Packet operator-(const Packet& a, const Packet& b) noexcept {
+        return map(a, b, [](native x, native y) { return simd::sub(x, y); });
+    }
+    friend inline NUM_PURE Packet operator*(const Packet& a, const Packet& b) noexcept {
+        return map(a, b, [](native x, native y) { return simd::mul(x, y); });
+    }
+    friend inline NUM_PURE Packet operator/(const Packet& a, const Packet& b) noexcept {
+        return map(a, b, [](native x, native y) { return simd::div(x, y); });
+    }
+
+    friend inline NUM_PURE Packet min(const Packet& a, const Packet& b) noexcept {
+        return map(a, b, [](native x, native y) { return simd::min(x, y); });
+    }
+    friend inline NUM_PURE Packet max(const Packet& a, const Packet& b) noexcept {
+        return map(a, b, [](native x, native y) { return simd::max(x, y); });
+    }
+    friend inline NUM_PURE Packet abs(const Packet& a) noexcept {
+        return map(a, [](native x) { return simd::abs(x); });
+    }
+    friend inline NUM_PURE Packet sqrt(const Packet& a) noexcept {
+        return map(a, [](native x) { return simd::sqrt(x); });
+    }
+
+    // (a < b) ? x : y, per lane
+    friend inline NUM_PURE Packet select_lt(const Packet& a, const Packet& b,
+            const Packet& x, const Packet& y) noexcept {
+        return map(a, b, x, y, [](native a, native b, native x, native y) {
+            return simd::select(simd::lt(a, b), x, y);
+        });
+    }
+
+    // bit i is set when lane i has its sign bit set (negative, -0 or a negative nan)
+    friend inline NUM_PURE uint32_t sign_bits(const Packet& a) noexcept {
+        static_assert(N <= 32, "sign_bits() needs at most 32 lanes");
+        uint32_t r = 0;
+        for (size_t i = 0; i < N; i += WIDTH) {
+            r |= simd::sign_bits(traits::load(a.v + i)) << i;
+        }
+        return r;
+    }
+
+    // a * b + c, fused when the target supports it
+    friend inline NUM_PURE Packet madd(const Packet& a, const Packet& b, const Packet& c) noexcept {
+        return map(a, b, c, [](native x, native y, native z) { return simd::madd(x, y, z); });
+    }
+};
+
+template<size_t N>
+constexpr size_t Packet<N>::SIZE;
+
+// matrix * column-vector on packets, each lane is transformed by the same matrix
+template<size_t N>
+inline NUM_PURE
+Vector4<Packet<N>>
+operator*(const Matrix44<float>& lhs, const Vector4<Packet<N>>& rhs) {
+    Vector4<Packet<N>> result;
+    for (size_t row = 0; row < 4; ++row) {
+        Packet<N> r = Packet<N>(lhs[0][row]) * rhs.x;
+        r = madd(Packet<N>(lhs[1][row]), rhs.y, r);
+        r = madd(Packet<N>(lhs[2][row]), rhs.z, r);
+        r = madd(Packet<N>(lhs[3][row]), rhs.w, r);
+        result[row] = r;
+    }
+    return result;
+}
+
+template<size_t N>
+inline NUM_PURE
+Vector3<Packet<N>>
+operator*(const Matrix33<float>& lhs, const Vector3<Packet<N>>& rhs) {
+    Vector3<Packet<N>> result;
+    for (size_t row = 0; row < 3; ++row) {
+        Packet<N> r = Packet<N>(lhs[0][row]) * rhs.x;
+        r = madd(Packet<N>(lhs[1][row]), rhs.y, r);
+        r = madd(Packet<N>(lhs[2][row]), rhs.z, r);
+        result[row] = r;
+    }
+    return result;
+}
+
+// (lhs * { rhs, 1 }).xyz, i.e. lhs is assumed to be affine
+template<size_t N>
+inline NUM_PURE
+Vector3<Packet<N>>
+transform_point(const Matrix44<float>& lhs, const Vector3<Packet<N>>& rhs) {
+    Vector3<Packet<N>> result;
+    for (size_t row = 0; row < 3; ++row) {
+        Packet<N> r = madd(Packet<N>(lhs[0][row]), rhs.x, Packet<N>(lhs[3][row]));
+        r = madd(Packet<N>(lhs[1][row]), rhs.y, r);
+        r = madd(Packet<N>(lhs[2][row]), rhs.z, r);
+        result[row] = r;
+    }
+    return result;
+}
+
+// packet width used by the batch kernels
+static constexpr size_t NATIVE_PACKET_SIZE = NUM_SIMD_AVX ? 8 : 4;
+
+}  // namespace details
+
+/*
+ * Packet versions of the fast:: functions, every lane is computed independently. Unlike the
+ * scalar versions in fast.h they work on the full range given below and have a bounded error,
+ * checked by test_fast_packet.cpp over every float of their domain.
+ *
+ *  function      domain                       max error
+ *  sin, cos      |x| <= 8192                  1.2e-7 absolute
+ *  exp2          [-126, 127]                  2 ulp (x <= -127 gives 0, x >= 127 gives 2^127)
+ *  log2          positive normal floats       2 ulp
+ *  pow(x, y)     x positive normal            (2 + |y * log2(x)|) ulp
+ *  isqrt         positive normal floats       6 ulp
+ *
+ * Other inputs give unspecified results.
+ */
+namespace fast {
+
+template<size_t N>
+inline NUM_PURE details::Packet<N> sin(const details::Packet<N>& x) noexcept {
+    return details::Packet<N>::map(x, [](auto v) { return details::simd::fast_sin(v); });
+}
+
+template<size_t N>
+inline NUM_PURE details::Packet<N> cos(const details::Packet<N>& x) noexcept {
+    return details::Packet<N>::map(x, [](auto v) { return details::simd::fast_cos(v); });
+}
+
+template<size_t N>
+inline NUM_PURE details::Packet<N> exp2(const details::Packet<N>& x) noexcept {
+    return details::Packet<N>::map(x, [](auto v) { return details::simd::fast_exp2(v); });
+}
+
+template<size_t N>
+inline NUM_PURE details::Packet<N> log2(const details::Packet<N>& x) noexcept {
+    return details::Packet<N>::map(x, [](auto v) { return details::simd::fast_log2(v); });
+}
+
+template<size_t N>
+inline NUM_PURE details::Packet<N> pow(const details::Packet<N>& x,
+        const details::Packet<N>& y) noexcept {
+    return details::Packet<N>::map(x, y,
+            [](auto a, auto b) { return details::simd::fast_pow(a, b); });
+}
+
+template<size_t N>
+inline NUM_PURE details::Packet<N> isqrt(const details::Packet<N>& x) noexcept {
+    return details::Packet<N>::map(x, [](auto v) { return details::simd::rsqrt(v); });
+}
+
+} // namespace fast
+
+typedef details::Packet<4> floatx4;
+typedef details::Packet<8> floatx8;
+typedef details::Vector3<floatx4> float3x4;
+typedef details::Vector4<floatx4> float4x4;
+typedef details::Vector3<floatx8> float3x8;
+typedef details::Vector4<floatx8> float4x8;
+
+}  // namespace numeric
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef CHROMA_NUMERIC_PACKING_H
+#define CHROMA_NUMERIC_PACKING_H
+
+#include "batch.h"
+#include "mat3.h"
+#include "norm.h"
+#include "packet.h"
+#include "quat.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "details/compiler.h"
+
+#include <cmath>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace numeric {
+
+/*
+ * Octahedral encoding of unit vectors (Meyer et al. 2010, Cigolle et al. 2014): the vector is
+ * projected on the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper
+ * one, giving a point of the [-1, 1] square. That point is stored as 2 snorm components.
+ *
+ *  pack_oct16     2 x snorm8,  max error 1.2 degrees
+ *  pack_oct32     2 x snorm16, max error 0.005 degrees
+ *
+ * The errors are measured by test_packing.cpp. The input need not be normalized but must not
+ * be zero, the unpacked vectors are normalized.
+ */
+inline NUM_PURE
+float2
+oct_encode(float3 n) noexcept {
+    n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (n.z < 0) {
+        return float2((1.0f - std::abs(n.y)) * (n.x < 0 ? -1.0f : 1.0f),
+                      (1.0f - std::abs(n.x)) * (n.y < 0 ? -1.0f : 1.0f));
+    }
+    return n.xy;
+}
+
+inline NUM_PURE
+float3
+oct_decode(float2 p) noexcept {
+    float3 n(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+    // unfold the lower half
+    float const t = std::max(-n.z, 0.0f);
+    n.x += n.x < 0 ? t : -t;
+    n.y += n.y < 0 ? t : -t;
+    return normalize(n);
+}
+
+inline byte2 pack_oct16(float3 n) noexcept {
+    float2 const p = oct_encode(n);
+    return byte2{ pack_snorm8(p.x), pack_snorm8(p.y) };
+}
+
+inline short2 pack_oct32(float3 n) noexcept {
+    return pack_snorm16(oct_encode(n));
+}
+
+inline float3 unpack_oct16(byte2 v) noexcept {
+    return oct_decode(float2(unpack_snorm8(v.x), unpack_snorm8(v.y)));
+}
+
+inline float3 unpack_oct32(short2 v) noexcept {
+    return oct_decode(float2(unpack_snorm16(v.x), unpack_snorm16(v.y)));
+}
+
+/*
+ * QTangent: a tangent frame stored as a quaternion, see mat3f::pack_tangent_frame(). The
+ * columns of tbn are the tangent, bitangent and normal, the handedness is kept in the sign of
+ * w: it is negative when bitangent = cross(normal, tangent).
+ *
+ *  pack_qtangent8      4 x snorm8,  max error 1.1 degrees
+ *  pack_qtangent16     4 x snorm16, max error 0.005 degrees
+ *
+ * unpack_qtangent8/16 return the frame with the bitangent reflected back.
+ */
+inline byte4 pack_qtangent8(const mat3f& tbn) noexcept {
+    quatf const q = mat3f::pack_tangent_frame(tbn, sizeof(int8_t));
+    return pack_snorm8(float4(q.x, q.y, q.z, q.w));
+}
+
+inline short4 pack_qtangent16(const mat3f& tbn) noexcept {
+    quatf const q = mat3f::pack_tangent_frame(tbn, sizeof(int16_t));
+    return pack_snorm16(float4(q.x, q.y, q.z, q.w));
+}
+
+namespace details {
+
+inline NUM_PURE
+mat3f
+qtangent_decode(float4 q) noexcept {
+    // the columns are tangent, cross(normal, tangent) and normal
+    mat3f m(quatf(q.w, q.x, q.y, q.z));
+    if (q.w > 0) {
+        m[1] = -m[1];
+    }
+    return m;
+}
+
+} // namespace details
+
+inline mat3f unpack_qtangent8(byte4 v) noexcept {
+    return details::qtangent_decode(unpack_snorm8(v));
+}
+
+inline mat3f unpack_qtangent16(short4 v) noexcept {
+    return details::qtangent_decode(unpack_snorm16(v));
+}
+
+namespace details {
+namespace batch {
+
+    typedef Vector2<packet> packet2;
+
+    // oct_encode() on packets
+    inline packet2 oct_encode(packet3 n) noexcept {
+        packet const zero(0.0f), one(1.0f);
+        packet const s = one / (abs(n.x) + abs(n.y) + abs(n.z));
+        n = packet3(n.x * s, n.y * s, n.z * s);
+        packet const fx = (one - abs(n.y)) * select_lt(n.x, zero, -one, one);
+        packet const fy = (one - abs(n.x)) * select_lt(n.y, zero, -one, one);
+        return packet2(select_lt(n.z, zero, fx, n.x), select_lt(n.z, zero, fy, n.y));
+    }
+
+    // oct_decode() on packets
+    inline packet3 oct_decode(packet2 const& p) noexcept {
+        packet const zero(0.0f);
+        packet const z = packet(1.0f) - abs(p.x) - abs(p.y);
+        packet const t = max(-z, zero);
+        return normalize_packet(packet3(p.x + select_lt(p.x, zero, t, -t),
+                                        p.y + select_lt(p.y, zero, t, -t), z));
+    }
+
+    // std::round(clamp(v, -1, 1) * scale)
+    inline packet quantize(packet const& v, float scale) noexcept {
+        packet const q = min(max(v, packet(-1.0f)), packet(1.0f)) * packet(scale);
+        packet const r = packet::map(abs(q) + packet(0.5f),
+                [](auto x) { return simd::floor(x); });
+        return select_lt(q, packet(0.0f), -r, r);
+    }
+
+    template<typename T>
+    inline void pack_oct(float3 const* in, Vector2<T>* out, size_t count, float scale) noexcept {
+        for (size_t i = 0; i < count; i += packet::SIZE) {
+            size_t const n = std::min(packet::SIZE, count - i);
+            packet2 const p = oct_encode(load(in + i, n));
+            packet const x = quantize(p.x, scale);
+            packet const y = quantize(p.y, scale);
+            for (size_t j = 0; j < n; j++) {
+                out[i + j] = Vector2<T>{ static_cast<T>(x[j]), static_cast<T>(y[j]) };
+            }
+        }
+    }
+
+    template<typename T>
+    inline void unpack_oct(Vector2<T> const* in, float3* out, size_t count, float scale) noexcept {
+        packet const s(1.0f / scale);
+        for (size_t i = 0; i < count; i += packet::SIZE) {
+            size_t const n = std::min(packet::SIZE, count - i);
+            packet2 p(packet(0.0f), packet(0.0f));
+            for (size_t j = 0; j < n; j++) {
+                p.x[j] = in[i + j].x;
+                p.y[j] = in[i + j].y;
+            }
+            // the snorm minimum is clamped to -1
+            packet const lo(-1.0f);
+            store(out + i, oct_decode(packet2(max(p.x * s, lo), max(p.y * s, lo))), n);
+        }
+    }
+
+    // normal and tangent of unpack_qtangent(), with the bitangent sign in the tangent's w
+    template<typename T>
+    inline void unpack_qtangent(Vector4<T> const* in, float3* normals, float4* tangents,
+            size_t count, float scale) noexcept {
+        packet const lo(-1.0f), zero(0.0f), one(1.0f);
+        packet const is(1.0f / scale);
+        for (size_t i = 0; i < count; i += packet::SIZE) {
+            size_t const n = std::min(packet::SIZE, count - i);
+            packet4 v(zero, zero, zero, one);
+            for (size_t j = 0; j < n; j++) {
+                for (size_t c = 0; c < 4; c++) {
+                    v[c][j] = in[i + j][c];
+                }
+            }
+            v = packet4(max(v.x * is, lo), max(v.y * is, lo),
+                        max(v.z * is, lo), max(v.w * is, lo));
+            // columns 0 and 2 of the Matrix33 quaternion constructor
+            packet const s = packet(2.0f) / dot_quat(v, v);
+            packet const x = s * v.x;
+            packet const y = s * v.y;
+            packet const z = s * v.z;
+            packet3 const nrm(madd(x, v.z, y * v.w), madd(y, v.z, -x * v.w),
+                    one - madd(x, v.x, y * v.y));
+            packet3 const tan(one - madd(y, v.y, z * v.z), madd(x, v.y, z * v.w),
+                    madd(x, v.z, -y * v.w));
+            packet const sign = select_lt(v.w, zero, one, -one);
+            for (size_t j = 0; j < n; j++) {
+                normals[i + j] = float3(nrm.x[j], nrm.y[j], nrm.z[j]);
+                tangents[i + j] = float4(tan.x[j], tan.y[j], tan.z[j], sign[j]);
+            }
+        }
+    }
+
+} // namespace batch
+} // namespace details
+
+/*
+ * Array versions of the functions above. The octahedral ones run on packets, their results
+ * can differ from the scalar functions by one quantization step because of the different
+ * rounding of the intermediate values.
+ *
+ * unpack_qtangents8/16 give the normal and the tangent of each frame, the w component of
+ * the tangent is the bitangent sign: bitangent = cross(normal, tangent.xyz) * tangent.w.
+ */
+inline void pack_oct16(float3 const* in, byte2* out, size_t count) noexcept {
+    details::batch::pack_oct(in, out, count, 127.0f);
+}
+
+inline void pack_oct32(float3 const* in, short2* out, size_t count) noexcept {
+    details::batch::pack_oct(in, out, count, 32767.0f);
+}
+
+inline void unpack_oct16(byte2 const* in, float3* out, size_t count) noexcept {
+    details::batch::unpack_oct(in, out, count, 127.0f);
+}
+
+inline void unpack_oct32(short2 const* in, float3* out, size_t count) noexcept {
+    details::batch::unpack_oct(in, out, count, 32767.0f);
+}
+
+inline void pack_qtangents8(mat3f const* in, byte4* out, size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = pack_qtangent8(in[i]);
+    }
+}
+
+inline void pack_qtangents16(mat3f const* in, short4* out, size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = pack_qtangent16(in[i]);
+    }
+}
+
+inline void unpack_qtangents8(byte4 const* in, float3* normals, float4* tangents,
+        size_t count) noexcept {
+    details::batch::unpack_qtangent(in, normals, tangents, count, 127.0f);
+}
+
+inline void unpack_qtangents16(short4 const* in, float3* normals, float4* tangents,
+        size_t count) noexcept {
+    details::batch::unpack_qtangent(in, normals, tangents, count, 32767.0f);
+}
+
+} // namespace numeric
+
+#endif
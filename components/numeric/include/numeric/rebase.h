@@ -0,0 +1,73 @@
+#ifndef CHROMA_NUMERIC_REBASE_H
+#define CHROMA_NUMERIC_REBASE_H
+
+#include "mat4.h"
+#include "vec3.h"
+#include "details/compiler.h"
+#include "details/simd.h"
+
+#include <stddef.h>
+
+namespace numeric {
+
+/*
+ * Camera-relative rendering of large worlds. A float has 24 bits of mantissa, 6 cm of
+ * resolution 1000 km away from the origin, which is enough to make vertices jitter as the
+ * camera moves. The world matrices are kept in double and rebased on the camera position
+ * before going to float: the translations sent to the GPU are then small and only the
+ * subtraction of the origin needs double precision.
+ *
+ *  rebase(world, origin)                   one double world matrix to float
+ *  rebase(world[], origin, out[])          an array of them
+ *  rebase(parent, origin, local[], out[])  float local matrices under a shared double parent
+ *                                          (a tile or an object), in float after one rebase
+ *  rebase_view(view, origin)               the view matrix to use with the rebased matrices
+ *
+ * The world matrices must be affine. origin is usually the camera position, rounded or not,
+ * and must be the same for all the matrices of a frame.
+ */
+inline NUM_PURE
+mat4f
+rebase(const mat4& world, const double3& origin) noexcept {
+#if NUM_SIMD_SSE
+    mat4f result(mat4f::NO_INIT);
+    details::simd::rebase_m4(world.as_array(), &origin.x, &result[0][0]);
+    return result;
+#else
+    return mat4f(float4(world[0]), float4(world[1]), float4(world[2]),
+                 float4(float3(world[3].xyz - origin), 1.0f));
+#endif
+}
+
+// out[i] = rebase(world[i], origin)
+inline void
+rebase(mat4 const* world, const double3& origin, mat4f* out, size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = rebase(world[i], origin);
+    }
+}
+
+/*
+ * out[i] = rebase(parent * local[i], origin), with the product done in float after
+ * rebasing the parent. As precise as long as the translations of the local matrices stay
+ * small next to the distance to the origin, and as fast as a float matrix product.
+ */
+inline void
+rebase(const mat4& parent, const double3& origin, mat4f const* local, mat4f* out,
+        size_t count) noexcept {
+    mat4f const p = rebase(parent, origin);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = p * local[i];
+    }
+}
+
+// view * translate(origin) in float, the view matrix of the matrices rebased on origin
+inline NUM_PURE
+mat4f
+rebase_view(const mat4& view, const double3& origin) noexcept {
+    return mat4f(view * mat4::translate(origin));
+}
+
+} // namespace numeric
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef CHROMA_NUMERIC_SH_H
+#define CHROMA_NUMERIC_SH_H
+
+#include "batch.h"
+#include "packet.h"
+#include "vec3.h"
+#include "details/compiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stddef.h>
+#include <vector>
+
+namespace numeric {
+
+/*
+ * Real spherical harmonics of the first 2 or 3 bands (4 or 9 RGB coefficients), enough to
+ * store irradiance (Ramamoorthi and Hanrahan, An Efficient Representation for Irradiance
+ * Environment Maps, 2001). The coefficient of band l and order -l <= m <= l is at index
+ * l * (l + 1) + m, the basis has no Condon-Shortley phase:
+ *
+ *  Y00 = 0.282095
+ *  Y1m = 0.488603 (y, z, x)
+ *  Y2m = 1.092548 (xy, yz), 0.315392 (3z^2 - 1), 1.092548 xz, 0.546274 (x^2 - y^2)
+ */
+template<size_t BANDS>
+struct SphericalHarmonics {
+    static_assert(BANDS == 2 || BANDS == 3, "2 or 3 bands");
+    static constexpr size_t COUNT = BANDS * BANDS;
+
+    float3 c[COUNT] = {};
+
+    inline float3 const& operator[](size_t i) const noexcept { return c[i]; }
+    inline float3& operator[](size_t i) noexcept { return c[i]; }
+
+    // the function in the unit direction d
+    float3 evaluate(const float3& d) const noexcept;
+};
+
+template<size_t BANDS>
+constexpr size_t SphericalHarmonics<BANDS>::COUNT;
+
+typedef SphericalHarmonics<2> sh2;
+typedef SphericalHarmonics<3> sh3;
+
+namespace details {
+
+    // the basis in the unit direction (x, y, z), T is float or a packet
+    template<size_t BANDS, typename T>
+    inline void sh_basis(T const& x, T const& y, T const& z, T* out) noexcept {
+        out[0] = T(0.282094792f);
+        out[1] = T(0.488602512f) * y;
+        out[2] = T(0.488602512f) * z;
+        out[3] = T(0.488602512f) * x;
+        if (BANDS > 2) {
+            out[4] = T(1.092548431f) * x * y;
+            out[5] = T(1.092548431f) * y * z;
+            out[6] = T(0.315391565f) * (T(3.0f) * z * z - T(1.0f));
+            out[7] = T(1.092548431f) * x * z;
+            out[8] = T(0.546274215f) * (x * x - y * y);
+        }
+    }
+
+} // namespace details
+
+template<size_t BANDS>
+inline void sh_basis(const float3& d, float out[BANDS * BANDS]) noexcept {
+    details::sh_basis<BANDS>(d.x, d.y, d.z, out);
+}
+
+template<size_t BANDS>
+inline float3 SphericalHarmonics<BANDS>::evaluate(const float3& d) const noexcept {
+    float y[COUNT];
+    sh_basis<BANDS>(d, y);
+    float3 r(0.0f);
+    for (size_t i = 0; i < COUNT; i++) {
+        r += c[i] * y[i];
+    }
+    return r;
+}
+
+/*
+ * Irradiance from the radiance sh, the convolution with the clamped cosine lobe max(cos, 0)
+ * scales each band l by A0 = pi, A1 = 2pi/3 and A2 = pi/4. Divided by pi, it is the radiance
+ * reflected by a white Lambertian surface.
+ */
+template<size_t BANDS>
+inline NUM_PURE
+SphericalHarmonics<BANDS>
+convolve_cosine(SphericalHarmonics<BANDS> sh) noexcept {
+    float const a[3] = { float(M_PI), float(2.0 * M_PI / 3.0), float(M_PI / 4.0) };
+    for (size_t i = 0; i < sh.COUNT; i++) {
+        // i is in band floor(sqrt(i))
+        sh[i] *= a[i == 0 ? 0 : i < 4 ? 1 : 2];
+    }
+    return sh;
+}
+
+/*
+ * Windowing attenuates the higher bands to reduce the ringing of the truncated series, at the
+ * cost of some blur (Sloan, Stupid Spherical Harmonics Tricks, 2008). Band l is scaled by
+ *
+ *  hanning     (1 + cos(pi l / w)) / 2, 0 when l > w
+ *  lanczos     sin(pi l / w) / (pi l / w), 0 when l > w
+ *
+ * The window width w is usually between BANDS and 2 * BANDS, band 0 is never changed.
+ */
+template<size_t BANDS>
+inline NUM_PURE
+SphericalHarmonics<BANDS>
+window_hanning(SphericalHarmonics<BANDS> sh, float w) noexcept {
+    for (size_t l = 1; l < BANDS; l++) {
+        float const s = l > w ? 0.0f : 0.5f * (1.0f + std::cos(float(M_PI) * l / w));
+        for (size_t i = l * l; i < (l + 1) * (l + 1); i++) {
+            sh[i] *= s;
+        }
+    }
+    return sh;
+}
+
+template<size_t BANDS>
+inline NUM_PURE
+SphericalHarmonics<BANDS>
+window_lanczos(SphericalHarmonics<BANDS> sh, float w) noexcept {
+    for (size_t l = 1; l < BANDS; l++) {
+        float const x = float(M_PI) * l / w;
+        float const s = l > w ? 0.0f : std::sin(x) / x;
+        for (size_t i = l * l; i < (l + 1) * (l + 1); i++) {
+            sh[i] *= s;
+        }
+    }
+    return sh;
+}
+
+/*
+ * RGB float cubemap, 6 square faces of size x size texels stored by rows, in the +x, -x, +y,
+ * -y, +z, -z order. The faces are oriented as in the GL specification with t going down the
+ * rows. The cubemap doesn't own the texels.
+ */
+struct Cubemap {
+    static constexpr size_t FACE_COUNT = 6;
+
+    float3 const* faces[FACE_COUNT];
+    size_t size;
+
+    // unit direction through the center of texel (x, y) of face
+    float3 direction(size_t face, size_t x, size_t y) const noexcept;
+};
+
+namespace details {
+
+    // direction of the point (u, v) of face, in [-1, 1] and not normalized
+    template<typename T>
+    inline Vector3<T> cube_direction(size_t face, T const& u, T const& v) noexcept {
+        T const one(1.0f);
+        switch (face) {
+            case 0:  return Vector3<T>(one, -v, -u);
+            case 1:  return Vector3<T>(-one, -v, u);
+            case 2:  return Vector3<T>(u, one, v);
+            case 3:  return Vector3<T>(u, -one, -v);
+            case 4:  return Vector3<T>(u, -v, one);
+            default: return Vector3<T>(-u, -v, -one);
+        }
+    }
+
+} // namespace details
+
+inline float3 Cubemap::direction(size_t face, size_t x, size_t y) const noexcept {
+    float const s = 2.0f / size;
+    float const u = (x + 0.5f) * s - 1.0f;
+    float const v = (y + 0.5f) * s - 1.0f;
+    return normalize(details::cube_direction(face, u, v));
+}
+
+/*
+ * Partial projection of a cubemap, see project_cubemap_rows(). The texels are weighted by the
+ * solid angle they subtend, 4 / (size^2 (1 + u^2 + v^2)^(3/2)), whose sum is rescaled to 4pi
+ * by result().
+ */
+template<size_t BANDS>
+struct ShProjection {
+    SphericalHarmonics<BANDS> sum;
+    float weight = 0.0f;
+
+    void add(const ShProjection& rhs) noexcept {
+        for (size_t i = 0; i < sum.COUNT; i++) {
+            sum[i] += rhs.sum[i];
+        }
+        weight += rhs.weight;
+    }
+
+    SphericalHarmonics<BANDS> result() const noexcept {
+        SphericalHarmonics<BANDS> sh;
+        float const s = weight > 0.0f ? float(4.0 * M_PI) / weight : 0.0f;
+        for (size_t i = 0; i < sh.COUNT; i++) {
+            sh[i] = sum[i] * s;
+        }
+        return sh;
+    }
+};
+
+/*
+ * Adds the projection of the rows [first, first + count) of the cubemap to out. The rows of
+ * all the faces are numbered in sequence, face f has rows f * size to (f + 1) * size - 1. Each
+ * row is processed NATIVE_PACKET_SIZE texels at a time.
+ *
+ * Disjoint ranges can be projected concurrently, e.g. from a job system, and added together.
+ */
+template<size_t BANDS>
+inline void
+project_cubemap_rows(const Cubemap& cm, size_t first, size_t count,
+        ShProjection<BANDS>& out) noexcept {
+    using namespace details::batch;
+    constexpr size_t COUNT = SphericalHarmonics<BANDS>::COUNT;
+    size_t const size = cm.size;
+    float const s = 2.0f / size;
+    packet const area(s * s);
+    packet offsets;
+    for (size_t j = 0; j < packet::SIZE; j++) {
+        offsets[j] = (j + 0.5f) * s - 1.0f;
+    }
+
+    for (size_t row = first; row < first + count; row++) {
+        size_t const face = row / size;
+        size_t const y = row % size;
+        float3 const* texels = cm.faces[face] + y * size;
+        packet const v((y + 0.5f) * s - 1.0f);
+
+        packet acc[COUNT][3];
+        std::fill(&acc[0][0], &acc[0][0] + COUNT * 3, packet(0.0f));
+        packet weights(0.0f);
+        for (size_t x = 0; x < size; x += packet::SIZE) {
+            size_t const n = std::min(packet::SIZE, size - x);
+            packet const u = offsets + packet(x * s);
+            packet const r = packet(1.0f) / sqrt(packet(1.0f) + u * u + v * v);
+            packet w = area * r * r * r;
+            for (size_t j = n; j < packet::SIZE; j++) {
+                w[j] = 0.0f;
+            }
+            packet3 const d = details::cube_direction(face, u, v);
+            packet basis[COUNT];
+            details::sh_basis<BANDS>(d.x * r, d.y * r, d.z * r, basis);
+            packet3 const c = load(texels + x, n);
+            packet const wc[3] = { c.x * w, c.y * w, c.z * w };
+            for (size_t i = 0; i < COUNT; i++) {
+                acc[i][0] = madd(basis[i], wc[0], acc[i][0]);
+                acc[i][1] = madd(basis[i], wc[1], acc[i][1]);
+                acc[i][2] = madd(basis[i], wc[2], acc[i][2]);
+            }
+            weights += w;
+        }
+
+        for (size_t j = 0; j < packet::SIZE; j++) {
+            for (size_t i = 0; i < COUNT; i++) {
+                out.sum[i] += float3(acc[i][0][j], acc[i][1][j], acc[i][2][j]);
+            }
+            out.weight += weights[j];
+        }
+    }
+}
+
+/*
+ * Projects the cubemap on the basis, on the calling thread.
+ */
+template<size_t BANDS>
+inline SphericalHarmonics<BANDS>
+project_cubemap(const Cubemap& cm) noexcept {
+    ShProjection<BANDS> p;
+    project_cubemap_rows(cm, 0, Cubemap::FACE_COUNT * cm.size, p);
+    return p.result();
+}
+
+/*
+ * Projects the cubemap in part_count ranges of rows that run(part_count, project) executes:
+ * it must call project(i) once for each i in [0, part_count), in any order and from any
+ * thread, and return once they are all done. The parts are then added in order, so the result
+ * only depends on part_count. With a sys::JobSystem, for instance:
+ *
+ *  project_cubemap<3>(cm, 64, [&js](size_t n, auto const& project) {
+ *      JobSystem::Job* job = js.parallel_for(nullptr, 0, uint32_t(n),
+ *              [&project](uint32_t start, uint32_t count) {
+ *                  for (uint32_t i = start; i < start + count; i++) project(i);
+ *              });
+ *      js.run_and_wait(job);
+ *  });
+ */
+template<size_t BANDS, typename RUN>
+inline SphericalHarmonics<BANDS>
+project_cubemap(const Cubemap& cm, size_t part_count, RUN&& run) {
+    size_t const rows = Cubemap::FACE_COUNT * cm.size;
+    part_count = std::max(size_t(1), std::min(part_count, rows));
+
+    std::vector<ShProjection<BANDS>> parts(part_count);
+    auto const project = [&cm, &parts, rows, part_count](size_t i) {
+        size_t const first = rows * i / part_count;
+        project_cubemap_rows(cm, first, rows * (i + 1) / part_count - first, parts[i]);
+    };
+    run(part_count, project);
+
+    for (size_t i = 1; i < part_count; i++) {
+        parts[0].add(parts[i]);
+    }
+    return parts[0].result();
+}
+
+} // namespace numeric
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef CHROMA_NUMERIC_SKINNING_H
+#define CHROMA_NUMERIC_SKINNING_H
+
+#include "batch.h"
+#include "dualquat.h"
+#include "mat4.h"
+#include "packet.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "details/compiler.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace numeric {
+
+/*
+ * CPU skinning of count vertices with up to 4 influences each: out = sum(weights[k] *
+ * joints[indices[k]] * in). The unused influences must have a zero weight and a valid index,
+ * the weights should add up to 1. The normals are optional (nullptr), they are transformed
+ * by the inverse transpose of the blended 3x3, the rotation for skin_dualquat(), and
+ * normalized.
+ *
+ * skin_linear()    linear blend skinning of the joint matrices, which must be affine.
+ * skin_dualquat()  dual quaternion linear blending, see blend() in dualquat.h. Rigid joint
+ *                  transforms only, but it keeps the volume around twisting joints.
+ *
+ * The joints of each vertex are blended with the 4-wide vector types, then the vertices are
+ * transformed NATIVE_PACKET_SIZE at a time.
+ */
+inline void
+skin_linear(mat4f const* joints, ushort4 const* indices, float4 const* weights,
+        float3 const* in_positions, float3 const* in_normals,
+        float3* out_positions, float3* out_normals, size_t count) noexcept {
+    using namespace details::batch;
+    for (size_t i = 0; i < count; i += packet::SIZE) {
+        size_t const n = std::min(packet::SIZE, count - i);
+        // the 3 upper rows of the blended matrices, by columns, one lane per vertex
+        float m[12][packet::SIZE] = {};
+        for (size_t j = 0; j < n; j++) {
+            ushort4 const index = indices[i + j];
+            float4 const w = weights[i + j];
+            mat4f const b = joints[index.x] * w.x + joints[index.y] * w.y +
+                            joints[index.z] * w.z + joints[index.w] * w.w;
+            for (size_t c = 0; c < 4; c++) {
+                m[c * 3 + 0][j] = b[c].x;
+                m[c * 3 + 1][j] = b[c].y;
+                m[c * 3 + 2][j] = b[c].z;
+            }
+        }
+
+        packet3 const c0(packet::load(m[0]), packet::load(m[1]), packet::load(m[2]));
+        packet3 const c1(packet::load(m[3]), packet::load(m[4]), packet::load(m[5]));
+        packet3 const c2(packet::load(m[6]), packet::load(m[7]), packet::load(m[8]));
+        packet3 const c3(packet::load(m[9]), packet::load(m[10]), packet::load(m[11]));
+        packet3 const p = load(in_positions + i, n);
+        store(out_positions + i, scale(c0, p.x) + scale(c1, p.y) + scale(c2, p.z) + c3, n);
+        if (in_normals) {
+            // the cofactors are the inverse transpose times the determinant, times it again
+            // for its sign, so that the scale doesn't matter once normalized
+            packet3 const x0 = cross(c1, c2);
+            packet3 const x1 = cross(c2, c0);
+            packet3 const x2 = cross(c0, c1);
+            packet const det = dot(c0, x0);
+            packet3 const v = load(in_normals + i, n);
+            store(out_normals + i,
+                    normalize_packet(scale(scale(x0, v.x) + scale(x1, v.y) + scale(x2, v.z),
+                            det)), n);
+        }
+    }
+}
+
+inline void
+skin_dualquat(dualquatf const* joints, ushort4 const* indices, float4 const* weights,
+        float3 const* in_positions, float3 const* in_normals,
+        float3* out_positions, float3* out_normals, size_t count) noexcept {
+    using namespace details::batch;
+    for (size_t i = 0; i < count; i += packet::SIZE) {
+        size_t const n = std::min(packet::SIZE, count - i);
+        // the blended dual quaternions, not normalized, one lane per vertex
+        float q[8][packet::SIZE];
+        for (size_t j = 0; j < n; j++) {
+            ushort4 const index = indices[i + j];
+            float4 const w = weights[i + j];
+            dualquatf const& first = joints[index.x];
+            dualquatf b = first * w.x;
+            for (size_t k = 1; k < 4; k++) {
+                // on the same side as the first influence
+                dualquatf const& d = joints[index[k]];
+                b = b + d * (dot(first.real, d.real) < 0 ? -w[k] : w[k]);
+            }
+            for (size_t c = 0; c < 4; c++) {
+                q[c][j] = b.real[c];
+                q[c + 4][j] = b.dual[c];
+            }
+        }
+        // the unused lanes get the identity
+        for (size_t j = n; j < packet::SIZE; j++) {
+            for (size_t c = 0; c < 8; c++) {
+                q[c][j] = c == 3 ? 1.0f : 0.0f;
+            }
+        }
+
+        // normalized, the translation is 2 (dual * conj(real)).xyz
+        packet4 real(packet::load(q[0]), packet::load(q[1]),
+                     packet::load(q[2]), packet::load(q[3]));
+        packet4 dual(packet::load(q[4]), packet::load(q[5]),
+                     packet::load(q[6]), packet::load(q[7]));
+        packet const s = packet(1.0f) / sqrt(dot_quat(real, real));
+        real = scale(real, s);
+        dual = scale(dual, s);
+        packet3 const rv(real.x, real.y, real.z);
+        packet3 const dv(dual.x, dual.y, dual.z);
+        packet3 const t = scale(scale(dv, real.w) - scale(rv, dual.w) + cross(rv, dv),
+                                packet(2.0f));
+
+        store(out_positions + i, rotate(real, load(in_positions + i, n)) + t, n);
+        if (in_normals) {
+            store(out_normals + i, normalize_packet(rotate(real, load(in_normals + i, n))), n);
+        }
+    }
+}
+
+} // namespace numeric
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef CHROMA_NUMERIC_TRANSFORM_H
+#define CHROMA_NUMERIC_TRANSFORM_H
+
+#include "batch.h"
+#include "mat3.h"
+#include "mat4.h"
+#include "quat.h"
+#include "vec3.h"
+#include "details/compiler.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace numeric {
+
+namespace details {
+
+// q * v for a unit quaternion q, without the general inverse
+inline constexpr NUM_PURE
+float3
+rotate_unit(const quatf& q, const float3& v) noexcept {
+    float3 const t = cross(q.xyz, v) * 2.0f;
+    return v + t * q.w + cross(q.xyz, t);
+}
+
+} // namespace details
+
+/*
+ * translate(translation) * rotation * scale, the local transform of a node of a hierarchy.
+ * Unlike a mat4f, the parts can be read back without decomposing. The composition is a
+ * quaternion product and a vector rotation, about 50 multiplies against 64 for a mat4f
+ * product, but their dependency chains are longer: it is slower than the mat4f product while
+ * the data is in cache and only catches up when memory-bound, at 40 bytes a node against 64.
+ * Keep a Transform for what needs the parts, not for the speed of a * b.
+ *
+ * The rotation must be a unit quaternion. Like the matrices, a * b applies b first. The
+ * result is exact when the scale of a is uniform. Otherwise the matrix product would have a
+ * shear that a Transform can't hold, the scales are multiplied and the shear is dropped;
+ * inverse() has the same limitation.
+ */
+struct Transform {
+    float3 translation;
+    quatf rotation;
+    float3 scale;
+
+    // identity
+    constexpr Transform() : translation(0.0f), rotation(1.0f), scale(1.0f) {}
+
+    constexpr Transform(const float3& translation, const quatf& rotation,
+            const float3& scale = float3(1.0f))
+            : translation(translation), rotation(rotation), scale(scale) {}
+
+    // m must be affine and invertible, see decompose() for what happens otherwise
+    explicit Transform(const mat4f& m) {
+        decompose(m, translation, rotation, scale);
+    }
+
+    mat4f to_mat4() const noexcept {
+        mat3f const r(rotation);
+        return mat4f(mat3f(r[0] * scale.x, r[1] * scale.y, r[2] * scale.z), translation);
+    }
+};
+
+inline constexpr NUM_PURE
+float3
+transform_point(const Transform& a, const float3& p) noexcept {
+    return details::rotate_unit(a.rotation, a.scale * p) + a.translation;
+}
+
+inline constexpr NUM_PURE
+float3
+transform_vector(const Transform& a, const float3& v) noexcept {
+    return details::rotate_unit(a.rotation, a.scale * v);
+}
+
+// the normal n transformed by the inverse transpose, normalized
+inline NUM_PURE
+float3
+transform_normal(const Transform& a, const float3& n) noexcept {
+    return normalize(details::rotate_unit(a.rotation, n / a.scale));
+}
+
+#if NUM_SIMD_SSE
+static_assert(sizeof(Transform) == 12 * sizeof(float) &&
+              offsetof(Transform, rotation) == 4 * sizeof(float) &&
+              offsetof(Transform, scale) == 8 * sizeof(float),
+        "simd::compose_trs() expects a padded Transform");
+#endif
+
+inline NUM_PURE
+Transform
+operator*(const Transform& a, const Transform& b) noexcept {
+#if NUM_SIMD_SSE
+    // built from the members, a copy of a whole temporary would stall on the store forwarding
+    float r[12];
+    details::simd::compose_trs(&a.translation.x, &b.translation.x, r);
+    return Transform(float3(r[0], r[1], r[2]), quatf(r[7], r[4], r[5], r[6]),
+                     float3(r[8], r[9], r[10]));
+#else
+    return Transform(details::rotate_unit(a.rotation, a.scale * b.translation) +
+                     a.translation, a.rotation * b.rotation, a.scale * b.scale);
+#endif
+}
+
+inline NUM_PURE
+Transform
+inverse(const Transform& a) noexcept {
+    float3 const s = rcp(a.scale);
+    quatf const r = conj(a.rotation);
+    return Transform(-(s * details::rotate_unit(r, a.translation)), r, s);
+}
+
+/*
+ * Linear interpolation of the translation and the scale, nlerp of the rotation on the short
+ * side. Good enough between animation keys, use slerp() on the rotations for large angles.
+ */
+inline NUM_PURE
+Transform
+lerp(const Transform& a, const Transform& b, float t) noexcept {
+    quatf const q = dot(a.rotation, b.rotation) < 0 ? -b.rotation : b.rotation;
+    return Transform(a.translation + (b.translation - a.translation) * t,
+                     nlerp(a.rotation, q, t), a.scale + (b.scale - a.scale) * t);
+}
+
+/*
+ * world[i] = world[parents[i]] * local[i] for the nodes of a hierarchy, sorted so that the
+ * parents come first: parents[i] < i, or a negative value for the roots which just copy
+ * their local transform. world and local can be the same array.
+ */
+inline void
+local_to_world(int32_t const* parents, Transform const* local, Transform* world,
+        size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        world[i] = parents[i] < 0 ? local[i] : world[parents[i]] * local[i];
+    }
+}
+
+/*
+ * Transforms stored as 10 streams of floats, in the order of their float3 and quatf members,
+ * so that the batch functions below process NATIVE_PACKET_SIZE of them at once. The streams
+ * belong to the caller.
+ */
+struct TransformStreams {
+    float* translation[3];
+    float* rotation[4];
+    float* scale[3];
+};
+
+namespace details {
+namespace batch {
+
+    struct packet_transform {
+        packet3 translation;
+        packet4 rotation;
+        packet3 scale;
+    };
+
+    inline packet_transform load(TransformStreams const& in, size_t offset,
+            size_t count) noexcept {
+        return packet_transform{ load(in.translation, offset, count),
+                                 load_quat(in.rotation, offset, count),
+                                 load(in.scale, offset, count) };
+    }
+
+    inline void store(TransformStreams const& out, size_t offset, packet_transform const& v,
+            size_t count) noexcept {
+        store(out.translation, offset, v.translation, count);
+        store_quat(out.rotation, offset, v.rotation, count);
+        store(out.scale, offset, v.scale, count);
+    }
+
+    // the elements of in at indices[0..count[, one per lane
+    inline packet_transform gather(TransformStreams const& in, int32_t const* indices,
+            size_t count) noexcept {
+        float v[10][packet::SIZE] = {};
+        for (size_t j = 0; j < count; j++) {
+            size_t const k = size_t(indices[j]);
+            for (size_t c = 0; c < 3; c++) {
+                v[c][j] = in.translation[c][k];
+                v[c + 7][j] = in.scale[c][k];
+            }
+            for (size_t c = 0; c < 4; c++) {
+                v[c + 3][j] = in.rotation[c][k];
+            }
+        }
+        return packet_transform{
+                packet3(packet::load(v[0]), packet::load(v[1]), packet::load(v[2])),
+                packet4(packet::load(v[3]), packet::load(v[4]),
+                        packet::load(v[5]), packet::load(v[6])),
+                packet3(packet::load(v[7]), packet::load(v[8]), packet::load(v[9])) };
+    }
+
+    inline void set_lane(packet_transform& dst, packet_transform const& src, size_t j) noexcept {
+        for (size_t c = 0; c < 3; c++) {
+            dst.translation[c][j] = src.translation[c][j];
+            dst.scale[c][j] = src.scale[c][j];
+        }
+        for (size_t c = 0; c < 4; c++) {
+            dst.rotation[c][j] = src.rotation[c][j];
+        }
+    }
+
+    // same as operator*(Transform, Transform)
+    inline NUM_ALWAYS_INLINE packet_transform compose(packet_transform const& a,
+            packet_transform const& b) noexcept {
+        return packet_transform{ rotate(a.rotation, a.scale * b.translation) + a.translation,
+                                 mul_quat(a.rotation, b.rotation),
+                                 a.scale * b.scale };
+    }
+
+} // namespace batch
+} // namespace details
+
+// out[i] = a[i] * b[i], out can be a or b
+inline void
+compose(TransformStreams const& a, TransformStreams const& b, TransformStreams const& out,
+        size_t count) noexcept {
+    using namespace details::batch;
+    // full packets, with the stream pointers kept in registers
+    TransformStreams const sa = a;
+    TransformStreams const sb = b;
+    TransformStreams const so = out;
+    size_t i = 0;
+    for (; i + packet::SIZE <= count; i += packet::SIZE) {
+        store(so, i, compose(load(sa, i, packet::SIZE), load(sb, i, packet::SIZE)),
+                packet::SIZE);
+    }
+    if (i < count) {
+        size_t const n = count - i;
+        store(out, i, compose(load(a, i, n), load(b, i, n)), n);
+    }
+}
+
+/*
+ * local_to_world() on streams. A packet of nodes is composed at once when all their parents
+ * come before it, which is the common case with the nodes sorted by depth, otherwise its
+ * nodes are done one at a time.
+ */
+inline void
+local_to_world(int32_t const* parents, TransformStreams const& local,
+        TransformStreams const& world, size_t count) noexcept {
+    using namespace details::batch;
+    for (size_t i = 0; i < count; i += packet::SIZE) {
+        size_t const n = std::min(packet::SIZE, count - i);
+        bool roots = true;
+        bool outside = true;
+        for (size_t j = 0; j < n; j++) {
+            roots = roots && parents[i + j] < 0;
+            outside = outside && parents[i + j] < int32_t(i);
+        }
+        packet_transform const l = load(local, i, n);
+        if (roots) {
+            store(world, i, l, n);
+        } else if (outside) {
+            // the roots of the packet compose with any parent, then get their local transform
+            int32_t p[packet::SIZE];
+            int32_t any = 0;
+            for (size_t j = 0; j < n; j++) {
+                any = parents[i + j] >= 0 ? parents[i + j] : any;
+            }
+            for (size_t j = 0; j < n; j++) {
+                p[j] = parents[i + j] >= 0 ? parents[i + j] : any;
+            }
+            packet_transform w = compose(gather(world, p, n), l);
+            for (size_t j = 0; j < n; j++) {
+                if (parents[i + j] < 0) {
+                    set_lane(w, l, j);
+                }
+            }
+            store(world, i, w, n);
+        } else {
+            for (size_t j = i; j < i + n; j++) {
+                packet_transform const lj = load(local, j, 1);
+                store(world, j, parents[j] < 0 ? lj :
+                        compose(gather(world, parents + j, 1), lj), 1);
+            }
+        }
+    }
+}
+
+} // namespace numeric
+
+#endif
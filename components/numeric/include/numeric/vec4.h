@@ -3,12 +3,35 @@
 
 #include "vec3.h"
 #include "half.h"
+#include "details/simd.h"
 #include <stdint.h>
 #include <sys/types.h>
 
 namespace numeric {
 namespace details {
 
+/*
+ * With SIMD enabled, float4 and int4 are aligned like a 128-bit register so that their
+ * operators (see VectorKernels below) use aligned loads and stores. This is the only change
+ * to the layout, sizeof() is the same.
+ */
+template<typename T>
+struct Vector4Alignment {
+    static constexpr size_t value = alignof(T);
+};
+
+#if NUM_SIMD
+template<>
+struct Vector4Alignment<float> {
+    static constexpr size_t value = 16;
+};
+
+template<>
+struct Vector4Alignment<int32_t> {
+    static constexpr size_t value = 16;
+};
+#endif
+
 template <typename T>
 class NUM_EMPTY_BASES Vector4 :
     public VectorProductOperators<Vector4, T>,
@@ -25,7 +48,7 @@ public:
     static constexpr size_t SIZE = 4;
 
     union {
-        T v[SIZE];
+        alignas(Vector4Alignment<T>::value) T v[SIZE];
         Vector2<T> xy, st, rg;
         Vector3<T> xyz, stp, rgb;
         struct {
@@ -94,6 +117,115 @@ public:
         : x(v.x), y(v.y), z(v.z), w(v.w) {}
 };
 
+#if NUM_SIMD_SSE
+
+template<>
+class VectorKernels<Vector4<float>> : public VectorLoops<Vector4<float>> {
+    typedef Vector4<float> V;
+public:
+    static void add(V& lhs, const V& rhs) {
+        _mm_store_ps(lhs.v, _mm_add_ps(_mm_load_ps(lhs.v), _mm_load_ps(rhs.v)));
+    }
+    static void sub(V& lhs, const V& rhs) {
+        _mm_store_ps(lhs.v, _mm_sub_ps(_mm_load_ps(lhs.v), _mm_load_ps(rhs.v)));
+    }
+    static void mul(V& lhs, const V& rhs) {
+        _mm_store_ps(lhs.v, _mm_mul_ps(_mm_load_ps(lhs.v), _mm_load_ps(rhs.v)));
+    }
+    static void div(V& lhs, const V& rhs) {
+        _mm_store_ps(lhs.v, _mm_div_ps(_mm_load_ps(lhs.v), _mm_load_ps(rhs.v)));
+    }
+    static void neg(V& v) {
+        _mm_store_ps(v.v, _mm_xor_ps(_mm_load_ps(v.v), _mm_set1_ps(-0.0f)));
+    }
+    // minps(v, u) is v < u ? v : u, which is std::min(u, v)
+    static void min(V& v, const V& u) {
+        _mm_store_ps(v.v, _mm_min_ps(_mm_load_ps(v.v), _mm_load_ps(u.v)));
+    }
+    static void max(V& v, const V& u) {
+        _mm_store_ps(v.v, _mm_max_ps(_mm_load_ps(v.v), _mm_load_ps(u.v)));
+    }
+};
+
+template<>
+class VectorKernels<Vector4<int32_t>> : public VectorLoops<Vector4<int32_t>> {
+    typedef Vector4<int32_t> V;
+    static __m128i load(const V& v) { return _mm_load_si128(reinterpret_cast<__m128i const*>(v.v)); }
+    static void store(V& v, __m128i r) { _mm_store_si128(reinterpret_cast<__m128i*>(v.v), r); }
+public:
+    // there is no integer division, div() is the loop
+    static void add(V& lhs, const V& rhs) { store(lhs, _mm_add_epi32(load(lhs), load(rhs))); }
+    static void sub(V& lhs, const V& rhs) { store(lhs, _mm_sub_epi32(load(lhs), load(rhs))); }
+    static void neg(V& v) { store(v, _mm_sub_epi32(_mm_setzero_si128(), load(v))); }
+#if NUM_SIMD_SSE41
+    static void mul(V& lhs, const V& rhs) { store(lhs, _mm_mullo_epi32(load(lhs), load(rhs))); }
+    static void min(V& v, const V& u) { store(v, _mm_min_epi32(load(v), load(u))); }
+    static void max(V& v, const V& u) { store(v, _mm_max_epi32(load(v), load(u))); }
+#endif
+};
+
+#elif NUM_SIMD_NEON
+
+template<>
+class VectorKernels<Vector4<float>> : public VectorLoops<Vector4<float>> {
+    typedef Vector4<float> V;
+public:
+    static void add(V& lhs, const V& rhs) {
+        vst1q_f32(lhs.v, vaddq_f32(vld1q_f32(lhs.v), vld1q_f32(rhs.v)));
+    }
+    static void sub(V& lhs, const V& rhs) {
+        vst1q_f32(lhs.v, vsubq_f32(vld1q_f32(lhs.v), vld1q_f32(rhs.v)));
+    }
+    static void mul(V& lhs, const V& rhs) {
+        vst1q_f32(lhs.v, vmulq_f32(vld1q_f32(lhs.v), vld1q_f32(rhs.v)));
+    }
+#if defined(__aarch64__)
+    static void div(V& lhs, const V& rhs) {
+        vst1q_f32(lhs.v, vdivq_f32(vld1q_f32(lhs.v), vld1q_f32(rhs.v)));
+    }
+#endif
+    static void neg(V& v) {
+        vst1q_f32(v.v, vnegq_f32(vld1q_f32(v.v)));
+    }
+    // vminq_f32 and vmaxq_f32 return NaN when either input is, select like std::min(u, v)
+    static void min(V& v, const V& u) {
+        float32x4_t const a = vld1q_f32(v.v);
+        float32x4_t const b = vld1q_f32(u.v);
+        vst1q_f32(v.v, vbslq_f32(vcltq_f32(a, b), a, b));
+    }
+    static void max(V& v, const V& u) {
+        float32x4_t const a = vld1q_f32(v.v);
+        float32x4_t const b = vld1q_f32(u.v);
+        vst1q_f32(v.v, vbslq_f32(vcltq_f32(b, a), a, b));
+    }
+};
+
+template<>
+class VectorKernels<Vector4<int32_t>> : public VectorLoops<Vector4<int32_t>> {
+    typedef Vector4<int32_t> V;
+public:
+    static void add(V& lhs, const V& rhs) {
+        vst1q_s32(lhs.v, vaddq_s32(vld1q_s32(lhs.v), vld1q_s32(rhs.v)));
+    }
+    static void sub(V& lhs, const V& rhs) {
+        vst1q_s32(lhs.v, vsubq_s32(vld1q_s32(lhs.v), vld1q_s32(rhs.v)));
+    }
+    static void mul(V& lhs, const V& rhs) {
+        vst1q_s32(lhs.v, vmulq_s32(vld1q_s32(lhs.v), vld1q_s32(rhs.v)));
+    }
+    static void neg(V& v) {
+        vst1q_s32(v.v, vnegq_s32(vld1q_s32(v.v)));
+    }
+    static void min(V& v, const V& u) {
+        vst1q_s32(v.v, vminq_s32(vld1q_s32(v.v), vld1q_s32(u.v)));
+    }
+    static void max(V& v, const V& u) {
+        vst1q_s32(v.v, vmaxq_s32(vld1q_s32(v.v), vld1q_s32(u.v)));
+    }
+};
+
+#endif
+
 }  // namespace details
 
 typedef details::Vector4<double> double4;
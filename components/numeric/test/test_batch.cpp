@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric/batch.h>
+#include <numeric/mat4.h>
+#include <numeric/packet.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+class BatchTest : public RandomTest {
+protected:
+    BatchTest() : RandomTest(-10.0f, 10.0f, 343434) {}
+};
+
+TEST_F(BatchTest, PacketArithmetic) {
+    float a[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    float b[8] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+    floatx8 pa = floatx8::load(a);
+    floatx8 pb = floatx8::load(b);
+
+    floatx8 sum = pa + pb;
+    floatx8 prod = pa * pb;
+    floatx8 quot = pa / pb;
+    floatx8 diff = pa - 2.0f;
+    floatx8 m = min(pa, pb);
+    floatx8 r = sqrt(abs(-pa));
+    floatx8 f = madd(pa, pb, 1.0f);
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(9.0f, sum[i]);
+        EXPECT_EQ(a[i] * b[i], prod[i]);
+        EXPECT_FLOAT_EQ(a[i] / b[i], quot[i]);
+        EXPECT_EQ(a[i] - 2.0f, diff[i]);
+        EXPECT_EQ(std::min(a[i], b[i]), m[i]);
+        EXPECT_FLOAT_EQ(std::sqrt(a[i]), r[i]);
+        EXPECT_EQ(a[i] * b[i] + 1.0f, f[i]);
+    }
+
+    float out[8];
+    sum.store(out);
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(9.0f, out[i]);
+    }
+}
+
+TEST_F(BatchTest, PacketVectors) {
+    float3x4 u(floatx4(1.0f), floatx4(2.0f), floatx4(3.0f));
+    float3x4 v(floatx4(4.0f), floatx4(5.0f), floatx4(6.0f));
+    float3x4 s = u + v;
+    floatx4 d = dot(u, v);
+    float3x4 c = cross(u, v);
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(float3(5, 7, 9), float3(s.x[i], s.y[i], s.z[i]));
+        EXPECT_EQ(32.0f, d[i]);
+        EXPECT_EQ(float3(-3, 6, -3), float3(c.x[i], c.y[i], c.z[i]));
+    }
+
+    mat4f m = mat4f::translate(float3(1, 2, 3)) * mat4f::scale(2.0f);
+    float4x8 p(floatx8(1.0f), floatx8(1.0f), floatx8(1.0f), floatx8(1.0f));
+    float4x8 q = m * p;
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(float4(3, 4, 5, 1), float4(q.x[i], q.y[i], q.z[i], q.w[i]));
+    }
+}
+
+TEST_F(BatchTest, TransformPoints) {
+    mat4f m = mat4f::translate(rand3()) * mat4f::euler_zyx(1.0, 2.0, 3.0) * mat4f::scale(rand3());
+
+    // odd size to exercise the partial packet
+    const size_t count = 1003;
+    std::vector<float3> in(count);
+    std::vector<float3> out(count);
+    std::vector<float> soa[3] = {
+            std::vector<float>(count), std::vector<float>(count), std::vector<float>(count) };
+    std::vector<float> soa_out[3] = {
+            std::vector<float>(count), std::vector<float>(count), std::vector<float>(count) };
+    for (size_t i = 0; i < count; i++) {
+        in[i] = rand3();
+        soa[0][i] = in[i].x;
+        soa[1][i] = in[i].y;
+        soa[2][i] = in[i].z;
+    }
+    float const* const soa_in_ptr[3] = { soa[0].data(), soa[1].data(), soa[2].data() };
+    float* const soa_out_ptr[3] = { soa_out[0].data(), soa_out[1].data(), soa_out[2].data() };
+
+    transform_points(m, in.data(), out.data(), count);
+    transform_points(m, soa_in_ptr, soa_out_ptr, count);
+    for (size_t i = 0; i < count; i++) {
+        float3 expected = (m * in[i]).xyz;
+        EXPECT_FLOAT3_NEAR(expected, out[i], 1e-4f);
+        EXPECT_FLOAT3_NEAR(expected, float3(soa_out[0][i], soa_out[1][i], soa_out[2][i]), 1e-4f);
+    }
+
+    // in-place
+    std::vector<float3> inplace(in);
+    transform_points(m, inplace.data(), inplace.data(), count);
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(out[i], inplace[i]);
+    }
+}
+
+TEST_F(BatchTest, TransformNormals) {
+    mat4f m = mat4f::euler_zyx(0.5, 1.0, 1.5) * mat4f::scale(float3(1, 4, 0.5f));
+    mat3f n = normal_matrix(m);
+
+    const size_t count = 37;
+    std::vector<float3> in(count);
+    std::vector<float3> out(count);
+    for (size_t i = 0; i < count; i++) {
+        in[i] = normalize(rand3());
+    }
+    transform_normals(n, in.data(), out.data(), count);
+
+    // a transformed normal must stay orthogonal to the transformed tangents
+    for (size_t i = 0; i < count; i++) {
+        float3 t = cross(in[i], float3(0, 0, 1));
+        float3 tt = m.upper_left() * t;
+        EXPECT_NEAR(1.0f, length(out[i]), 1e-5f);
+        EXPECT_NEAR(0.0f, dot(out[i], tt) / length(tt), 1e-5f);
+    }
+
+    std::vector<float3> dirs(count);
+    transform_vectors(m.upper_left(), in.data(), dirs.data(), count);
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_FLOAT3_NEAR(m.upper_left() * in[i], dirs[i], 1e-5f);
+    }
+}
+
+class QuatBatchTest : public RandomTest {
+protected:
+    QuatBatchTest() : RandomTest(-1.0f, 1.0f, 565656) {}
+
+    // count random unit quaternions, both as an array and as x, y, z, w streams
+    struct Quats {
+        explicit Quats(size_t count) : aos(count), soa(4, std::vector<float>(count)) {
+            sync();
+        }
+        Quats(Quats const&) = delete;
+        Quats(Quats&&) = default;
+        std::vector<quatf> aos;
+        std::vector<std::vector<float>> soa;
+        float const* in[4];
+        float* out[4];
+
+        void sync() {
+            for (size_t c = 0; c < 4; c++) {
+                for (size_t i = 0; i < aos.size(); i++) {
+                    soa[c][i] = aos[i][c];
+                }
+                in[c] = soa[c].data();
+                out[c] = soa[c].data();
+            }
+        }
+
+        quatf operator[](size_t i) const {
+            return quatf(soa[3][i], soa[0][i], soa[1][i], soa[2][i]);
+        }
+    };
+
+    Quats rand_quats(size_t count) {
+        Quats r(count);
+        for (size_t i = 0; i < count; i++) {
+            r.aos[i] = rand_rotation();
+        }
+        r.sync();
+        return r;
+    }
+};
+
+static double quat_distance(quat const& a, quat const& b) {
+    // a and -a are the same rotation
+    return std::min(length(a - b), length(a + b));
+}
+
+TEST_F(QuatBatchTest, Interpolation) {
+    const size_t count = 1001;
+    Quats p = rand_quats(count);
+    Quats q = rand_quats(count);
+    std::vector<float> t(count);
+    for (size_t i = 0; i < count; i++) {
+        t[i] = (rand_gen() + 1.0f) * 0.5f;
+    }
+    // a few nearly identical and identical pairs
+    for (size_t i = 0; i < 16; i++) {
+        q.aos[i] = normalize(p.aos[i] + quatf(0, 0, 0, i * 1e-5f));
+    }
+    q.sync();
+
+    Quats slerped(count), nlerped(count), fast(count), uniform(count);
+    slerp_n(p.in, q.in, t.data(), slerped.out, count);
+    nlerp_n(p.in, q.in, t.data(), nlerped.out, count);
+    slerp_fast_n(p.in, q.in, t.data(), fast.out, count);
+    slerp_n(p.in, q.in, 0.25f, uniform.out, count);
+
+    for (size_t i = 0; i < count; i++) {
+        quat const pd(p.aos[i]);
+        quat const qd(q.aos[i]);
+        double const d = dot(pd, qd);
+        // the double precision reference, slerp() itself doesn't handle p == q but nlerp()
+        // is exact enough for such small angles
+        bool const close = std::abs(d) > 1 - 1e-9;
+        quat expected = close ? nlerp(pd, qd, double(t[i])) : slerp(pd, qd, double(t[i]));
+        EXPECT_LT(quat_distance(expected, quat(slerped[i])), 1e-6) << i;
+        EXPECT_LT(quat_distance(expected, quat(fast[i])), 4e-4) << i;
+        EXPECT_LT(length(quat(nlerp(p.aos[i], q.aos[i], t[i])) - quat(nlerped[i])), 1e-6) << i;
+
+        expected = close ? nlerp(pd, qd, 0.25) : slerp(pd, qd, 0.25);
+        EXPECT_LT(quat_distance(expected, quat(uniform[i])), 1e-6) << i;
+    }
+
+    // in-place
+    slerp_n(p.in, q.in, t.data(), p.out, count);
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(slerped[i], p[i]);
+    }
+}
+
+TEST_F(QuatBatchTest, ToMatrix) {
+    const size_t count = 37;
+    Quats q = rand_quats(count);
+    q.aos[0] = quatf(0, 0, 0, 0);
+    q.aos[1] = quatf(2, 0, 0, 0);
+    q.sync();
+
+    std::vector<mat3f> m3(count);
+    std::vector<mat4f> m4(count);
+    quat_to_mat3_n(q.in, m3.data(), count);
+    quat_to_mat4_n(q.in, m4.data(), count);
+    for (size_t i = 0; i < count; i++) {
+        mat3f const e3(q.aos[i]);
+        mat4f const e4(q.aos[i]);
+        for (size_t c = 0; c < 3; c++) {
+            EXPECT_FLOAT3_NEAR(e3[c], m3[i][c], 1e-6f);
+        }
+        for (size_t c = 0; c < 4; c++) {
+            EXPECT_FLOAT3_NEAR(e4[c].xyz, m4[i][c].xyz, 1e-6f);
+            EXPECT_EQ(e4[c].w, m4[i][c].w);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric/batch.h>
+#include <numeric/bounds.h>
+#include <numeric/mat4.h>
+#include <numeric/quat.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+class BoundsTest : public RandomTest {
+protected:
+    BoundsTest() : RandomTest(-10.0f, 10.0f, 565656) {}
+
+    Aabb rand_box() {
+        float3 const a = rand3();
+        float3 const b = rand3();
+        return Aabb{ min(a, b), max(a, b) };
+    }
+
+    // rotation, non-uniform scale and translation
+    mat4f rand_affine() {
+        quatf const q = rand_rotation();
+        return mat4f::translate(rand3()) * mat4f(q) * mat4f::scale(abs(rand3()) * 0.2f);
+    }
+
+    // the reference: bounds of the 8 transformed corners
+    static Aabb corners(const mat4f& m, const Aabb& b) {
+        // seeded with the first corner: Aabb has no empty state to start a min/max from
+        float3 const first = (m * float4(b.min, 1)).xyz;
+        Aabb r{ first, first };
+        for (size_t i = 1; i < 8; i++) {
+            float3 const p((i & 1) ? b.max.x : b.min.x,
+                           (i & 2) ? b.max.y : b.min.y,
+                           (i & 4) ? b.max.z : b.min.z);
+            float3 const t = (m * float4(p, 1)).xyz;
+            r.min = min(r.min, t);
+            r.max = max(r.max, t);
+        }
+        return r;
+    }
+};
+
+#define EXPECT_AABB_NEAR(A, B, EPS)                 \
+do {                                                \
+    const Aabb a_ = A;                              \
+    const Aabb b_ = B;                              \
+    for (size_t c = 0; c < 3; c++) {                \
+        EXPECT_NEAR(a_.min[c], b_.min[c], EPS);     \
+        EXPECT_NEAR(a_.max[c], b_.max[c], EPS);     \
+    }                                               \
+} while(0)
+
+TEST_F(BoundsTest, Aabb) {
+    Aabb const b{ { -1, 2, 3 }, { 3, 4, 9 } };
+    EXPECT_EQ(b.center(), float3(1, 3, 6));
+    EXPECT_EQ(b.extent(), float3(2, 1, 3));
+    Aabb const c = Aabb::from_center_extent(b.center(), b.extent());
+    EXPECT_EQ(c.min, b.min);
+    EXPECT_EQ(c.max, b.max);
+}
+
+TEST_F(BoundsTest, TransformAabb) {
+    for (size_t i = 0; i < 100; i++) {
+        mat4f const m = rand_affine();
+        Aabb const b = rand_box();
+        EXPECT_AABB_NEAR(transform_aabb(m, b), corners(m, b), 1e-4f);
+    }
+    // a point stays a point
+    Aabb const p = transform_aabb(rand_affine(), Aabb{ float3(1), float3(1) });
+    EXPECT_EQ(p.min, p.max);
+}
+
+TEST_F(BoundsTest, TransformAabbs) {
+    mat4f const m = rand_affine();
+    for (size_t count : { 0, 1, 5, 8, 37 }) {
+        std::vector<Aabb> in(count), out(count);
+        std::vector<float> lo[3], hi[3], out_lo[3], out_hi[3];
+        for (size_t c = 0; c < 3; c++) {
+            lo[c].resize(count); hi[c].resize(count);
+            out_lo[c].resize(count); out_hi[c].resize(count);
+        }
+        for (size_t i = 0; i < count; i++) {
+            in[i] = rand_box();
+            for (size_t c = 0; c < 3; c++) {
+                lo[c][i] = in[i].min[c];
+                hi[c][i] = in[i].max[c];
+            }
+        }
+        float const* const in_min[3] = { lo[0].data(), lo[1].data(), lo[2].data() };
+        float const* const in_max[3] = { hi[0].data(), hi[1].data(), hi[2].data() };
+        float* const o_min[3] = { out_lo[0].data(), out_lo[1].data(), out_lo[2].data() };
+        float* const o_max[3] = { out_hi[0].data(), out_hi[1].data(), out_hi[2].data() };
+
+        transform_aabbs(m, in.data(), out.data(), count);
+        transform_aabbs(m, in_min, in_max, o_min, o_max, count);
+        for (size_t i = 0; i < count; i++) {
+            Aabb const ref = transform_aabb(m, in[i]);
+            EXPECT_AABB_NEAR(out[i], ref, 1e-5f);
+            EXPECT_AABB_NEAR(Aabb({ float3(out_lo[0][i], out_lo[1][i], out_lo[2][i]),
+                                    float3(out_hi[0][i], out_hi[1][i], out_hi[2][i]) }),
+                             ref, 1e-5f);
+        }
+
+        // in place
+        transform_aabbs(m, in.data(), in.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_AABB_NEAR(in[i], out[i], 0);
+        }
+    }
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <numeric/dualquat.h>
+#include <numeric/mat4.h>
+#include <numeric/quat.h>
+#include <numeric/skinning.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+class DualQuatTest : public RandomTest {
+protected:
+    DualQuatTest() : RandomTest(-1.0f, 1.0f, 858585) {}
+
+    dualquatf rand_rigid() { return dualquatf(rand_rotation(), rand3() * 10.0f); }
+};
+
+TEST_F(DualQuatTest, Basics) {
+    dualquatf const id;
+    float3 const p(1, 2, 3);
+    EXPECT_EQ(transform_point(id, p), p);
+    EXPECT_EQ(transform_point(dualquatf::translation(float3(1, 0, -1)), p), float3(2, 2, 2));
+
+    for (size_t i = 0; i < 100; i++) {
+        quatf const q = rand_rotation();
+        float3 const t = rand3() * 10.0f;
+        dualquatf const d(q, t);
+        EXPECT_FLOAT3_NEAR(d.translation(), t, 1e-5f);
+        EXPECT_EQ(d.rotation(), q);
+
+        mat4f const m = mat4f::translate(t) * mat4f(q);
+        float3 const v = rand3();
+        EXPECT_FLOAT3_NEAR(transform_point(d, v), (m * float4(v, 1)).xyz, 1e-4f);
+        EXPECT_FLOAT3_NEAR(transform_normal(d, v), q * v, 1e-5f);
+
+        // back and forth to a matrix
+        mat4f const dm = d.to_matrix();
+        dualquatf const e(m);
+        for (size_t c = 0; c < 4; c++) {
+            EXPECT_NEAR(length(dm[c] - m[c]), 0.0f, 1e-4f);
+        }
+        EXPECT_FLOAT3_NEAR(transform_point(e, v), transform_point(d, v), 1e-4f);
+    }
+}
+
+TEST_F(DualQuatTest, Product) {
+    for (size_t i = 0; i < 100; i++) {
+        dualquatf const a = rand_rigid();
+        dualquatf const b = rand_rigid();
+        float3 const p = rand3();
+        // b first, like the matrices
+        EXPECT_FLOAT3_NEAR(transform_point(a * b, p), transform_point(a, transform_point(b, p)),
+                1e-4f);
+        mat4f const m = a.to_matrix() * b.to_matrix();
+        EXPECT_FLOAT3_NEAR(transform_point(a * b, p), (m * float4(p, 1)).xyz, 1e-4f);
+        // conj() is the inverse
+        EXPECT_FLOAT3_NEAR(transform_point(conj(a) * a, p), p, 1e-4f);
+    }
+}
+
+TEST_F(DualQuatTest, NormalizeAndBlend) {
+    for (size_t i = 0; i < 100; i++) {
+        dualquatf const a = rand_rigid();
+        float3 const p = rand3();
+        EXPECT_FLOAT3_NEAR(transform_point(normalize(a * 3.0f), p), transform_point(a, p), 1e-4f);
+
+        // -q is the same transform, the blend flips it back
+        dualquatf const q[2] = { a, a * -1.0f };
+        float const w[2] = { 0.25f, 0.75f };
+        EXPECT_FLOAT3_NEAR(transform_point(blend(q, w, 2), p), transform_point(a, p), 1e-4f);
+    }
+
+    // halfway between two rotations about the same axis
+    dualquatf const q[2] = {
+            dualquatf(quatf::from_axis_angle(float3(0, 0, 1), 0.0f), float3(0)),
+            dualquatf(quatf::from_axis_angle(float3(0, 0, 1), float(M_PI_2)), float3(0)) };
+    float const w[2] = { 0.5f, 0.5f };
+    float3 const r = transform_point(blend(q, w, 2), float3(1, 0, 0));
+    EXPECT_FLOAT3_NEAR(r, float3(std::sqrt(0.5f), std::sqrt(0.5f), 0), 1e-5f);
+}
+
+TEST_F(DualQuatTest, Skinning) {
+    size_t const joint_count = 10;
+    std::vector<dualquatf> dq(joint_count);
+    std::vector<mat4f> mats(joint_count);
+    for (size_t i = 0; i < joint_count; i++) {
+        dq[i] = rand_rigid();
+        mats[i] = dq[i].to_matrix();
+        // a non-uniform scale, that the normals must not follow
+        mats[i][0] *= 0.5f;
+        mats[i][2] *= 2.0f;
+    }
+
+    std::default_random_engine engine(12);
+    for (size_t count : { 0, 1, 7, 37 }) {
+        std::vector<ushort4> indices(count);
+        std::vector<float4> weights(count);
+        std::vector<float3> pos(count), nrm(count);
+        std::vector<float3> lbs_pos(count), lbs_nrm(count), dq_pos(count), dq_nrm(count);
+        for (size_t i = 0; i < count; i++) {
+            for (size_t k = 0; k < 4; k++) {
+                indices[i][k] = uint16_t(engine() % joint_count);
+                weights[i][k] = std::abs(rand_gen());
+            }
+            // some vertices with fewer influences
+            if (i % 3 == 0) {
+                weights[i].w = 0;
+            }
+            weights[i] /= weights[i].x + weights[i].y + weights[i].z + weights[i].w;
+            pos[i] = rand3();
+            nrm[i] = normalize(rand3());
+        }
+
+        skin_linear(mats.data(), indices.data(), weights.data(), pos.data(), nrm.data(),
+                lbs_pos.data(), lbs_nrm.data(), count);
+        skin_dualquat(dq.data(), indices.data(), weights.data(), pos.data(), nrm.data(),
+                dq_pos.data(), dq_nrm.data(), count);
+
+        for (size_t i = 0; i < count; i++) {
+            mat4f m(0.0f);
+            dualquatf joints[4];
+            for (size_t k = 0; k < 4; k++) {
+                m += mats[indices[i][k]] * weights[i][k];
+                joints[k] = dq[indices[i][k]];
+            }
+            float const w[4] = { weights[i].x, weights[i].y, weights[i].z, weights[i].w };
+            dualquatf const b = blend(joints, w, 4);
+
+            EXPECT_FLOAT3_NEAR(lbs_pos[i], (m * float4(pos[i], 1)).xyz, 1e-4f);
+            EXPECT_FLOAT3_NEAR(lbs_nrm[i], normalize(transpose(inverse(m.upper_left())) * nrm[i]), 1e-4f);
+            EXPECT_FLOAT3_NEAR(dq_pos[i], transform_point(b, pos[i]), 1e-4f);
+            EXPECT_FLOAT3_NEAR(dq_nrm[i], transform_normal(b, nrm[i]), 1e-4f);
+        }
+    }
+
+    // positions only
+    ushort4 const index(0, 1, 0, 0);
+    float4 const weight(0.5f, 0.5f, 0, 0);
+    float3 const p(1, 2, 3);
+    float3 out;
+    skin_dualquat(dq.data(), &index, &weight, &p, nullptr, &out, nullptr, 1);
+    dualquatf const joints[2] = { dq[0], dq[1] };
+    float const w[2] = { 0.5f, 0.5f };
+    EXPECT_FLOAT3_NEAR(out, transform_point(blend(joints, w, 2), p), 1e-4f);
+}
+
+TEST_F(DualQuatTest, TwistKeepsVolume) {
+    // a vertex at distance 1 of a bone along x, half influenced by a joint twisted by 170 degrees
+    quatf const twist = quatf::from_axis_angle(float3(1, 0, 0), 170.0 * M_PI / 180.0);
+    mat4f const mats[2] = { mat4f(), mat4f(twist) };
+    dualquatf const dq[2] = { dualquatf(), dualquatf(twist, float3(0)) };
+    ushort4 const index(0, 1, 0, 0);
+    float4 const weight(0.5f, 0.5f, 0, 0);
+    float3 const p(0.5f, 1, 0);
+    float3 lbs, dlb;
+    skin_linear(mats, &index, &weight, &p, nullptr, &lbs, nullptr, 1);
+    skin_dualquat(dq, &index, &weight, &p, nullptr, &dlb, nullptr, 1);
+    // the matrices collapse the skin towards the bone
+    EXPECT_LT(length(lbs.yz), 0.1f);
+    EXPECT_NEAR(length(dlb.yz), 1.0f, 1e-5f);
+    EXPECT_NEAR(dlb.x, 0.5f, 1e-5f);
+}
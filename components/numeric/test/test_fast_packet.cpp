@@ -0,0 +1,126 @@
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <gtest/gtest.h>
+#include <numeric/fast.h>
+#include <numeric/packet.h>
+
+using namespace numeric;
+
+class FastPacketTest : public testing::Test {
+protected:
+    static float from_bits(uint32_t b) {
+        float f;
+        memcpy(&f, &b, sizeof(f));
+        return f;
+    }
+
+    static uint32_t to_bits(float f) {
+        uint32_t b;
+        memcpy(&b, &f, sizeof(b));
+        return b;
+    }
+
+    static double ulp(double r) {
+        float const f = float(std::abs(r));
+        return std::nextafter(f, INFINITY) - f;
+    }
+
+    /*
+     * Checks the packet function against the double precision reference for the floats of
+     * [lo, hi] (and [-hi, -lo] with both_signs), taking every step-th bit pattern. The error
+     * must be within max_abs or within max_ulp, whichever is larger.
+     */
+    template<size_t N, typename F, typename R>
+    static void check(float lo, float hi, bool both_signs, uint32_t step,
+            double max_abs, double max_ulp, F fn, R reference) {
+        uint32_t const first = to_bits(lo);
+        uint32_t const last = to_bits(hi);
+        for (uint32_t sign = 0; sign <= (both_signs ? 1u : 0u); sign++) {
+            for (uint64_t b = first; b <= last; b += uint64_t(step) * N) {
+                float in[N];
+                for (size_t i = 0; i < N; i++) {
+                    uint64_t const bits = std::min<uint64_t>(b + i * step, last);
+                    in[i] = from_bits(uint32_t(bits) | (sign << 31));
+                }
+                details::Packet<N> const out = fn(details::Packet<N>::load(in));
+                for (size_t i = 0; i < N; i++) {
+                    double const r = reference(double(in[i]));
+                    double const error = std::abs(double(out[i]) - r);
+                    if (error > max_abs && error > max_ulp * ulp(r)) {
+                        ADD_FAILURE() << "x=" << in[i] << " result=" << out[i]
+                                << " expected=" << r << " (" << error / ulp(r) << " ulp)";
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    template<size_t N>
+    static void checkAll(uint32_t step) {
+        typedef details::Packet<N> P;
+        check<N>(0.0f, 8192.0f, true, step, 1.2e-7, 0,
+                [](P x) { return fast::sin(x); }, [](double x) { return std::sin(x); });
+        check<N>(0.0f, 8192.0f, true, step, 1.2e-7, 0,
+                [](P x) { return fast::cos(x); }, [](double x) { return std::cos(x); });
+        check<N>(0.0f, 126.0f, true, step, 0, 2,
+                [](P x) { return fast::exp2(x); }, [](double x) { return std::exp2(x); });
+        check<N>(126.0f, 127.0f, false, step, 0, 2,
+                [](P x) { return fast::exp2(x); }, [](double x) { return std::exp2(x); });
+        check<N>(FLT_MIN, FLT_MAX, false, step, 0, 2,
+                [](P x) { return fast::log2(x); }, [](double x) { return std::log2(x); });
+        check<N>(FLT_MIN, FLT_MAX, false, step, 0, 6,
+                [](P x) { return fast::isqrt(x); }, [](double x) { return 1.0 / std::sqrt(x); });
+
+        // pow() for a few exponents, its error grows with |y * log2(x)|
+        float const exponents[] = { -3.5f, -1.0f, 0.4545f, 2.2f, 5.0f };
+        for (float y : exponents) {
+            float const lo = std::max(FLT_MIN, std::exp2(-120.0f / std::abs(y)));
+            float const hi = std::min(FLT_MAX, std::exp2(120.0f / std::abs(y)));
+            check<N>(lo, hi, false, step, 0, 2 + 120,
+                    [y](P x) { return fast::pow(x, P(y)); },
+                    [y](double x) { return std::pow(x, double(y)); });
+            check<N>(0.5f, 2.0f, false, step, 0, 2 + std::abs(y),
+                    [y](P x) { return fast::pow(x, P(y)); },
+                    [y](double x) { return std::pow(x, double(y)); });
+        }
+    }
+};
+
+TEST_F(FastPacketTest, Accuracy) {
+    // a sample of every domain, see below for the exhaustive version
+    checkAll<4>(16411);
+    checkAll<8>(16411);
+}
+
+// every float of every domain, this takes several minutes in an optimized build.
+// run with --gtest_also_run_disabled_tests
+TEST_F(FastPacketTest, DISABLED_ExhaustiveAccuracy) {
+    checkAll<4>(1);
+    checkAll<8>(1);
+}
+
+TEST_F(FastPacketTest, Special) {
+    floatx4 const x = fast::exp2(floatx4::load(std::array<float, 4>{
+            -200.0f, -127.0f, 0.0f, 1000.0f }.data()));
+    EXPECT_EQ(0.0f, x[0]);
+    EXPECT_EQ(0.0f, x[1]);
+    EXPECT_EQ(1.0f, x[2]);
+    EXPECT_EQ(std::exp2(127.0f), x[3]);
+
+    floatx4 const l = fast::log2(floatx4::load(std::array<float, 4>{
+            1.0f, 2.0f, 0.5f, 1024.0f }.data()));
+    EXPECT_EQ(0.0f, l[0]);
+    EXPECT_EQ(1.0f, l[1]);
+    EXPECT_EQ(-1.0f, l[2]);
+    EXPECT_EQ(10.0f, l[3]);
+
+    // the packet functions go beyond the [-pi, pi] range of the scalar ones
+    floatx4 const s = fast::sin(floatx4(100.0f));
+    floatx4 const c = fast::cos(floatx4(-100.0f));
+    EXPECT_NEAR(std::sin(100.0f), s[0], 1.2e-7f);
+    EXPECT_NEAR(std::cos(-100.0f), c[3], 1.2e-7f);
+}
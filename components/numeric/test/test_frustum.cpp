@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric/bounds.h>
+#include <numeric/frustum.h>
+#include <numeric/mat4.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+class FrustumTest : public RandomTest {
+protected:
+    FrustumTest() : RandomTest(-60.0f, 60.0f, 787878) {}
+
+    static bool visible(std::vector<uint32_t> const& mask, size_t i) {
+        return (mask[i / 32] >> (i % 32)) & 1u;
+    }
+};
+
+TEST_F(FrustumTest, Planes) {
+    Frustum f(mat4f::ortho(-1, 2, -3, 4, 1, 10));
+    // the normals point inside, the offsets are the distances to the origin
+    EXPECT_FLOAT_EQ(f.plane(0).x, 1);  EXPECT_FLOAT_EQ(f.plane(0).w, 1);
+    EXPECT_FLOAT_EQ(f.plane(1).x, -1); EXPECT_FLOAT_EQ(f.plane(1).w, 2);
+    EXPECT_FLOAT_EQ(f.plane(2).y, 1);  EXPECT_FLOAT_EQ(f.plane(2).w, 3);
+    EXPECT_FLOAT_EQ(f.plane(3).y, -1); EXPECT_FLOAT_EQ(f.plane(3).w, 4);
+    EXPECT_FLOAT_EQ(f.plane(4).z, -1); EXPECT_FLOAT_EQ(f.plane(4).w, -1);
+    EXPECT_FLOAT_EQ(f.plane(5).z, 1);  EXPECT_FLOAT_EQ(f.plane(5).w, 10);
+
+    Frustum p(mat4f::perspective(90, 1, 1, 100));
+    EXPECT_TRUE(p.intersects(Sphere{ { 0, 0, -50 }, 1 }));
+    EXPECT_FALSE(p.intersects(Sphere{ { 0, 0, 10 }, 1 }));
+    EXPECT_FALSE(p.intersects(Sphere{ { 0, 0, -102 }, 1 }));
+    EXPECT_TRUE(p.intersects(Sphere{ { 0, 0, -100.5f }, 1 }));
+    // the 90 degrees side planes go through (+-z, z)
+    EXPECT_FALSE(p.intersects(Sphere{ { 12, 0, -10 }, 1 }));
+    EXPECT_TRUE(p.intersects(Sphere{ { 10.5f, 0, -10 }, 1 }));
+    EXPECT_FALSE(p.intersects(Aabb{ { 11, -1, -11 }, { 12, 1, -9 } }));
+    EXPECT_TRUE(p.intersects(Aabb{ { 9, -1, -11 }, { 12, 1, -9 } }));
+    // a box crossing the whole frustum has all its corners outside but is visible
+    EXPECT_TRUE(p.intersects(Aabb{ { -100, -1, -11 }, { 100, 1, -9 } }));
+}
+
+TEST_F(FrustumTest, Culling) {
+    mat4f const view = inverse(mat4f::look_at(float3(3, 2, 10), float3(0), float3(0, 1, 0)));
+    Frustum const f(mat4f::perspective(60, 1.5f, 0.5f, 50) * view);
+
+    // odd sizes to exercise the partial packets and mask words
+    for (size_t count : { 0, 1, 7, 33, 1000 }) {
+        std::vector<float3> centers(count);
+        std::vector<float> radii(count);
+        std::vector<Aabb> boxes(count);
+        std::vector<float> x(count), y(count), z(count);
+        for (size_t i = 0; i < count; i++) {
+            centers[i] = rand3();
+            radii[i] = std::abs(rand_gen()) * 0.2f;
+            boxes[i] = Aabb::from_center_extent(centers[i], abs(rand3()) * 0.2f);
+            x[i] = centers[i].x;
+            y[i] = centers[i].y;
+            z[i] = centers[i].z;
+        }
+        float const* const soa[3] = { x.data(), y.data(), z.data() };
+
+        size_t const words = (count + 31) / 32;
+        std::vector<uint32_t> spheres(words, ~0u), spheres_soa(words, ~0u), aabbs(words, ~0u);
+        cull_spheres(f, centers.data(), radii.data(), count, spheres.data());
+        cull_spheres(f, soa, radii.data(), count, spheres_soa.data());
+        cull_aabbs(f, boxes.data(), count, aabbs.data());
+
+        size_t visible_count = 0;
+        for (size_t i = 0; i < count; i++) {
+            bool const s = f.intersects(Sphere{ centers[i], radii[i] });
+            EXPECT_EQ(s, visible(spheres, i)) << i;
+            EXPECT_EQ(s, visible(spheres_soa, i)) << i;
+            EXPECT_EQ(f.intersects(boxes[i]), visible(aabbs, i)) << i;
+            visible_count += s;
+        }
+        for (size_t i = count; i < words * 32; i++) {
+            EXPECT_FALSE(visible(spheres, i));
+            EXPECT_FALSE(visible(aabbs, i));
+        }
+        if (count == 1000) {
+            // make sure the test is not trivial
+            EXPECT_GT(visible_count, 10u);
+            EXPECT_LT(visible_count, 990u);
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include <math.h>
+#include <string.h>
 #include <gtest/gtest.h>
 #include <numeric/half.h>
 
@@ -21,3 +22,94 @@ TEST_F(HalfTest, Basic) {
     h = INFINITY;
     EXPECT_TRUE(std::isinf((float) h));
 }
+
+// Walks a large, evenly spread subset of all the float bit patterns (both signs, denormals,
+// infinities and NaNs included) in chunks.
+template<typename F>
+static void forFloats(F f) {
+    constexpr size_t CHUNK = 4096;
+    constexpr uint64_t STRIDE = 257;
+    float in[CHUNK];
+    uint64_t bits = 0;
+    while (bits <= 0xFFFFFFFFull) {
+        size_t n = 0;
+        for (; n < CHUNK && bits <= 0xFFFFFFFFull; n++, bits += STRIDE) {
+            uint32_t b = uint32_t(bits);
+            memcpy(&in[n], &b, sizeof(b));
+        }
+        f(in, n);
+    }
+}
+
+TEST_F(HalfTest, BulkPortableMatchesScalar) {
+    uint16_t out[4096];
+    forFloats([&](float const* in, size_t n) {
+        details::half_convert::f32_to_f16(in, out, n);
+        for (size_t i = 0; i < n; i++) {
+            ASSERT_EQ(getbits(half(in[i])), out[i]) << "input " << in[i];
+        }
+    });
+
+    // exact ties between two halves and values around them
+    float ties[] = { 1.0f + 1.0f / 2048, 1.0f + 3.0f / 2048, 65504.0f + 16.0f, 65520.0f,
+                     -(2.0f + 1.0f / 1024), 0x1.0p-25f, 0x1.8p-24f, 0x1.0p-24f };
+    details::half_convert::f32_to_f16(ties, out, 8);
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(getbits(half(ties[i])), out[i]) << "input " << ties[i];
+    }
+
+    uint16_t all[65536];
+    float f[65536];
+    for (size_t i = 0; i < 65536; i++) {
+        all[i] = uint16_t(i);
+    }
+    details::half_convert::f16_to_f32(all, f, 65536);
+    for (size_t i = 0; i < 65536; i++) {
+        float expected = makehalf(uint16_t(i));
+        EXPECT_EQ(0, memcmp(&expected, &f[i], sizeof(float))) << "half " << i;
+    }
+}
+
+TEST_F(HalfTest, BulkConversion) {
+    half out[4096];
+    forFloats([&](float const* in, size_t n) {
+        convert_f32_to_f16(in, out, n);
+        for (size_t i = 0; i < n; i++) {
+            half const expected(in[i]);
+            if (std::isnan(in[i])) {
+                ASSERT_TRUE(std::isnan(float(out[i])));
+            } else {
+                // hardware conversions round ties to even, see convert_f32_to_f16()
+                int diff = int(getbits(expected)) - int(getbits(out[i]));
+                ASSERT_LE(std::abs(diff), 1) << "input " << in[i];
+            }
+        }
+    });
+
+    half all[65536];
+    float f[65536];
+    for (size_t i = 0; i < 65536; i++) {
+        all[i] = makehalf(uint16_t(i));
+    }
+    // odd count to go through the tail
+    convert_f16_to_f32(all, f, 65535);
+    for (size_t i = 0; i < 65535; i++) {
+        float expected = all[i];
+        if (std::isnan(expected)) {
+            EXPECT_TRUE(std::isnan(f[i]));
+        } else {
+            EXPECT_EQ(0, memcmp(&expected, &f[i], sizeof(float))) << "half " << i;
+        }
+    }
+
+    float round_trip[1001];
+    half h[1001];
+    for (size_t i = 0; i < 1001; i++) {
+        round_trip[i] = float(i) - 500.0f;
+    }
+    convert_f32_to_f16(round_trip, h, 1001);
+    convert_f16_to_f32(h, round_trip, 1001);
+    for (size_t i = 0; i < 1001; i++) {
+        EXPECT_EQ(float(i) - 500.0f, round_trip[i]);
+    }
+}
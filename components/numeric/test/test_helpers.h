@@ -0,0 +1,46 @@
+#ifndef CHROMA_NUMERIC_TEST_HELPERS_H
+#define CHROMA_NUMERIC_TEST_HELPERS_H
+
+#include <gtest/gtest.h>
+#include <functional>
+#include <random>
+#include <numeric/mat4.h>
+#include <numeric/quat.h>
+
+// a fixture drawing floats uniformly in [lo, hi), the same sequence for a given seed
+class RandomTest : public testing::Test {
+protected:
+    RandomTest(float lo, float hi, unsigned seed)
+            : rand_gen(std::bind(std::uniform_real_distribution<float>(lo, hi),
+                    std::default_random_engine(seed))) {}
+
+    numeric::float3 rand3() { return numeric::float3(rand_gen(), rand_gen(), rand_gen()); }
+
+    numeric::quatf rand_rotation() {
+        return normalize(numeric::quatf(rand_gen(), rand_gen(), rand_gen(), rand_gen()));
+    }
+
+    std::function<float()> rand_gen;
+};
+
+#define EXPECT_FLOAT3_NEAR(A, B, EPS)           \
+do {                                            \
+    const numeric::float3 a_ = A;               \
+    const numeric::float3 b_ = B;               \
+    EXPECT_NEAR(a_.x, b_.x, EPS);               \
+    EXPECT_NEAR(a_.y, b_.y, EPS);               \
+    EXPECT_NEAR(a_.z, b_.z, EPS);               \
+} while(0)
+
+#define EXPECT_MAT4_NEAR(A, B, EPS)                         \
+do {                                                        \
+    const numeric::mat4f a_ = A;                            \
+    const numeric::mat4f b_ = B;                            \
+    for (size_t c_ = 0; c_ < 4; c_++) {                     \
+        for (size_t r_ = 0; r_ < 4; r_++) {                 \
+            EXPECT_NEAR(a_[c_][r_], b_[c_][r_], EPS);       \
+        }                                                   \
+    }                                                       \
+} while(0)
+
+#endif
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <functional>
+#include <numeric/intersect.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+class IntersectTest : public RandomTest {
+protected:
+    IntersectTest() : RandomTest(-1.0f, 1.0f, 1234) {}
+
+    Ray rand_ray() {
+        Ray r;
+        r.origin = rand3() * 2.0f;
+        r.direction = rand3();
+        r.t_max = 3.0f + rand_gen();
+        return r;
+    }
+};
+
+TEST_F(IntersectTest, Aabb) {
+    Aabb const box{ float3(-1, -2, -3), float3(1, 2, 3) };
+    float t;
+    EXPECT_TRUE(intersect(Ray{ float3(-5, 0, 0), float3(1, 0, 0) }, box, t));
+    EXPECT_FLOAT_EQ(t, 4.0f);
+    EXPECT_TRUE(intersect(Ray{ float3(0, 0, 0), float3(0, 0, -1) }, box, t));
+    EXPECT_EQ(t, 0.0f);
+    EXPECT_FALSE(intersect(Ray{ float3(-5, 0, 0), float3(-1, 0, 0) }, box, t));
+    EXPECT_FALSE(intersect(Ray{ float3(-5, 0, 0), float3(1, 0, 0), 0.0f, 3.9f }, box, t));
+    EXPECT_FALSE(intersect(Ray{ float3(-5, 0, 0), float3(1, 1.0f, 0) }, box, t));
+    // parallel to the x slabs, inside and outside of them
+    EXPECT_TRUE(intersect(Ray{ float3(0.5f, 5, 0), float3(0, -1, 0) }, box, t));
+    EXPECT_FLOAT_EQ(t, 3.0f);
+    EXPECT_FALSE(intersect(Ray{ float3(1.5f, 5, 0), float3(0, -1, 0) }, box, t));
+}
+
+TEST_F(IntersectTest, Sphere) {
+    Sphere const s{ float3(1, 2, 3), 2.0f };
+    float t;
+    EXPECT_TRUE(intersect(Ray{ float3(1, 2, -7), float3(0, 0, 2) }, s, t));
+    EXPECT_FLOAT_EQ(t, 4.0f);
+    // from inside, the exit
+    EXPECT_TRUE(intersect(Ray{ float3(1, 2, 3), float3(0, 0, 1) }, s, t));
+    EXPECT_FLOAT_EQ(t, 2.0f);
+    EXPECT_FALSE(intersect(Ray{ float3(1, 2, -7), float3(0, 0, -1) }, s, t));
+    EXPECT_FALSE(intersect(Ray{ float3(1, 4.1f, -7), float3(0, 0, 1) }, s, t));
+    EXPECT_FALSE(intersect(Ray{ float3(1, 2, -7), float3(0, 0, 1), 0.0f, 7.9f }, s, t));
+    EXPECT_TRUE(intersect(Ray{ float3(1, 2, -7), float3(0, 0, 1), 8.5f }, s, t));
+    EXPECT_FLOAT_EQ(t, 12.0f);
+
+    // a small sphere far away, where b^2 - ac has no precision left
+    Sphere const far{ float3(0, 0, 1e5f), 0.01f };
+    EXPECT_TRUE(intersect(Ray{ float3(0, 0.009f, 0), float3(0, 0, 1) }, far, t));
+    EXPECT_NEAR(t, 1e5f - std::sqrt(0.01f * 0.01f - 0.009f * 0.009f), 0.01f);
+}
+
+TEST_F(IntersectTest, Triangle) {
+    float3 const a(0, 0, 0), b(2, 0, 0), c(0, 2, 0);
+    float t, u, v;
+    EXPECT_TRUE(intersect(Ray{ float3(0.5f, 0.5f, 3), float3(0, 0, -1) }, a, b, c, t, u, v));
+    EXPECT_FLOAT_EQ(t, 3.0f);
+    EXPECT_FLOAT_EQ(u, 0.25f);
+    EXPECT_FLOAT_EQ(v, 0.25f);
+    // back face
+    EXPECT_TRUE(intersect(Ray{ float3(0.5f, 0.5f, -3), float3(0, 0, 1) }, a, b, c, t, u, v));
+    EXPECT_FLOAT_EQ(t, 3.0f);
+    // on the edges
+    EXPECT_TRUE(intersect(Ray{ float3(1, 1, 3), float3(0, 0, -1) }, a, b, c, t, u, v));
+    EXPECT_TRUE(intersect(Ray{ float3(0, 1, 3), float3(0, 0, -1) }, a, b, c, t, u, v));
+    EXPECT_FALSE(intersect(Ray{ float3(1.1f, 1, 3), float3(0, 0, -1) }, a, b, c, t, u, v));
+    EXPECT_FALSE(intersect(Ray{ float3(0.5f, 0.5f, 3), float3(0, 0, 1) }, a, b, c, t, u, v));
+    // in the plane, and a flat triangle
+    EXPECT_FALSE(intersect(Ray{ float3(-1, 0.5f, 0), float3(1, 0, 0) }, a, b, c, t, u, v));
+    EXPECT_FALSE(intersect(Ray{ float3(0.5f, 0, 3), float3(0, 0, -1) }, a, b, b, t, u, v));
+}
+
+// the packet versions against the scalar ones, lane by lane
+template<size_t N>
+void check_packets(std::function<float3()> rand3, std::function<Ray()> rand_ray) {
+    typedef details::Packet<N> P;
+    typedef details::Vector3<P> P3;
+    auto const set = [](P3& p, size_t i, const float3& v) {
+        p.x[i] = v.x;
+        p.y[i] = v.y;
+        p.z[i] = v.z;
+    };
+    size_t hit_count = 0;
+    for (size_t k = 0; k < 200; k++) {
+        Ray const ray = rand_ray();
+        Aabb boxes[N];
+        Sphere spheres[N];
+        float3 tri[N][3];
+        Ray rays[N];
+        P3 bmin, bmax, centers, ta, tb, tc;
+        P radii;
+        details::RayPacket<N> packet;
+        for (size_t i = 0; i < N; i++) {
+            float3 const c = rand3();
+            boxes[i] = Aabb::from_center_extent(c, abs(rand3()));
+            spheres[i] = Sphere{ rand3(), std::abs(rand3().x) + 0.1f };
+            for (size_t j = 0; j < 3; j++) {
+                tri[i][j] = rand3() * 2.0f;
+            }
+            set(bmin, i, boxes[i].min);
+            set(bmax, i, boxes[i].max);
+            set(centers, i, spheres[i].center);
+            radii[i] = spheres[i].radius;
+            set(ta, i, tri[i][0]);
+            set(tb, i, tri[i][1]);
+            set(tc, i, tri[i][2]);
+            rays[i] = rand_ray();
+            set(packet.origin, i, rays[i].origin);
+            set(packet.direction, i, rays[i].direction);
+            packet.t_min[i] = rays[i].t_min;
+            packet.t_max[i] = rays[i].t_max;
+        }
+
+        P t, u, v;
+        float st, su, sv;
+        uint32_t mask = intersect(ray, bmin, bmax, t);
+        for (size_t i = 0; i < N; i++) {
+            bool const hit = intersect(ray, boxes[i], st);
+            hit_count += hit;
+            EXPECT_EQ(bool(mask & (1u << i)), hit);
+            if (hit) {
+                EXPECT_NEAR(t[i], st, 1e-4f);
+            }
+        }
+        mask = intersect(packet, boxes[0], t);
+        for (size_t i = 0; i < N; i++) {
+            bool const hit = intersect(rays[i], boxes[0], st);
+            EXPECT_EQ(bool(mask & (1u << i)), hit);
+            if (hit) {
+                EXPECT_NEAR(t[i], st, 1e-4f);
+            }
+        }
+        mask = intersect(ray, centers, radii, t);
+        for (size_t i = 0; i < N; i++) {
+            bool const hit = intersect(ray, spheres[i], st);
+            hit_count += hit;
+            EXPECT_EQ(bool(mask & (1u << i)), hit);
+            if (hit) {
+                EXPECT_NEAR(t[i], st, 1e-4f);
+            }
+        }
+        mask = intersect(packet, spheres[0], t);
+        for (size_t i = 0; i < N; i++) {
+            bool const hit = intersect(rays[i], spheres[0], st);
+            EXPECT_EQ(bool(mask & (1u << i)), hit);
+            if (hit) {
+                EXPECT_NEAR(t[i], st, 1e-4f);
+            }
+        }
+        mask = intersect(ray, ta, tb, tc, t, u, v);
+        for (size_t i = 0; i < N; i++) {
+            bool const hit = intersect(ray, tri[i][0], tri[i][1], tri[i][2], st, su, sv);
+            hit_count += hit;
+            EXPECT_EQ(bool(mask & (1u << i)), hit);
+            if (hit) {
+                EXPECT_NEAR(t[i], st, 1e-4f);
+                EXPECT_NEAR(u[i], su, 1e-4f);
+                EXPECT_NEAR(v[i], sv, 1e-4f);
+                // the barycentrics give the hit point
+                float3 const p = tri[i][0] + (tri[i][1] - tri[i][0]) * su +
+                                 (tri[i][2] - tri[i][0]) * sv;
+                EXPECT_NEAR(length(p - (ray.origin + ray.direction * st)), 0.0f, 1e-4f);
+            }
+        }
+        mask = intersect(packet, tri[0][0], tri[0][1], tri[0][2], t, u, v);
+        for (size_t i = 0; i < N; i++) {
+            bool const hit = intersect(rays[i], tri[0][0], tri[0][1], tri[0][2], st, su, sv);
+            EXPECT_EQ(bool(mask & (1u << i)), hit);
+            if (hit) {
+                EXPECT_NEAR(t[i], st, 1e-4f);
+            }
+        }
+    }
+    // the random cases are not all misses
+    EXPECT_GT(hit_count, 100u);
+}
+
+TEST_F(IntersectTest, Packets) {
+    auto const r3 = [this]() { return rand3(); };
+    auto const rr = [this]() { return rand_ray(); };
+    check_packets<4>(r3, rr);
+    check_packets<8>(r3, rr);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <numeric/lut.h>
+
+using namespace numeric;
+
+namespace {
+
+struct square {
+    constexpr double operator()(double x) const noexcept { return x * x; }
+};
+
+double srgb_to_linear_ref(double x) {
+    return x <= 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
+}
+
+double linear_to_srgb_ref(double x) {
+    return x <= 0.0031308 ? x * 12.92 : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+}
+
+// max |lut(x) - ref(x)| over a sweep of [lo, hi] that falls between the samples
+template<typename LUT, typename REF>
+double max_error(const LUT& table, REF ref, float lo, float hi) {
+    double e = 0.0;
+    for (size_t i = 0; i <= 100000; i++) {
+        float const x = lo + (hi - lo) * float(i) / 100000.0f;
+        e = std::max(e, std::abs(table(x) - ref(x)));
+    }
+    return e;
+}
+
+} // namespace
+
+TEST(LutTest, ConstexprMath) {
+    for (double x : { 1e-6, 0.01, 0.3, 0.5, 1.0, 1.7, 10.0, 12345.0 }) {
+        EXPECT_NEAR(details::lookup::log(x), std::log(x),
+                1e-14 * std::max(1.0, std::abs(std::log(x))));
+        EXPECT_NEAR(details::lookup::pow(x, 2.4) / std::pow(x, 2.4), 1.0, 1e-13);
+        EXPECT_NEAR(details::lookup::pow(x, 1.0 / 2.4) / std::pow(x, 1.0 / 2.4), 1.0, 1e-13);
+    }
+    for (double x : { -20.0, -1.0, -0.1, 0.0, 0.5, 3.0, 40.0 }) {
+        EXPECT_NEAR(details::lookup::exp(x) / std::exp(x), 1.0, 1e-14);
+    }
+    EXPECT_EQ(details::lookup::pow(0.0, 2.0), 0.0);
+}
+
+TEST(LutTest, Interpolation) {
+    constexpr lut<5, square> table(-1.0f, 3.0f);
+    static_assert(table[0] == 1.0f && table[2] == 1.0f && table[4] == 9.0f,
+            "built at compile time");
+    static_assert(table(0.5f) == 0.5f, "interpolated at compile time");
+    EXPECT_EQ(table.size(), 5u);
+    EXPECT_EQ(table(-1.0f), 1.0f);
+    EXPECT_EQ(table(3.0f), 9.0f);
+    EXPECT_EQ(table(2.5f), 6.5f);
+    // clamped
+    EXPECT_EQ(table(-10.0f), 1.0f);
+    EXPECT_EQ(table(10.0f), 9.0f);
+    EXPECT_EQ(table(NAN), 1.0f);
+    EXPECT_EQ(table.nearest(0.4f), 0.0f);
+    EXPECT_EQ(table.nearest(0.6f), 1.0f);
+    EXPECT_EQ(table.nearest(-5.0f), 1.0f);
+    EXPECT_EQ(table.nearest(5.0f), 9.0f);
+
+    // the batch version is the scalar one
+    std::vector<float> in, out, expected;
+    for (size_t i = 0; i < 37; i++) {
+        float const x = -1.5f + 0.13f * i;
+        in.push_back(x);
+        expected.push_back(table(x));
+    }
+    in.push_back(NAN);
+    expected.push_back(1.0f);
+    out.resize(in.size());
+    table(in.data(), out.data(), in.size());
+    for (size_t i = 0; i < in.size(); i++) {
+        EXPECT_NEAR(out[i], expected[i], 1e-6f);
+    }
+    table(in.data(), in.data(), in.size());
+    EXPECT_EQ(in, out);
+}
+
+TEST(LutTest, Srgb) {
+    auto const& srgb8 = srgb8_to_linear_lut();
+    for (size_t i = 0; i < 256; i++) {
+        double const expected = srgb_to_linear_ref(i / 255.0);
+        EXPECT_NEAR(srgb8[i], expected, 1e-7 * std::max(expected, 1e-3));
+    }
+    EXPECT_EQ(srgb8[0], 0.0f);
+    EXPECT_EQ(srgb8[255], 1.0f);
+
+    EXPECT_LT(max_error(srgb_to_linear_lut(), srgb_to_linear_ref, 0.0f, 1.0f), 3e-6);
+    EXPECT_LT(max_error(linear_to_srgb_lut(), linear_to_srgb_ref, 0.0f, 1.0f), 3e-5);
+
+    // round trip through 8 bits
+    for (size_t i = 0; i < 256; i++) {
+        EXPECT_EQ(int(std::lround(linear_to_srgb_lut()(srgb8[i]) * 255.0f)), int(i));
+    }
+}
+
+TEST(LutTest, ToneCurve) {
+    auto const aces = [](double x) {
+        return std::min(1.0, (x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14));
+    };
+    EXPECT_LT(max_error(aces_tone_curve_lut(), aces, 0.0f, 16.0f), 1e-4);
+    EXPECT_EQ(aces_tone_curve_lut()(100.0f), 1.0f);
+    EXPECT_EQ(aces_tone_curve_lut()(0.0f), 0.0f);
+}
@@ -142,6 +142,96 @@ TEST_F(MatTest, ElementAccess) {
     EXPECT_FLOAT_EQ(m(3, 2), 100);
 }
 
+// The SIMD mat4f products must agree with the scalar reference. Without FMA the operations
+// happen in the same order and the results are bit-exact; with FMA each lane can differ by
+// at most a few rounding errors of the sum of the magnitudes of its terms.
+TEST_F(MatTest, SimdProducts) {
+    std::default_random_engine generator(171717);
+    std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+    auto rand_gen = std::bind(distribution, generator);
+    auto rand_vec = [&]() { return float4(rand_gen(), rand_gen(), rand_gen(), rand_gen()); };
+    const float eps = 4 * std::numeric_limits<float>::epsilon();
+
+    for (size_t i = 0; i < 1000; ++i) {
+        mat4f a(rand_vec(), rand_vec(), rand_vec(), rand_vec());
+        mat4f b(rand_vec(), rand_vec(), rand_vec(), rand_vec());
+        float4 v = rand_vec();
+
+        float4 av = a * v;
+        float4 av_ref = details::matrix::transform_scalar(a, v);
+        float4 av_mag = details::matrix::transform_scalar(abs(a), abs(v));
+        for (size_t r = 0; r < 4; r++) {
+            EXPECT_NEAR(av_ref[r], av[r], eps * av_mag[r]);
+        }
+
+        mat4f ab = a * b;
+        mat4f ab_ref = details::matrix::multiply_scalar<mat4f>(a, b);
+        mat4f ab_mag = details::matrix::multiply_scalar<mat4f>(abs(a), abs(b));
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 4; r++) {
+                EXPECT_NEAR(ab_ref[c][r], ab[c][r], eps * ab_mag[c][r]);
+            }
+        }
+
+        mat4f abi(a);
+        abi *= b;
+        EXPECT_TRUE(ab == abi);
+    }
+
+    // mat4f * float3 goes through the float4 path with w = 1
+    mat4f t = mat4f::translate(float3(1, 2, 3));
+    EXPECT_EQ(float4(2, 3, 4, 1), t * float3(1, 1, 1));
+    EXPECT_EQ(mat4f(2), mat4f() * 2.0f);
+}
+
+template<typename T>
+static void checkFastInverses() {
+    typedef details::Matrix44<T> M;
+    typedef details::Vector3<T> V;
+    std::default_random_engine generator(272727);
+    std::uniform_real_distribution<T> distribution(-10, 10);
+    auto rand_gen = std::bind(distribution, generator);
+    auto rand_vec = [&]() { return V(rand_gen(), rand_gen(), rand_gen()); };
+    const T eps = 1024 * std::numeric_limits<T>::epsilon();
+
+    auto expect_near = [eps](const M& a, const M& b) {
+        for (size_t c = 0; c < 4; c++) {
+            for (size_t r = 0; r < 4; r++) {
+                EXPECT_NEAR(a[c][r], b[c][r], eps * (1 + std::abs(a[c][r])));
+            }
+        }
+    };
+
+    for (size_t i = 0; i < 100; ++i) {
+        V const t = rand_vec();
+        V const s = rand_vec();
+        M const rotation = M::euler_zyx(rand_gen(), rand_gen(), rand_gen());
+        M const rigid = M::translate(t) * rotation;
+        M const affine = rigid * M::scale(s);
+
+        expect_near(inverse(affine), affine_inverse(affine));
+        expect_near(inverse(rigid), rigid_inverse(rigid));
+        expect_near(M(), affine * affine_inverse(affine));
+        expect_near(M(), rigid * rigid_inverse(rigid));
+
+        // inverse_fast() picks the right path
+        expect_near(inverse(affine), inverse_fast(affine));
+        expect_near(inverse(rigid), inverse_fast(rigid));
+        // same path, but FMA contraction can differ between the two inlined copies
+        expect_near(rigid_inverse(rigid), inverse_fast(rigid));
+    }
+
+    // projections aren't affine
+    M const p = M::perspective(45, 1.5, 0.1, 100);
+    EXPECT_TRUE(inverse(p) == inverse_fast(p));
+    EXPECT_TRUE(affine_inverse(M::scale(T(4))) == M::scale(T(0.25)));
+}
+
+TEST_F(MatTest, FastInverses) {
+    checkFastInverses<float>();
+    checkFastInverses<double>();
+}
+
 //------------------------------------------------------------------------------
 // MAT 3
 //------------------------------------------------------------------------------
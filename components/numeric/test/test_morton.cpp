@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <numeric/morton.h>
+
+using namespace numeric;
+
+static_assert(details::morton::part1by1(0xFFFFu) == 0x55555555u, "part1by1");
+static_assert(details::morton::part1by2(0x3FFu) == 0x09249249u, "part1by2");
+static_assert(details::morton::compact1by2(details::morton::part1by2(uint64_t(0x1FFFFF))) ==
+        0x1FFFFF, "compact1by2");
+
+class MortonTest : public testing::Test {
+protected:
+    std::mt19937 rand_gen{ 4242 };
+};
+
+TEST_F(MortonTest, Encode) {
+    EXPECT_EQ(encode_morton2(uint2(1, 0)), 1u);
+    EXPECT_EQ(encode_morton2(uint2(0, 1)), 2u);
+    EXPECT_EQ(encode_morton2(uint2(0xFFFF, 0)), 0x55555555u);
+    EXPECT_EQ(encode_morton2(uint2(0, 0xFFFF)), 0xAAAAAAAAu);
+    EXPECT_EQ(encode_morton3(uint3(1, 1, 1)), 7u);
+    EXPECT_EQ(encode_morton3(uint3(0, 0, 2)), 32u);
+    EXPECT_EQ(encode_morton3(uint3(0x3FF, 0x3FF, 0x3FF)), 0x3FFFFFFFu);
+    EXPECT_EQ(encode_morton2_64(uint2(0xFFFFFFFF, 0)), 0x5555555555555555ull);
+    EXPECT_EQ(encode_morton3_64(uint3(0, 0x1FFFFF, 0)), 0x2492492492492492ull);
+    EXPECT_EQ(encode_morton3_64(uint3(0x1FFFFF)), 0x7FFFFFFFFFFFFFFFull);
+
+    // the higher bits are ignored
+    EXPECT_EQ(encode_morton2(uint2(0x10001, 0)), 1u);
+    EXPECT_EQ(encode_morton3(uint3(0, 0x401, 0)), 2u);
+    EXPECT_EQ(encode_morton3_64(uint3(0x200001, 0, 0)), 1u);
+}
+
+TEST_F(MortonTest, RoundTrip) {
+    using namespace details::morton;
+    for (size_t i = 0; i < 100000; i++) {
+        uint32_t const a = rand_gen(), b = rand_gen(), c = rand_gen();
+
+        uint2 const p2(a & 0xFFFF, b & 0xFFFF);
+        uint32_t const m2 = encode_morton2(p2);
+        // same as the shifts and masks when pdep is used
+        EXPECT_EQ(m2, part1by1(p2.x) | (part1by1(p2.y) << 1));
+        EXPECT_EQ(decode_morton2(m2), p2);
+
+        uint3 const p3(a & 0x3FF, b & 0x3FF, c & 0x3FF);
+        uint32_t const m3 = encode_morton3(p3);
+        EXPECT_EQ(m3, part1by2(p3.x) | (part1by2(p3.y) << 1) | (part1by2(p3.z) << 2));
+        EXPECT_EQ(decode_morton3(m3), p3);
+
+        uint2 const q2(a, b);
+        uint64_t const n2 = encode_morton2_64(q2);
+        EXPECT_EQ(n2, part1by1(uint64_t(a)) | (part1by1(uint64_t(b)) << 1));
+        EXPECT_EQ(decode_morton2_64(n2), q2);
+
+        uint3 const q3(a & 0x1FFFFF, b & 0x1FFFFF, c & 0x1FFFFF);
+        uint64_t const n3 = encode_morton3_64(q3);
+        EXPECT_EQ(n3, part1by2(uint64_t(q3.x)) | (part1by2(uint64_t(q3.y)) << 1) |
+                      (part1by2(uint64_t(q3.z)) << 2));
+        EXPECT_EQ(decode_morton3_64(n3), q3);
+    }
+}
+
+TEST_F(MortonTest, Positions) {
+    Aabb const bounds{ float3(-8, 0, 2), float3(8, 16, 2) };
+    std::uniform_real_distribution<float> dist(-10.0f, 20.0f);
+    for (size_t count : { 0, 1, 7, 8, 100 }) {
+        std::vector<float3> pos(count);
+        for (float3& p : pos) {
+            p = float3(dist(rand_gen), dist(rand_gen), dist(rand_gen));
+        }
+        std::vector<uint32_t> c32(count);
+        std::vector<uint64_t> c64(count);
+        morton_codes(pos.data(), bounds, c32.data(), count);
+        morton_codes(pos.data(), bounds, c64.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            float3 const t = clamp((pos[i] - bounds.min) / 16.0f, 0.0f, 1.0f);
+            uint3 const cell32 = decode_morton3(c32[i]);
+            uint3 const cell64 = decode_morton3_64(c64[i]);
+            for (size_t k = 0; k < 2; k++) {
+                EXPECT_EQ(cell32[k], std::min(uint32_t(t[k] * 1024.0f), 1023u));
+                EXPECT_EQ(cell64[k], std::min(uint32_t(t[k] * 2097152.0f), 2097151u));
+            }
+            // flat along z
+            EXPECT_EQ(cell32.z, 0u);
+            EXPECT_EQ(cell64.z, 0u);
+        }
+    }
+
+    // the corners of the grid
+    float3 const corners[] = { float3(-8, 0, 2), float3(8, 16, 2), float3(8, 0, 2) };
+    uint32_t c[3];
+    morton_codes(corners, bounds, c, 3);
+    EXPECT_EQ(c[0], 0u);
+    EXPECT_EQ(c[1], encode_morton3(uint3(1023, 1023, 0)));
+    EXPECT_EQ(c[2], encode_morton3(uint3(1023, 0, 0)));
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include <string.h>
+#include <vector>
+#include <numeric/norm.h>
+
+using namespace numeric;
+
+class NormTest : public testing::Test {
+protected:
+    // every float in [-2, 2] with a stride over the bit patterns, plus the special values;
+    // the count is odd on purpose so that the array functions also go through their tail
+    static std::vector<float4> inputs() {
+        std::vector<float> f = {
+                0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f,
+                std::numeric_limits<float>::infinity(),
+                -std::numeric_limits<float>::infinity(),
+                std::numeric_limits<float>::quiet_NaN(),
+                std::numeric_limits<float>::denorm_min(),
+                -std::numeric_limits<float>::denorm_min() };
+        // exact ties of every format
+        for (int i = 0; i < 65535; i++) {
+            f.push_back((i + 0.5f) / 65535.0f);
+            f.push_back((i + 0.5f) / 32767.0f);
+            f.push_back(-(i + 0.5f) / 32767.0f);
+        }
+        for (int i = 0; i < 255; i++) {
+            f.push_back(float((i + 0.5) / 255.0));
+            f.push_back(float((i + 0.5) / 127.0));
+            f.push_back(-float((i + 0.5) / 127.0));
+        }
+        for (uint32_t bits = 0; bits <= 0x40000000u; bits += 2053) {
+            float v;
+            memcpy(&v, &bits, sizeof(v));
+            f.push_back(v);
+            f.push_back(-v);
+        }
+        while (f.size() % 8 != 4) {
+            f.push_back(0.25f);
+        }
+        std::vector<float4> r(f.size() / 4);
+        memcpy(r.data(), f.data(), f.size() * sizeof(float));
+        return r;
+    }
+};
+
+#define EXPECT_SAME_FLOAT4(A, B)                                \
+do {                                                            \
+    const float4 a = A;                                         \
+    const float4 b = B;                                         \
+    EXPECT_EQ(0, memcmp(&a, &b, sizeof(float4))) << i;          \
+} while(0)
+
+// every pack_*norm*() array function against the scalar one
+static void compare_packs(float4 const* in, size_t count) {
+    std::vector<ushort4> u16(count);
+    std::vector<short4> s16(count);
+    std::vector<short2> s16x2(count * 2);
+    std::vector<ubyte4> u8(count);
+    std::vector<byte4> s8(count);
+    pack_unorm16(in, u16.data(), count);
+    pack_snorm16(in, s16.data(), count);
+    pack_snorm16(reinterpret_cast<float2 const*>(in), s16x2.data(), count * 2);
+    pack_unorm8(in, u8.data(), count);
+    pack_snorm8(in, s8.data(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(pack_unorm16(in[i]), u16[i]) << i;
+        EXPECT_EQ(pack_snorm16(in[i]), s16[i]) << i;
+        EXPECT_EQ(pack_snorm16(in[i].xy), s16x2[i * 2]) << i;
+        EXPECT_EQ(pack_snorm16(in[i].zw), s16x2[i * 2 + 1]) << i;
+        EXPECT_EQ(pack_unorm8(in[i]), u8[i]) << i;
+        EXPECT_EQ(pack_snorm8(in[i]), s8[i]) << i;
+    }
+}
+
+TEST_F(NormTest, PackArrays) {
+    std::vector<float4> const in = inputs();
+    ASSERT_EQ(1u, in.size() % 2);
+    compare_packs(in.data(), in.size());
+}
+
+// every float bit pattern, in each lane in turn, takes minutes
+TEST_F(NormTest, DISABLED_PackArraysExhaustive) {
+    constexpr size_t CHUNK = 4096;
+    std::vector<float4> in(CHUNK);
+    for (uint64_t bits = 0; bits <= 0xFFFFFFFFull && !HasFailure(); ) {
+        for (size_t i = 0; i < CHUNK * 4; i++, bits++) {
+            uint32_t const b = uint32_t(bits);
+            memcpy(&in[i / 4][i % 4], &b, sizeof(b));
+        }
+        compare_packs(in.data(), CHUNK);
+    }
+}
+
+TEST_F(NormTest, UnpackArrays) {
+    // all the 16-bit values, plus one element for the tail
+    size_t const count = 65536 / 4 + 1;
+    std::vector<ushort4> u16(count);
+    std::vector<short4> s16(count);
+    for (size_t i = 0; i < count * 4; i++) {
+        u16[i / 4][i % 4] = uint16_t(i);
+        s16[i / 4][i % 4] = int16_t(i);
+    }
+    std::vector<ubyte4> u8(u16.size());
+    std::vector<byte4> s8(u16.size());
+    for (size_t i = 0; i < count; i++) {
+        u8[i] = ubyte4(u16[i]);
+        s8[i] = byte4(s16[i]);
+    }
+
+    std::vector<float4> out(count);
+    size_t i;
+    unpack_unorm16(u16.data(), out.data(), count);
+    for (i = 0; i < count; i++) {
+        EXPECT_SAME_FLOAT4(unpack_unorm16(u16[i]), out[i]);
+    }
+    unpack_snorm16(s16.data(), out.data(), count);
+    for (i = 0; i < count; i++) {
+        EXPECT_SAME_FLOAT4(unpack_snorm16(s16[i]), out[i]);
+    }
+    unpack_unorm8(u8.data(), out.data(), count);
+    for (i = 0; i < count; i++) {
+        EXPECT_SAME_FLOAT4(unpack_unorm8(u8[i]), out[i]);
+    }
+    unpack_snorm8(s8.data(), out.data(), count);
+    for (i = 0; i < count; i++) {
+        EXPECT_SAME_FLOAT4(unpack_snorm8(s8[i]), out[i]);
+    }
+}
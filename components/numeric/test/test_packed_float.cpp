@@ -0,0 +1,220 @@
+#include <math.h>
+#include <string.h>
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric/packed_float.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+// the scalar versions are usable in constant expressions
+static_assert(pack_rgb9e5(float3(1, 1, 1)) == 0x84020100u, "pack_rgb9e5");
+static_assert(unpack_rgb9e5(0x84020100u).y == 1.0f, "unpack_rgb9e5");
+static_assert(pack_r11g11b10f(float3(1, 1, 1)) == 0x781E03C0u, "pack_r11g11b10f");
+static_assert(unpack_r11g11b10f(pack_r11g11b10f(float3(0.5f, 2, 65024))).z == 64512.0f,
+        "unpack_r11g11b10f");
+
+class PackedFloatTest : public RandomTest {
+protected:
+    PackedFloatTest() : RandomTest(0.0f, 1.0f, 313131) {}
+
+    static uint32_t bits(float f) {
+        uint32_t b;
+        memcpy(&b, &f, sizeof(b));
+        return b;
+    }
+
+    static float from_bits(uint32_t b) {
+        float f;
+        memcpy(&f, &b, sizeof(f));
+        return f;
+    }
+
+    // same value, or both NaN
+    static bool same(float a, float b) {
+        return bits(a) == bits(b) || (std::isnan(a) && std::isnan(b));
+    }
+
+    static bool same(const float3& a, const float3& b) {
+        return same(a.r, b.r) && same(a.g, b.g) && same(a.b, b.b);
+    }
+
+    static std::vector<float3> unpack_all(const std::vector<uint32_t>& codes,
+            void (*unpack)(uint32_t const*, float3*, size_t)) {
+        std::vector<float3> out(codes.size());
+        unpack(codes.data(), out.data(), codes.size());
+        return out;
+    }
+};
+
+TEST_F(PackedFloatTest, R11G11B10FCodes) {
+    // every code of every channel, one code per channel in turn
+    std::vector<uint32_t> codes;
+    for (uint32_t c = 0; c < 2048; c++) {
+        codes.push_back(c);
+        codes.push_back(c << 11);
+        if (c < 1024) {
+            codes.push_back(c << 22);
+        }
+    }
+    std::vector<float3> const values = unpack_all(codes, unpack_r11g11b10f);
+    std::vector<uint32_t> repacked(codes.size());
+    pack_r11g11b10f(values.data(), repacked.data(), values.size());
+
+    for (size_t i = 0; i < codes.size(); i++) {
+        EXPECT_TRUE(same(values[i], unpack_r11g11b10f(codes[i]))) << std::hex << codes[i];
+        // NaNs come back with all the mantissa bits set
+        uint32_t const c = codes[i];
+        bool const nan = std::isnan(values[i].r) || std::isnan(values[i].g) ||
+                std::isnan(values[i].b);
+        if (nan) {
+            EXPECT_EQ(repacked[i] | c, repacked[i]) << std::hex << c;
+            continue;
+        }
+        EXPECT_EQ(repacked[i], c) << std::hex << c;
+        if (!std::isinf(values[i].r) && !std::isinf(values[i].g) && !std::isinf(values[i].b)) {
+            EXPECT_EQ(pack_r11g11b10f(values[i]), c) << std::hex << c;
+        }
+    }
+
+    EXPECT_EQ(unpack_r11g11b10f(0x7BF).r, 65024.0f);
+    EXPECT_EQ(unpack_r11g11b10f(0x3DFu << 22).b, 64512.0f);
+    EXPECT_EQ(unpack_r11g11b10f(1).r, ldexpf(1, -20));
+    EXPECT_EQ(unpack_r11g11b10f(1u << 22).b, ldexpf(1, -19));
+}
+
+TEST_F(PackedFloatTest, RGB9E5Codes) {
+    // every exponent and mantissa of every channel
+    std::vector<uint32_t> codes;
+    for (uint32_t e = 0; e < 32; e++) {
+        for (uint32_t m = 0; m < 512; m++) {
+            for (uint32_t shift : { 0, 9, 18 }) {
+                codes.push_back((e << 27) | (m << shift));
+            }
+        }
+    }
+    std::vector<float3> const values = unpack_all(codes, unpack_rgb9e5);
+    std::vector<uint32_t> repacked(codes.size());
+    pack_rgb9e5(values.data(), repacked.data(), values.size());
+
+    for (size_t i = 0; i < codes.size(); i++) {
+        uint32_t const c = codes[i];
+        uint32_t const e = c >> 27;
+        uint32_t const m = (c | (c >> 9) | (c >> 18)) & 0x1FF;
+        EXPECT_TRUE(same(values[i], unpack_rgb9e5(c))) << std::hex << c;
+        EXPECT_EQ(repacked[i], pack_rgb9e5(values[i])) << std::hex << c;
+        // the smallest exponent that holds the mantissa is the canonical encoding, the others
+        // decode to the same value
+        if (m >= 256 || (e == 0 && m > 0)) {
+            EXPECT_EQ(repacked[i], c) << std::hex << c;
+        }
+        EXPECT_EQ(unpack_rgb9e5(repacked[i]), values[i]) << std::hex << c;
+    }
+
+    EXPECT_EQ(unpack_rgb9e5(0xFFFFFFFFu), float3(65408.0f));
+    EXPECT_EQ(unpack_rgb9e5(1).r, ldexpf(1, -24));
+}
+
+TEST_F(PackedFloatTest, Specials) {
+    float const nan = from_bits(0x7FC00000u);
+    float const inf = from_bits(0x7F800000u);
+    std::vector<float3> const in = {
+            float3(nan, inf, -1.0f), float3(-inf, 1e9f, -0.0f), float3(0.0f, 65535.0f, 1e-30f),
+            float3(-nan, 65023.0f, 64511.0f) };
+    std::vector<uint32_t> r11(in.size()), e5(in.size());
+    pack_r11g11b10f(in.data(), r11.data(), in.size());
+    pack_rgb9e5(in.data(), e5.data(), in.size());
+
+    EXPECT_EQ(r11[0], 0x7FFu | (0x7C0u << 11));
+    EXPECT_EQ(r11[1], 0x7BFu << 11);
+    EXPECT_EQ(r11[2], 0x7BFu << 11);
+    EXPECT_EQ(r11[3], 0x7FFu | (0x7BFu << 11) | (0x3DFu << 22));
+    EXPECT_TRUE(std::isnan(unpack_r11g11b10f(r11[0]).r));
+    EXPECT_TRUE(std::isinf(unpack_r11g11b10f(r11[0]).g));
+
+    EXPECT_EQ(unpack_rgb9e5(e5[0]), float3(0, 65408, 0));
+    EXPECT_EQ(unpack_rgb9e5(e5[1]), float3(0, 65408, 0));
+    EXPECT_EQ(unpack_rgb9e5(e5[2]), float3(0, 65408, 0));
+}
+
+TEST_F(PackedFloatTest, Rounding) {
+    // halfway between 1 and the next value: even for R11G11B10F, up for RGB9E5
+    float const h6 = 1.0f + ldexpf(1, -7);
+    float const h8 = 1.0f + ldexpf(1, -9);
+    EXPECT_EQ(pack_r11g11b10f(float3(h6, 1.0f + 3 * ldexpf(1, -7), 0)) & 0x3FFFFF,
+            0x3C0u | (0x3C2u << 11));
+    EXPECT_EQ(pack_rgb9e5(float3(h8, 0, 0)) & 0x1FF, 257u);
+    // rounding up the largest mantissa bumps the shared exponent
+    EXPECT_EQ(pack_rgb9e5(float3(2.0f - ldexpf(1, -10), 0.25f, 0)),
+              (17u << 27) | 256u | (32u << 9));
+
+    // relative error, half a step of the mantissa
+    for (size_t i = 0; i < 10000; i++) {
+        float3 const v = rand3() * 1000.0f + 0.01f;
+        float3 const r = unpack_r11g11b10f(pack_r11g11b10f(v));
+        EXPECT_LE(std::abs(r.r - v.r), v.r * ldexpf(1, -7));
+        EXPECT_LE(std::abs(r.g - v.g), v.g * ldexpf(1, -7));
+        EXPECT_LE(std::abs(r.b - v.b), v.b * ldexpf(1, -6));
+        // relative to the largest component for the shared exponent
+        float3 const s = unpack_rgb9e5(pack_rgb9e5(v));
+        float const m = std::max(v.r, std::max(v.g, v.b));
+        for (size_t c = 0; c < 3; c++) {
+            EXPECT_LE(std::abs(s[c] - v[c]), m * ldexpf(1, -9));
+        }
+    }
+}
+
+// Walks an evenly spread subset of the float bit patterns, the scalar versions are only
+// compared on finite values (see packed_float.h).
+template<typename F>
+static void forPatterns(uint64_t stride, F f) {
+    constexpr size_t CHUNK = 4096;
+    std::vector<float3> in(CHUNK);
+    uint64_t bits = 0;
+    while (bits <= 0xFFFFFFFFull) {
+        size_t n = 0;
+        for (; n < CHUNK && bits <= 0xFFFFFFFFull; n++, bits += stride) {
+            uint32_t const b = uint32_t(bits);
+            uint32_t const r = b * 0x9E3779B9u;   // spreads the other channels around
+            float x, y, z;
+            memcpy(&x, &b, sizeof(x));
+            memcpy(&y, &r, sizeof(y));
+            uint32_t const s = r ^ (r >> 7);
+            memcpy(&z, &s, sizeof(z));
+            in[n] = float3(x, y, z);
+        }
+        f(in.data(), n);
+    }
+}
+
+static void compareWithScalar(float3 const* in, size_t n) {
+    std::vector<uint32_t> r11(n), e5(n);
+    pack_r11g11b10f(in, r11.data(), n);
+    pack_rgb9e5(in, e5.data(), n);
+    for (size_t i = 0; i < n; i++) {
+        float3 const v = in[i];
+        if (!std::isfinite(v.r) || !std::isfinite(v.g) || !std::isfinite(v.b)) {
+            continue;
+        }
+        ASSERT_EQ(r11[i], pack_r11g11b10f(v)) << v.r << " " << v.g << " " << v.b;
+        ASSERT_EQ(e5[i], pack_rgb9e5(v)) << v.r << " " << v.g << " " << v.b;
+    }
+}
+
+TEST_F(PackedFloatTest, ArraysMatchScalar) {
+    forPatterns(4099, compareWithScalar);
+    // odd sizes go through the tail
+    for (size_t count : { 0, 1, 3, 5, 7 }) {
+        std::vector<float3> in(count);
+        for (float3& v : in) {
+            v = rand3() * 100.0f;
+        }
+        compareWithScalar(in.data(), count);
+    }
+}
+
+// every float in the first channel, takes tens of minutes
+TEST_F(PackedFloatTest, DISABLED_ArraysMatchScalarExhaustive) {
+    forPatterns(1, compareWithScalar);
+}
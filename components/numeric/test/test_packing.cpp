@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include <numeric/mat3.h>
+#include <numeric/packing.h>
+#include <numeric/quat.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+class PackingTest : public RandomTest {
+protected:
+    PackingTest() : RandomTest(-1.0f, 1.0f, 929292) {}
+
+    float3 rand_unit() {
+        float3 v;
+        do {
+            v = rand3();
+        } while (length2(v) < 1e-4f || length2(v) > 1.0f);
+        return normalize(v);
+    }
+
+    // angle between two vectors in degrees
+    static double angle(const float3& a, const float3& b) {
+        double3 const da(a), db(b);
+        double const c = dot(da, db) / (length(da) * length(db));
+        return std::acos(std::min(1.0, std::max(-1.0, c))) * 180.0 / M_PI;
+    }
+};
+
+TEST_F(PackingTest, Octahedral) {
+    // the axes and diagonals are exact
+    for (float3 const& v : { float3(1, 0, 0), float3(0, -1, 0), float3(0, 0, 1),
+            float3(0, 0, -1), float3(-1, 0, 0) }) {
+        EXPECT_EQ(unpack_oct16(pack_oct16(v)), v);
+        EXPECT_EQ(unpack_oct32(pack_oct32(v)), v);
+    }
+
+    double max16 = 0, max32 = 0;
+    for (size_t i = 0; i < 100000; i++) {
+        float3 const v = rand_unit();
+        max16 = std::max(max16, angle(v, unpack_oct16(pack_oct16(v))));
+        max32 = std::max(max32, angle(v, unpack_oct32(pack_oct32(v))));
+        EXPECT_NEAR(length(unpack_oct16(pack_oct16(v))), 1.0f, 1e-6f);
+    }
+    EXPECT_LT(max16, 1.2);
+    EXPECT_LT(max32, 0.005);
+}
+
+TEST_F(PackingTest, OctahedralArrays) {
+    for (size_t count : { 0, 1, 7, 100 }) {
+        std::vector<float3> in(count), out16(count), out32(count);
+        std::vector<byte2> p16(count);
+        std::vector<short2> p32(count);
+        for (float3& v : in) {
+            v = rand_unit();
+        }
+        pack_oct16(in.data(), p16.data(), count);
+        pack_oct32(in.data(), p32.data(), count);
+        unpack_oct16(p16.data(), out16.data(), count);
+        unpack_oct32(p32.data(), out32.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            byte2 const r16 = pack_oct16(in[i]);
+            short2 const r32 = pack_oct32(in[i]);
+            EXPECT_LE(std::abs(p16[i].x - r16.x), 1);
+            EXPECT_LE(std::abs(p16[i].y - r16.y), 1);
+            EXPECT_LE(std::abs(p32[i].x - r32.x), 1);
+            EXPECT_LE(std::abs(p32[i].y - r32.y), 1);
+            EXPECT_LT(angle(in[i], out16[i]), 1.2);
+            EXPECT_LT(angle(in[i], out32[i]), 0.005);
+            EXPECT_LT(angle(unpack_oct32(p32[i]), out32[i]), 1e-3);
+        }
+    }
+}
+
+TEST_F(PackingTest, QTangent) {
+    size_t const count = 20000;
+    std::vector<mat3f> frames(count);
+    std::vector<byte4> p8(count);
+    std::vector<short4> p16(count);
+    std::vector<float3> normals(count);
+    std::vector<float4> tangents(count);
+    for (size_t i = 0; i < count; i++) {
+        quatf const q = rand_rotation();
+        frames[i] = mat3f(q);
+        if (i & 1) {
+            frames[i][1] = -frames[i][1];
+        }
+    }
+
+    pack_qtangents8(frames.data(), p8.data(), count);
+    pack_qtangents16(frames.data(), p16.data(), count);
+
+    double max8 = 0, max16 = 0;
+    for (size_t i = 0; i < count; i++) {
+        mat3f const& m = frames[i];
+        mat3f const d8 = unpack_qtangent8(p8[i]);
+        mat3f const d16 = unpack_qtangent16(p16[i]);
+        for (size_t c = 0; c < 3; c++) {
+            max8 = std::max(max8, angle(m[c], d8[c]));
+            max16 = std::max(max16, angle(m[c], d16[c]));
+        }
+    }
+    EXPECT_LT(max8, 1.1);
+    EXPECT_LT(max16, 0.005);
+
+    unpack_qtangents16(p16.data(), normals.data(), tangents.data(), count);
+    for (size_t i = 0; i < count; i++) {
+        mat3f const& m = frames[i];
+        EXPECT_LT(angle(m[2], normals[i]), 0.005);
+        EXPECT_LT(angle(m[0], tangents[i].xyz), 0.005);
+        EXPECT_EQ(tangents[i].w, (i & 1) ? -1.0f : 1.0f);
+        EXPECT_LT(angle(m[1], cross(normals[i], tangents[i].xyz) * tangents[i].w), 0.005);
+    }
+
+    unpack_qtangents8(p8.data(), normals.data(), tangents.data(), 37);
+    for (size_t i = 0; i < 37; i++) {
+        EXPECT_LT(angle(frames[i][2], normals[i]), 1.1);
+        EXPECT_EQ(tangents[i].w, (i & 1) ? -1.0f : 1.0f);
+    }
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <numeric/mat4.h>
+#include <numeric/quat.h>
+#include <numeric/rebase.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+namespace {
+
+// an object on the surface of the earth, rotated and scaled
+mat4 world_matrix(size_t i) {
+    double3 const position(6378137.0 + 0.25 * i, -1234567.125 + i, 4321.5 - 0.5 * i);
+    quat const rotation = quat::from_axis_angle(normalize(double3(1, 2, 3)), 0.1 * i);
+    return mat4::translate(position) * mat4(rotation) * mat4::scale(double3(1, 2, 0.5));
+}
+
+} // namespace
+
+TEST(RebaseTest, Matrices) {
+    double3 const eye(6378140.0, -1234560.0, 4320.0);
+    mat4 world[7];
+    for (size_t i = 0; i < 7; i++) {
+        world[i] = world_matrix(i);
+    }
+    mat4f out[7];
+    rebase(world, eye, out, 7);
+    for (size_t i = 0; i < 7; i++) {
+        mat4 const expected = mat4::translate(-eye) * world[i];
+        EXPECT_MAT4_NEAR(rebase(world[i], eye), mat4f(expected), 0.0f);
+        EXPECT_MAT4_NEAR(out[i], mat4f(expected), 0.0f);
+    }
+
+    // a point near the camera keeps its precision, unlike with a float world matrix
+    double3 const p(0.125, -0.5, 0.75);
+    double3 const expected = (mat4::translate(-eye) * world[3] * double4(p, 1)).xyz;
+    float3 const rebased = (out[3] * float4(float3(p), 1)).xyz;
+    float3 const naive = (mat4f(world[3]) * float4(float3(p), 1)).xyz - float3(eye);
+    EXPECT_LT(length(double3(rebased) - expected), 1e-5);
+    EXPECT_GT(length(double3(naive) - expected), 1e-3);
+}
+
+TEST(RebaseTest, Hierarchy) {
+    double3 const eye(6378140.0, -1234560.0, 4320.0);
+    mat4 const parent = world_matrix(5);
+    mat4f local[5];
+    for (size_t i = 0; i < 5; i++) {
+        local[i] = mat4f::translate(float3(i, -2.0f * i, 0.5f)) *
+                   mat4f(quatf::from_axis_angle(float3(0, 0, 1), 0.3f * i));
+    }
+    mat4f out[5];
+    rebase(parent, eye, local, out, 5);
+    for (size_t i = 0; i < 5; i++) {
+        EXPECT_MAT4_NEAR(out[i], rebase(parent * mat4(local[i]), eye), 1e-5f);
+    }
+}
+
+TEST(RebaseTest, View) {
+    double3 const eye(6378140.0, -1234560.0, 4320.0);
+    mat4 const view = inverse(mat4::translate(eye) *
+                              mat4(quat::from_axis_angle(double3(0, 1, 0), 0.5)));
+    mat4f const v = rebase_view(view, eye);
+    // the camera is at the origin of the rebased world
+    EXPECT_LT(length(v[3].xyz), 1e-9f);
+
+    mat4 const world = world_matrix(2);
+    double4 const p(0.5, 0.25, -1.0, 1.0);
+    double4 const expected = view * world * p;
+    float4 const actual = v * rebase(world, eye) * float4(p);
+    for (size_t c = 0; c < 3; c++) {
+        EXPECT_NEAR(actual[c], expected[c], 1e-5);
+    }
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <functional>
+#include <vector>
+#include <numeric/sh.h>
+
+using namespace numeric;
+
+class ShTest : public testing::Test {
+protected:
+    // a cubemap whose texels are f(direction)
+    struct TestCubemap {
+        std::vector<float3> texels[Cubemap::FACE_COUNT];
+        Cubemap cm;
+
+        TestCubemap(size_t size, const std::function<float3(const float3&)>& f) {
+            cm.size = size;
+            for (size_t face = 0; face < Cubemap::FACE_COUNT; face++) {
+                texels[face].resize(size * size);
+                cm.faces[face] = texels[face].data();
+                for (size_t y = 0; y < size; y++) {
+                    for (size_t x = 0; x < size; x++) {
+                        texels[face][y * size + x] = f(cm.direction(face, x, y));
+                    }
+                }
+            }
+        }
+    };
+
+    // straightforward projection in double precision
+    static std::vector<double3> reference(const Cubemap& cm) {
+        std::vector<double3> r(9, double3(0.0));
+        double weight = 0;
+        double const s = 2.0 / cm.size;
+        for (size_t face = 0; face < Cubemap::FACE_COUNT; face++) {
+            for (size_t y = 0; y < cm.size; y++) {
+                for (size_t x = 0; x < cm.size; x++) {
+                    double const u = (x + 0.5) * s - 1.0;
+                    double const v = (y + 0.5) * s - 1.0;
+                    double const w = s * s / std::pow(1.0 + u * u + v * v, 1.5);
+                    float basis[9];
+                    sh_basis<3>(cm.direction(face, x, y), basis);
+                    for (size_t i = 0; i < 9; i++) {
+                        r[i] += double3(cm.faces[face][y * cm.size + x]) * (basis[i] * w);
+                    }
+                    weight += w;
+                }
+            }
+        }
+        for (double3& c : r) {
+            c *= 4.0 * M_PI / weight;
+        }
+        return r;
+    }
+};
+
+TEST_F(ShTest, Directions) {
+    float const size = 4;
+    float3 const dirs[] = {
+            float3(1, 1, 1), float3(-1, 1, -1), float3(-1, 1, -1),
+            float3(-1, -1, 1), float3(-1, 1, 1), float3(1, 1, -1) };
+    Cubemap const cm{ {}, size_t(size) };
+    for (size_t face = 0; face < Cubemap::FACE_COUNT; face++) {
+        // texel (0, 0) is in the corner (-1, -1) of the face
+        float3 const d = cm.direction(face, 0, 0);
+        EXPECT_NEAR(length(d), 1.0f, 1e-6f);
+        for (size_t c = 0; c < 3; c++) {
+            EXPECT_EQ(d[c] < 0, dirs[face][c] < 0) << face;
+        }
+        float3 const center = (cm.direction(face, 1, 1) + cm.direction(face, 2, 2)) * 0.5f;
+        EXPECT_NEAR(std::abs(center[face / 2]), length(center), 1e-6f);
+    }
+}
+
+TEST_F(ShTest, Basis) {
+    // projecting the basis functions gives the identity
+    for (size_t k = 0; k < 9; k++) {
+        TestCubemap const t(32, [k](const float3& d) {
+            float b[9];
+            sh_basis<3>(d, b);
+            return float3(b[k]);
+        });
+        sh3 const sh = project_cubemap<3>(t.cm);
+        for (size_t i = 0; i < 9; i++) {
+            EXPECT_NEAR(sh[i].r, i == k ? 1.0f : 0.0f, 2e-3f) << k << " " << i;
+        }
+    }
+
+    // a constant only has a band 0
+    TestCubemap const t(16, [](const float3&) { return float3(1, 2, 3); });
+    sh2 const sh = project_cubemap<2>(t.cm);
+    EXPECT_NEAR(sh[0].g, 2.0f * std::sqrt(4.0f * float(M_PI)), 1e-4f);
+    for (size_t i = 1; i < 4; i++) {
+        EXPECT_NEAR(length(sh[i]), 0.0f, 1e-4f);
+    }
+    float3 const v = sh.evaluate(normalize(float3(1, -2, 3)));
+    EXPECT_NEAR(v.r, 1.0f, 1e-5f);
+    EXPECT_NEAR(v.b, 3.0f, 1e-5f);
+}
+
+TEST_F(ShTest, Projection) {
+    // odd sizes go through the tail of the rows
+    for (size_t size : { 1, 5, 16, 37 }) {
+        TestCubemap const t(size, [](const float3& d) {
+            return float3(std::exp(4.0f * d.x), std::max(d.y, 0.0f), d.z * d.z + 0.5f);
+        });
+        std::vector<double3> const ref = reference(t.cm);
+        for (size_t parts : { 0, 1, 3, 1000 }) {
+            // the parts may run in any order
+            sh3 const sh = parts ? project_cubemap<3>(t.cm, parts, [](size_t n, auto const& f) {
+                for (size_t i = n; i-- > 0;) {
+                    f(i);
+                }
+            }) : project_cubemap<3>(t.cm);
+            for (size_t i = 0; i < 9; i++) {
+                for (size_t c = 0; c < 3; c++) {
+                    EXPECT_NEAR(sh[i][c], ref[i][c], 1e-5 * (std::abs(ref[i][c]) + 1.0))
+                            << size << " " << parts << " " << i;
+                }
+            }
+        }
+    }
+
+    // a range of rows projected separately
+    TestCubemap const t(16, [](const float3& d) { return float3(d.x + 1.0f, d.y * d.z, 1); });
+    ShProjection<3> a, b;
+    project_cubemap_rows(t.cm, 0, 40, a);
+    project_cubemap_rows(t.cm, 40, 56, b);
+    a.add(b);
+    sh3 const whole = project_cubemap<3>(t.cm);
+    for (size_t i = 0; i < 9; i++) {
+        EXPECT_NEAR(length(a.result()[i] - whole[i]), 0.0f, 1e-5f);
+    }
+}
+
+TEST_F(ShTest, Irradiance) {
+    // constant radiance L gives an irradiance of pi L
+    TestCubemap const constant(8, [](const float3&) { return float3(1); });
+    sh3 const e = convolve_cosine(project_cubemap<3>(constant.cm));
+    EXPECT_NEAR(e.evaluate(float3(0, 0, 1)).r, float(M_PI), 1e-4f);
+    EXPECT_NEAR(e.evaluate(normalize(float3(1, 1, -1))).r, float(M_PI), 1e-4f);
+
+    // L = max(z, 0): E = 2pi/3 towards +z, 2/3 towards +x and 0 towards -z, within the error
+    // of 3 bands
+    TestCubemap const sky(32, [](const float3& d) { return float3(std::max(d.z, 0.0f)); });
+    sh3 const es = convolve_cosine(project_cubemap<3>(sky.cm));
+    EXPECT_NEAR(es.evaluate(float3(0, 0, 1)).r, 2.0f * float(M_PI) / 3.0f, 0.03f);
+    EXPECT_NEAR(es.evaluate(float3(0, 0, -1)).r, 0.0f, 0.05f);
+    EXPECT_NEAR(es.evaluate(float3(1, 0, 0)).r, 2.0f / 3.0f, 0.03f);
+}
+
+TEST_F(ShTest, Windowing) {
+    sh3 sh;
+    for (size_t i = 0; i < 9; i++) {
+        sh[i] = float3(1.0f);
+    }
+    sh3 const h = window_hanning(sh, 4.0f);
+    sh3 const l = window_lanczos(sh, 4.0f);
+    EXPECT_EQ(h[0].r, 1.0f);
+    EXPECT_EQ(l[0].r, 1.0f);
+    for (size_t i = 1; i < 4; i++) {
+        EXPECT_NEAR(h[i].r, 0.853553f, 1e-5f);
+        EXPECT_NEAR(l[i].r, 0.900316f, 1e-5f);
+    }
+    for (size_t i = 4; i < 9; i++) {
+        EXPECT_NEAR(h[i].g, 0.5f, 1e-5f);
+        EXPECT_NEAR(l[i].g, 0.636620f, 1e-5f);
+    }
+    // the bands past the window are removed
+    EXPECT_EQ(window_hanning(sh, 1.5f)[5], float3(0.0f));
+    EXPECT_EQ(window_lanczos(sh, 1.5f)[8], float3(0.0f));
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include <numeric/mat3.h>
+#include <numeric/mat4.h>
+#include <numeric/quat.h>
+#include <numeric/transform.h>
+
+#include "test_helpers.h"
+
+using namespace numeric;
+
+class TransformTest : public RandomTest {
+protected:
+    TransformTest() : RandomTest(-1.0f, 1.0f, 4242) {}
+
+    float3 rand_scale() { return abs(rand3()) * 2.0f + 0.25f; }
+
+    Transform rand_transform(bool uniform) {
+        float3 const s = uniform ? float3(rand_scale().x) : rand_scale();
+        return Transform(rand3() * 10.0f, rand_rotation(), s);
+    }
+};
+
+// same transform, q and -q being the same rotation
+#define EXPECT_TRANSFORM_NEAR(A, B, EPS)                                \
+do {                                                                    \
+    const Transform ta_ = A;                                            \
+    const Transform tb_ = B;                                            \
+    EXPECT_FLOAT3_NEAR(ta_.translation, tb_.translation, EPS);          \
+    EXPECT_NEAR(std::abs(dot(ta_.rotation, tb_.rotation)), 1.0f, EPS);  \
+    EXPECT_FLOAT3_NEAR(ta_.scale, tb_.scale, EPS);                      \
+} while(0)
+
+TEST_F(TransformTest, Basics) {
+    Transform const id;
+    EXPECT_EQ(id.to_mat4(), mat4f());
+
+    for (size_t i = 0; i < 100; i++) {
+        Transform const a = rand_transform(false);
+        mat4f const m = mat4f::translate(a.translation) * mat4f(a.rotation) *
+                        mat4f(mat3f(a.scale.x, 0, 0, 0, a.scale.y, 0, 0, 0, a.scale.z));
+        EXPECT_MAT4_NEAR(a.to_mat4(), m, 1e-5f);
+
+        float3 const p = rand3();
+        EXPECT_FLOAT3_NEAR(transform_point(a, p), (m * float4(p, 1)).xyz, 1e-5f);
+        EXPECT_FLOAT3_NEAR(transform_vector(a, p), m.upper_left() * p, 1e-5f);
+        EXPECT_FLOAT3_NEAR(transform_normal(a, p),
+                normalize(transpose(inverse(m.upper_left())) * p), 1e-5f);
+    }
+}
+
+TEST_F(TransformTest, Compose) {
+    for (size_t i = 0; i < 100; i++) {
+        // exact when a has a uniform scale
+        Transform const a = rand_transform(true);
+        Transform const b = rand_transform(false);
+        EXPECT_MAT4_NEAR((a * b).to_mat4(), a.to_mat4() * b.to_mat4(), 1e-4f);
+        float3 const p = rand3();
+        EXPECT_FLOAT3_NEAR(transform_point(a * b, p), transform_point(a, transform_point(b, p)),
+                1e-4f);
+
+        EXPECT_TRANSFORM_NEAR(inverse(a) * a, Transform(), 1e-5f);
+        EXPECT_TRANSFORM_NEAR(a * inverse(a), Transform(), 1e-5f);
+        EXPECT_MAT4_NEAR(inverse(a).to_mat4(), inverse(a.to_mat4()), 1e-4f);
+    }
+}
+
+TEST_F(TransformTest, Lerp) {
+    for (size_t i = 0; i < 100; i++) {
+        Transform const a = rand_transform(false);
+        Transform b = rand_transform(false);
+        EXPECT_TRANSFORM_NEAR(lerp(a, b, 0.0f), a, 1e-5f);
+        EXPECT_TRANSFORM_NEAR(lerp(a, b, 1.0f), b, 1e-5f);
+        // -q is the same rotation
+        Transform const c = lerp(a, b, 0.3f);
+        b.rotation = -b.rotation;
+        EXPECT_TRANSFORM_NEAR(lerp(a, b, 0.3f), c, 1e-5f);
+    }
+    Transform const a(float3(0), quatf::from_axis_angle(float3(0, 0, 1), 0.0f), float3(1));
+    Transform const b(float3(2, 4, 6), quatf::from_axis_angle(float3(0, 0, 1), float(M_PI_2)),
+            float3(3));
+    Transform const c = lerp(a, b, 0.5f);
+    EXPECT_FLOAT3_NEAR(c.translation, float3(1, 2, 3), 1e-6f);
+    EXPECT_FLOAT3_NEAR(c.scale, float3(2), 1e-6f);
+    EXPECT_FLOAT3_NEAR(c.rotation * float3(1, 0, 0),
+            float3(std::sqrt(0.5f), std::sqrt(0.5f), 0), 1e-6f);
+}
+
+TEST_F(TransformTest, Decompose) {
+    for (size_t i = 0; i < 100; i++) {
+        Transform const a = rand_transform(false);
+        Transform const b(a.to_mat4());
+        EXPECT_TRANSFORM_NEAR(b, a, 1e-5f);
+
+        // in double, close to the precision
+        quat const q = normalize(quat(a.rotation));
+        mat4 const m = mat4::translate(double3(a.translation)) * mat4(q) *
+                       mat4(mat3(a.scale.x, 0, 0, 0, a.scale.y, 0, 0, 0, a.scale.z));
+        double3 t, s;
+        quat r;
+        EXPECT_TRUE(decompose(m, t, r, s));
+        EXPECT_NEAR(length(s - double3(a.scale)), 0.0, 1e-12);
+        EXPECT_NEAR(std::abs(dot(r, q)), 1.0, 1e-12);
+        for (size_t c = 0; c < 3; c++) {
+            double3 axis(0);
+            axis[c] = s[c];
+            EXPECT_NEAR(length(m[c].xyz - r * axis), 0.0, 1e-12);
+        }
+
+        // a mirroring is a negative scale
+        mat4f const mirror = a.to_mat4() * mat4f(mat3f(-1, 0, 0, 0, 1, 0, 0, 0, 1));
+        Transform const c(mirror);
+        EXPECT_LT(c.scale.x * c.scale.y * c.scale.z, 0.0f);
+        EXPECT_MAT4_NEAR(c.to_mat4(), mirror, 1e-4f);
+    }
+
+    // the rotation of a matrix with a shear is the closest one
+    mat3f shear(1, 0, 0, 0.2f, 1, 0, 0, 0, 1);
+    mat3f const rot(quatf::from_axis_angle(normalize(float3(1, 2, 3)), 0.7f));
+    mat3f q, s;
+    EXPECT_TRUE(details::matrix::polar_decompose(rot * shear, q, s));
+    EXPECT_TRUE(details::matrix::is_orthonormal(q, 1e-6f));
+    EXPECT_MAT4_NEAR(mat4f(q * s), mat4f(rot * shear), 1e-5f);
+    EXPECT_MAT4_NEAR(mat4f(s), mat4f(transpose(s)), 0.0f);
+
+    // singular
+    float3 t, sc;
+    quatf r;
+    mat4f const flat = mat4f::translate(float3(1, 2, 3)) *
+                       mat4f(mat3f(2, 0, 0, 0, 3, 0, 0, 0, 0));
+    EXPECT_FALSE(decompose(flat, t, r, sc));
+    EXPECT_EQ(t, float3(1, 2, 3));
+    EXPECT_EQ(r, quatf(1, 0, 0, 0));
+    EXPECT_EQ(sc, float3(2, 3, 0));
+}
+
+TEST_F(TransformTest, Streams) {
+    for (size_t count : { 0, 1, 7, 13, 37 }) {
+        std::vector<Transform> a(count), b(count), ab(count);
+        std::vector<float> data[3][10];
+        TransformStreams streams[3];
+        for (size_t k = 0; k < 3; k++) {
+            for (size_t c = 0; c < 10; c++) {
+                data[k][c].resize(count);
+            }
+            for (size_t c = 0; c < 3; c++) {
+                streams[k].translation[c] = data[k][c].data();
+                streams[k].scale[c] = data[k][c + 7].data();
+            }
+            for (size_t c = 0; c < 4; c++) {
+                streams[k].rotation[c] = data[k][c + 3].data();
+            }
+        }
+        auto const set = [&](size_t k, size_t i, Transform const& t) {
+            for (size_t c = 0; c < 3; c++) {
+                streams[k].translation[c][i] = t.translation[c];
+                streams[k].scale[c][i] = t.scale[c];
+            }
+            for (size_t c = 0; c < 4; c++) {
+                streams[k].rotation[c][i] = t.rotation[c];
+            }
+        };
+        auto const get = [&](size_t k, size_t i) {
+            Transform t;
+            for (size_t c = 0; c < 3; c++) {
+                t.translation[c] = streams[k].translation[c][i];
+                t.scale[c] = streams[k].scale[c][i];
+            }
+            for (size_t c = 0; c < 4; c++) {
+                t.rotation[c] = streams[k].rotation[c][i];
+            }
+            return t;
+        };
+
+        for (size_t i = 0; i < count; i++) {
+            a[i] = rand_transform(i % 2 == 0);
+            b[i] = rand_transform(false);
+            ab[i] = a[i] * b[i];
+            set(0, i, a[i]);
+            set(1, i, b[i]);
+        }
+        compose(streams[0], streams[1], streams[2], count);
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_TRANSFORM_NEAR(get(2, i), ab[i], 1e-5f);
+        }
+
+        // hierarchies: a chain, a few roots and mostly parents in the previous packets
+        std::vector<int32_t> parents(count);
+        std::default_random_engine engine(count);
+        for (size_t i = 0; i < count; i++) {
+            parents[i] = i % 11 == 0 ? -1 :
+                         i < 5 ? int32_t(i) - 1 : int32_t(engine() % std::max(i - 4, size_t(1)));
+        }
+        std::vector<Transform> world(count);
+        local_to_world(parents.data(), a.data(), world.data(), count);
+        local_to_world(parents.data(), streams[0], streams[2], count);
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_TRANSFORM_NEAR(get(2, i), world[i], 1e-4f);
+        }
+        // in place
+        local_to_world(parents.data(), streams[0], streams[0], count);
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_TRANSFORM_NEAR(get(0, i), world[i], 1e-4f);
+        }
+    }
+}
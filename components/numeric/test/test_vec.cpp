@@ -253,6 +253,54 @@ TEST_F(VecTest, MiscFunc) {
     EXPECT_TRUE(all(map(float3(1, 2, 3), p)));
 }
 
+TEST_F(VecTest, Vector4Kernels) {
+    // float4 and int4 may use the SIMD kernels, they must match the other types
+#if NUM_SIMD
+    static_assert(alignof(float4) == 16, "float4 should be register aligned");
+    static_assert(alignof(int4) == 16, "int4 should be register aligned");
+#endif
+    static_assert(sizeof(float4) == 16 && sizeof(int4) == 16, "no padding");
+
+    float4 const a(1.5f, -2, 3, -0.25f);
+    float4 const b(-4, 0.5f, 3, 8);
+    EXPECT_EQ(a + b, float4(-2.5f, -1.5f, 6, 7.75f));
+    EXPECT_EQ(a - b, float4(5.5f, -2.5f, 0, -8.25f));
+    EXPECT_EQ(a * b, float4(-6, -1, 9, -2));
+    EXPECT_EQ(a / b, float4(-0.375f, -4, 1, -0.03125f));
+    EXPECT_EQ(-a, float4(-1.5f, 2, -3, 0.25f));
+    EXPECT_EQ(min(a, b), float4(-4, -2, 3, -0.25f));
+    EXPECT_EQ(max(a, b), float4(1.5f, 0.5f, 3, 8));
+    EXPECT_EQ(a * 2.0f, float4(3, -4, 6, -0.5f));
+
+    float4 c(a);
+    c += b;
+    c -= a;
+    c *= b;
+    c /= b;
+    EXPECT_EQ(c, b);
+
+    int4 const i(7, -3, 100, 0);
+    int4 const j(-2, -3, 5, 9);
+    EXPECT_EQ(i + j, int4(5, -6, 105, 9));
+    EXPECT_EQ(i - j, int4(9, 0, 95, -9));
+    EXPECT_EQ(i * j, int4(-14, 9, 500, 0));
+    EXPECT_EQ(i / j, int4(-3, 1, 20, 0));
+    EXPECT_EQ(-i, int4(-7, 3, -100, 0));
+    EXPECT_EQ(min(i, j), int4(-2, -3, 5, 0));
+    EXPECT_EQ(max(i, j), int4(7, -3, 100, 9));
+
+    // mixed types still go through the loops
+    float4 f(a);
+    f += double4(1, 1, 1, 1);
+    f *= int4(2);
+    EXPECT_EQ(f, float4(5, -2, 8, 1.5f));
+    EXPECT_EQ(int4(1, 2, 3, 4) + float4(0.5f), int4(1, 2, 3, 4));
+
+    // float4 inside other types keeps its alignment
+    struct { float s; float4 v; } packed{};
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(&packed.v) % alignof(float4), 0u);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <json/json.h>
+
+#include <system/mpmc_queue.h>
+#include <system/spsc_queue.h>
+#include <system/thread_storage.h>
+
+/*
+ * Contention benchmarks of the system primitives.
+ *
+ *  bench_system [--filter <substring>] [--out <file.json>]
+ *
+ * Each benchmark runs the same loop on each of THREAD_COUNTS threads started together and
+ * reports the time per operation and per thread: flat means the threads don't slow each other
+ * down, as long as there are enough cores.
+ * The queue benchmarks split the threads in producers and consumers (one thread does both) and
+ * report the time per item and per thread.
+ * The results are printed as JSON (to stdout or to the given file). Build in release mode.
+ */
+
+namespace {
+
+constexpr size_t THREAD_COUNTS[] = { 1, 2, 4, 8, 16 };
+constexpr size_t OPERATION_COUNT = 1 << 20;
+constexpr unsigned int ID_COUNT = 16;
+constexpr size_t QUEUE_THREAD_COUNTS[] = { 1, 2, 4, 8, 16, 32 };
+constexpr size_t QUEUE_CAPACITY = 1024;
+constexpr size_t QUEUE_BATCH = 16;
+
+// the ThreadStorage before it went lock-free: a shared lock, a search of the ids and two
+// hash map lookups per get()
+template<typename T>
+class LockedThreadStorage {
+public:
+    unsigned int add() {
+        std::lock_guard<std::shared_timed_mutex> lock(m_mutex);
+        m_ids.push_back(++m_highest_id);
+        return m_highest_id;
+    }
+
+    T* get(unsigned int id) {
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(m_mutex);
+            if (std::find(m_ids.begin(), m_ids.end(), id) == m_ids.end()) {
+                return nullptr;
+            }
+            auto const objects = m_objects.find(std::this_thread::get_id());
+            if (objects != m_objects.end()) {
+                auto const it = objects->second.find(id);
+                if (it != objects->second.end()) {
+                    return &it->second;
+                }
+            }
+        }
+        // the original inserted under the shared lock, which is a race
+        std::lock_guard<std::shared_timed_mutex> lock(m_mutex);
+        return &m_objects[std::this_thread::get_id()][id];
+    }
+
+private:
+    unsigned int m_highest_id = 0;
+    std::vector<unsigned int> m_ids;
+    std::unordered_map<std::thread::id, std::unordered_map<unsigned int, T>> m_objects;
+    std::shared_timed_mutex m_mutex;
+};
+
+// the queues the render and loader threads used before: a std::deque under a mutex
+template<typename T, size_t CAPACITY>
+class LockedQueue {
+public:
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this]() { return m_items.size() < CAPACITY; });
+        m_items.push_back(item);
+        m_not_empty.notify_one();
+    }
+
+    void push(T const* items, size_t count) {
+        while (count) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_full.wait(lock, [this]() { return m_items.size() < CAPACITY; });
+            size_t const n = std::min(count, CAPACITY - m_items.size());
+            m_items.insert(m_items.end(), items, items + n);
+            items += n;
+            count -= n;
+            m_not_empty.notify_all();
+        }
+    }
+
+    T pop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]() { return !m_items.empty(); });
+        T const item = m_items.front();
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return item;
+    }
+
+    size_t pop(T* items, size_t count) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]() { return !m_items.empty(); });
+        size_t const n = std::min(count, m_items.size());
+        std::copy(m_items.begin(), m_items.begin() + n, items);
+        m_items.erase(m_items.begin(), m_items.begin() + n);
+        m_not_full.notify_all();
+        return n;
+    }
+
+private:
+    std::deque<T> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+};
+
+class Bench {
+public:
+    explicit Bench(const char* filter) : m_filter(filter ? filter : "") {
+        m_results = Json::Value(Json::arrayValue);
+    }
+
+    // runs kernel(thread_index, count) on thread_count threads, each doing count operations
+    template<typename KERNEL>
+    void run(const char* name, size_t thread_count, KERNEL kernel) {
+        if (!m_filter.empty() && !strstr(name, m_filter.c_str())) {
+            return;
+        }
+        typedef std::chrono::steady_clock clock;
+
+        std::atomic<size_t> ready{ 0 };
+        std::atomic<bool> go{ false };
+        std::vector<double> ns(thread_count);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < thread_count; t++) {
+            threads.emplace_back([&, t]() {
+                kernel(t, OPERATION_COUNT / 16); // warm-up, creates the per-thread objects
+                ready++;
+                while (!go.load()) {
+                    std::this_thread::yield();
+                }
+                clock::time_point const t0 = clock::now();
+                kernel(t, OPERATION_COUNT);
+                ns[t] = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+            });
+        }
+        while (ready.load() < thread_count) {
+            std::this_thread::yield();
+        }
+        go = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        double const mean = std::accumulate(ns.begin(), ns.end(), 0.0) / double(thread_count);
+        Json::Value r;
+        r["name"] = name;
+        r["threads"] = Json::UInt64(thread_count);
+        r["operations"] = Json::UInt64(OPERATION_COUNT);
+        r["ns_per_operation"] = mean / double(OPERATION_COUNT);
+        m_results.append(r);
+
+        fprintf(stderr, "%-28s %3zu threads %10.3f ns/operation\n", name, thread_count,
+                r["ns_per_operation"].asDouble());
+    }
+
+    Json::Value report() const {
+        Json::Value root;
+        root["hardware_concurrency"] = std::thread::hardware_concurrency();
+        root["benchmarks"] = m_results;
+        return root;
+    }
+
+private:
+    std::string m_filter;
+    Json::Value m_results;
+};
+
+void run_all(Bench& bench) {
+    for (size_t thread_count : THREAD_COUNTS) {
+        sys::ThreadStorage<uint64_t> storage;
+        unsigned int ids[ID_COUNT];
+        for (unsigned int& id : ids) {
+            id = storage.add();
+        }
+        bench.run("thread_storage/get", thread_count, [&storage, &ids](size_t, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                ++*storage.get(ids[i % ID_COUNT]);
+            }
+        });
+    }
+    for (size_t thread_count : THREAD_COUNTS) {
+        LockedThreadStorage<uint64_t> storage;
+        unsigned int ids[ID_COUNT];
+        for (unsigned int& id : ids) {
+            id = storage.add();
+        }
+        bench.run("thread_storage/get_locked", thread_count, [&storage, &ids](size_t,
+                size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                ++*storage.get(ids[i % ID_COUNT]);
+            }
+        });
+    }
+}
+
+// the even threads push count items, the odd ones pop as many, batch at a time
+template<typename QUEUE>
+void run_queue(Bench& bench, const char* name, QUEUE& queue, size_t thread_count,
+        size_t batch) {
+    bench.run(name, thread_count, [&queue, thread_count, batch](size_t t, size_t count) {
+        bool const producer = thread_count == 1 || t % 2 == 0;
+        bool const consumer = thread_count == 1 || t % 2 == 1;
+        uint64_t items[QUEUE_BATCH] = {};
+        for (size_t i = 0; i < count; i += batch) {
+            size_t const n = std::min(batch, count - i);
+            if (producer) {
+                if (n == 1) {
+                    queue.push(uint64_t(i));
+                } else {
+                    queue.push(items, n);
+                }
+            }
+            if (consumer) {
+                if (n == 1) {
+                    items[0] += queue.pop();
+                } else {
+                    for (size_t popped = 0; popped < n;) {
+                        popped += queue.pop(items, n - popped);
+                    }
+                }
+            }
+        }
+    });
+}
+
+void run_queues(Bench& bench) {
+    // over-aligned, and empty again after each run
+    static sys::SpscQueue<uint64_t, QUEUE_CAPACITY> spsc;
+    static sys::MpmcQueue<uint64_t, QUEUE_CAPACITY> mpmc;
+    static LockedQueue<uint64_t, QUEUE_CAPACITY> locked;
+    for (size_t thread_count : { 1, 2 }) {
+        run_queue(bench, "queue/spsc", spsc, thread_count, 1);
+        run_queue(bench, "queue/spsc_batch", spsc, thread_count, QUEUE_BATCH);
+    }
+    for (size_t thread_count : QUEUE_THREAD_COUNTS) {
+        run_queue(bench, "queue/mpmc", mpmc, thread_count, 1);
+        run_queue(bench, "queue/mpmc_batch", mpmc, thread_count, QUEUE_BATCH);
+        run_queue(bench, "queue/locked", locked, thread_count, 1);
+        run_queue(bench, "queue/locked_batch", locked, thread_count, QUEUE_BATCH);
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    const char* filter = nullptr;
+    const char* out = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            out = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--filter <substring>] [--out <file.json>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Bench bench(filter);
+    run_all(bench);
+    run_queues(bench);
+
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "    ";
+    std::unique_ptr<Json::StreamWriter> const writer(builder.newStreamWriter());
+    if (out) {
+        std::ofstream file(out);
+        if (!file) {
+            fprintf(stderr, "cannot write %s\n", out);
+            return 1;
+        }
+        writer->write(bench.report(), &file);
+        file << std::endl;
+    } else {
+        writer->write(bench.report(), &std::cout);
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef CHROMA_SYS_ALLOCATE_ALIGNED_H
+#define CHROMA_SYS_ALLOCATE_ALIGNED_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#if defined(WIN32)
+#   include <malloc.h>
+#endif
+
+namespace sys {
+
+// new doesn't honor alignas before C++17. alignment is a power of two, nullptr on failure.
+// Not named aligned_alloc: ::aligned_alloc and std::aligned_alloc take (alignment, size).
+inline void* allocate_aligned(size_t size, size_t alignment) noexcept {
+    size = size ? size : 1;
+#if defined(WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    void* p = nullptr;
+    alignment = alignment < sizeof(void*) ? sizeof(void*) : alignment;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+#endif
+}
+
+inline void free_aligned(void* p) noexcept {
+#if defined(WIN32)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+} // namespace sys
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef CHROMA_SYS_ARENA_H
+#define CHROMA_SYS_ARENA_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include <system/compiler.h>
+#include <system/noncopyable.h>
+
+// fills the memory given out by the arenas with 0xCD and the memory they take back with 0xDD
+#ifndef SYS_ARENA_POISON
+#   ifdef NDEBUG
+#       define SYS_ARENA_POISON 0
+#   else
+#       define SYS_ARENA_POISON 1
+#   endif
+#endif
+
+namespace sys {
+
+/*
+ * A bump allocator over a buffer allocated once: allocate() moves a pointer forward and
+ * nothing is freed individually, the arena is rewound to a marker or reset as a whole. Meant
+ * for scratch data with a known lifetime, e.g. a frame or a pass, which then costs no malloc.
+ *
+ * Destructors are not called: make<T>() is for trivially destructible types or the caller
+ * destroys the objects itself. allocate() returns nullptr when the arena is full, peak() is
+ * the most it ever held and helps choosing its capacity. Not thread-safe.
+ */
+class LinearArena : NonCopyable {
+public:
+    struct Marker {
+        char* top;
+    };
+
+    LinearArena() noexcept = default;
+
+    // a buffer of capacity bytes, aligned to a cache line
+    explicit LinearArena(size_t capacity);
+
+    // uses [begin, begin + capacity) which must outlive the arena
+    LinearArena(void* begin, size_t capacity) noexcept;
+
+    LinearArena(LinearArena&& rhs) noexcept { swap(rhs); }
+    LinearArena& operator=(LinearArena&& rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    ~LinearArena() noexcept;
+
+    void swap(LinearArena& rhs) noexcept {
+        std::swap(m_begin, rhs.m_begin);
+        std::swap(m_end, rhs.m_end);
+        std::swap(m_top, rhs.m_top);
+        std::swap(m_peak, rhs.m_peak);
+        std::swap(m_owned, rhs.m_owned);
+    }
+
+    // alignment must be a power of two
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) noexcept {
+        assert(alignment && !(alignment & (alignment - 1)));
+        uintptr_t const top = reinterpret_cast<uintptr_t>(m_top);
+        uintptr_t const end = reinterpret_cast<uintptr_t>(m_end);
+        uintptr_t const p = (top + alignment - 1) & ~uintptr_t(alignment - 1);
+        // compared to the room left rather than p + size, which can wrap around
+        if (SYS_UNLIKELY(p < top || p > end || size > end - p)) {
+            return nullptr;
+        }
+        m_top = reinterpret_cast<char*>(p + size);
+        m_peak = used() > m_peak ? used() : m_peak;
+#if SYS_ARENA_POISON
+        // always true past the check above, but GCC only sees a constant size and warns about
+        // a memset beyond the largest object
+        if (size <= size_t(PTRDIFF_MAX)) {
+            memset(reinterpret_cast<void*>(p), 0xCD, size);
+        }
+#endif
+        return reinterpret_cast<void*>(p);
+    }
+
+    // gives back p if it's the last allocation, e.g. a vector that grows
+    void deallocate(void* p, size_t size) noexcept {
+        if (static_cast<char*>(p) + size == m_top) {
+            rewind(Marker{ static_cast<char*>(p) });
+        }
+    }
+
+    template<typename T, typename... ARGS>
+    T* make(ARGS&&... args) {
+        void* const p = allocate(sizeof(T), alignof(T));
+        return p ? new(p) T(std::forward<ARGS>(args)...) : nullptr;
+    }
+
+    // count default-initialized T
+    template<typename T>
+    T* make_array(size_t count) {
+        if (count > available() / sizeof(T)) {
+            return nullptr;
+        }
+        T* const p = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; p && i < count; i++) {
+            new(p + i) T;
+        }
+        return p;
+    }
+
+    Marker mark() const noexcept { return Marker{ m_top }; }
+
+    // frees everything allocated since the marker was taken
+    void rewind(Marker marker) noexcept {
+        assert(marker.top >= m_begin && marker.top <= m_top);
+#if SYS_ARENA_POISON
+        memset(marker.top, 0xDD, size_t(m_top - marker.top));
+#endif
+        m_top = marker.top;
+    }
+
+    void reset() noexcept { rewind(Marker{ m_begin }); }
+
+    size_t capacity() const noexcept { return size_t(m_end - m_begin); }
+    size_t used() const noexcept { return size_t(m_top - m_begin); }
+    size_t available() const noexcept { return size_t(m_end - m_top); }
+    size_t peak() const noexcept { return m_peak; }
+
+    bool owns(void const* p) const noexcept {
+        return static_cast<char const*>(p) >= m_begin && static_cast<char const*>(p) < m_end;
+    }
+
+private:
+    char* m_begin = nullptr;
+    char* m_end = nullptr;
+    char* m_top = nullptr;
+    size_t m_peak = 0;
+    bool m_owned = false;
+};
+
+// rewinds the arena to where it was when the scope was created
+class ArenaScope : NonMovable {
+public:
+    explicit ArenaScope(LinearArena& arena) noexcept : m_arena(arena), m_marker(arena.mark()) {}
+    ~ArenaScope() noexcept { m_arena.rewind(m_marker); }
+
+    LinearArena& arena() const noexcept { return m_arena; }
+
+private:
+    LinearArena& m_arena;
+    LinearArena::Marker m_marker;
+};
+
+/*
+ * N arenas used in turn, one per frame: the memory of a frame stays valid while the next
+ * N - 1 frames are recorded, for the GPU or the jobs still reading it, and is reused by
+ * begin_frame() after that. All the arenas come from a single allocation.
+ */
+class FrameAllocator : NonCopyable {
+public:
+    static constexpr size_t MAX_FRAME_COUNT = 4;
+
+    // throws std::invalid_argument unless 1 <= frame_count <= MAX_FRAME_COUNT
+    FrameAllocator(size_t frame_capacity, size_t frame_count = 2);
+    ~FrameAllocator() noexcept;
+
+    // switches to the arena of the oldest frame and resets it
+    LinearArena& begin_frame() noexcept {
+        m_frame++;
+        LinearArena& arena = m_arenas[m_frame % m_frame_count];
+        arena.reset();
+        return arena;
+    }
+
+    LinearArena& current() noexcept { return m_arenas[m_frame % m_frame_count]; }
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) noexcept {
+        return current().allocate(size, alignment);
+    }
+
+    // the number of begin_frame() calls
+    uint64_t frame() const noexcept { return m_frame; }
+    size_t frame_count() const noexcept { return m_frame_count; }
+
+    // the largest peak of the arenas
+    size_t peak() const noexcept;
+
+private:
+    LinearArena m_memory; // the block the arenas are carved from
+    LinearArena m_arenas[MAX_FRAME_COUNT];
+    size_t m_frame_count;
+    uint64_t m_frame = 0;
+};
+
+/*
+ * An STL allocator allocating from a LinearArena, for containers of scratch data:
+ *
+ *     std::vector<uint32_t, ArenaAllocator<uint32_t>> visible{ ArenaAllocator<uint32_t>(arena) };
+ *
+ * Throws std::bad_alloc when the arena is full. The memory is only given back when it's the
+ * last allocation of the arena (and when the arena is rewound), reserve() avoids leaving the
+ * smaller buffers of a growing vector behind.
+ */
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(LinearArena& arena) noexcept : m_arena(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& rhs) noexcept : m_arena(&rhs.arena()) {}
+
+    T* allocate(size_t count) {
+        if (count > size_t(-1) / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        void* const p = m_arena->allocate(sizeof(T) * count, alignof(T));
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_t count) noexcept {
+        m_arena->deallocate(p, sizeof(T) * count);
+    }
+
+    LinearArena& arena() const noexcept { return *m_arena; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& rhs) const noexcept {
+        return m_arena == &rhs.arena();
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& rhs) const noexcept {
+        return m_arena != &rhs.arena();
+    }
+
+private:
+    LinearArena* m_arena;
+};
+
+} // namespace sys
+
+#endif
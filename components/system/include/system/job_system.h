@@ -0,0 +1,225 @@
+#ifndef CHROMA_SYS_JOB_SYSTEM_H
+#define CHROMA_SYS_JOB_SYSTEM_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <system/compiler.h>
+#include <system/noncopyable.h>
+#include <system/wait_sequence.h>
+
+namespace sys {
+
+/*
+ * A pool of worker threads running small jobs, each with its own work-stealing dequeue.
+ *
+ * A job is a function with 48 bytes of storage for its arguments. It can have a parent, and a
+ * parent only completes once all its children have completed, which is how dependencies are
+ * expressed: create a root job, create the work as its children, run them and wait on the
+ * root. Jobs are pushed on the dequeue of the thread that runs them and idle threads steal
+ * from the others, so run() and the waits must be called from a worker or from a thread that
+ * adopt()ed the job system, usually the main thread. A thread that waits runs jobs meanwhile.
+ *
+ *     JobSystem js;
+ *     js.adopt();
+ *     JobSystem::Job* root = js.create();
+ *     for (auto& object : objects) {
+ *         JobSystem::Job* job = js.create(root, [&object](JobSystem&, JobSystem::Job*) {
+ *             object.update();
+ *         });
+ *         js.run(job);
+ *     }
+ *     js.run_and_wait(root);
+ *
+ * Idle workers, and threads waiting on jobs running elsewhere, sleep on a WaitSequence until
+ * more jobs are run or complete.
+ */
+class JobSystem : NonMovable {
+    struct ThreadState;
+
+public:
+    class Job;
+
+    // called with the storage of the job
+    using JobFunc = void(*)(void*, JobSystem&, Job*);
+
+    static constexpr size_t MAX_JOB_COUNT = 4096;
+    static constexpr size_t MAX_JOB_SYSTEMS_PER_THREAD = 4;
+
+    class alignas(64) Job {
+    public:
+        Job() noexcept = default;
+        Job(const Job&) = delete;
+        Job(Job&&) = delete;
+
+        void* storage() noexcept { return m_storage; }
+
+    private:
+        friend class JobSystem;
+
+        static constexpr size_t STORAGE_SIZE = 48;
+        static constexpr uint16_t NONE = 0x7FFF;
+        // in m_parent with the index, the storage holds a functor to destroy if the job is
+        // released without having run
+        static constexpr uint16_t OWNS_FUNCTOR = 0x8000;
+
+        // the arguments, first so that they are 16-byte aligned
+        alignas(16) char m_storage[STORAGE_SIZE];
+        JobFunc m_function = nullptr;
+        uint16_t m_parent = NONE;
+        // 1 for the job itself plus its running children
+        std::atomic<uint16_t> m_running_job_count{ 0 };
+        std::atomic<uint16_t> m_ref_count{ 0 };
+        std::atomic<uint16_t> m_next_free{ NONE };
+    };
+
+    static_assert(sizeof(Job) == 64, "a job is a cache line");
+    static_assert(MAX_JOB_COUNT <= Job::NONE, "a job index must leave room for OWNS_FUNCTOR");
+
+    /*
+     * thread_count workers, hardware_concurrency() - 1 when 0 so that the thread waiting on
+     * the jobs makes up the last core. Up to adoptable_count threads at a time can adopt() the
+     * job system.
+     * pin_threads locks each worker to a core (Linux only).
+     */
+    explicit JobSystem(size_t thread_count = 0, size_t adoptable_count = 1,
+            bool pin_threads = false);
+    ~JobSystem() noexcept;
+
+    /*
+     * The calling thread can run and wait on jobs, it must emancipate() before it exits, which
+     * gives its slot back to the next thread that adopts. Returns false when adoptable_count
+     * threads already did, or when the thread is already a worker of or adopted
+     * MAX_JOB_SYSTEMS_PER_THREAD other job systems.
+     */
+    bool adopt();
+    void emancipate() noexcept;
+
+    size_t thread_count() const noexcept { return m_thread_count; }
+
+    /*
+     * A new job that will call func with its storage, nullptr to only group children. The job
+     * is owned by the caller until it's given to run(). Runs pending jobs while the pool is
+     * exhausted.
+     */
+    Job* create(Job* parent = nullptr, JobFunc func = nullptr);
+
+    /*
+     * A job calling functor(JobSystem&, Job*), which is destroyed right after the call, or by
+     * the last release() when the job never runs.
+     */
+    template<typename T>
+    Job* create(Job* parent, T&& functor) {
+        using Functor = typename std::decay<T>::type;
+        static_assert(sizeof(Functor) <= Job::STORAGE_SIZE, "the functor doesn't fit in a job");
+        static_assert(alignof(Functor) <= 16, "the functor is over-aligned");
+        Job* job = create(parent, &invoke<Functor>);
+        new(job->storage()) Functor(std::forward<T>(functor));
+        job->m_parent |= Job::OWNS_FUNCTOR;
+        return job;
+    }
+
+    // schedules the job and gives it up, job is set to nullptr
+    void run(Job*& job);
+
+    // schedules the job and keeps a reference on it to wait on it
+    Job* run_and_retain(Job* job);
+
+    // runs jobs until job and all its children have completed, then releases it
+    void wait_and_release(Job*& job);
+
+    void run_and_wait(Job*& job) {
+        Job* retained = run_and_retain(job);
+        job = nullptr;
+        wait_and_release(retained);
+    }
+
+    Job* retain(Job* job) noexcept;
+    void release(Job*& job) noexcept;
+
+    /*
+     * A job calling functor(start, count) on [start, start + count) by ranges of at least grain
+     * indices. The range is split lazily: a half of what's left goes to a new child job only
+     * when the dequeue of the thread running it is empty, i.e. when the other threads are
+     * idle, so the number of jobs adapts to the load instead of being count / grain. The job
+     * is not run.
+     */
+    template<typename F>
+    Job* parallel_for(Job* parent, uint32_t start, uint32_t count, F functor,
+            uint32_t grain = 1) {
+        return create(parent, ParallelFor<F>{ start, count, grain > 0 ? grain : 1, functor });
+    }
+
+private:
+    template<typename F>
+    struct ParallelFor {
+        uint32_t start;
+        uint32_t count;
+        uint32_t grain;
+        F functor;
+
+        void operator()(JobSystem& js, Job* job) {
+            while (count > 0) {
+                if (count > grain && js.is_local_queue_empty()) {
+                    uint32_t const half = count / 2;
+                    count -= half;
+                    Job* child = js.create(job, ParallelFor{ start + count, half, grain, functor });
+                    js.run(child);
+                    continue;
+                }
+                uint32_t const n = count < grain ? count : grain;
+                functor(start, n);
+                start += n;
+                count -= n;
+            }
+        }
+    };
+
+    // calls the functor and destroys it, only destroys it when job is nullptr
+    template<typename Functor>
+    static void invoke(void* storage, JobSystem& js, Job* job) {
+        Functor& functor = *static_cast<Functor*>(storage);
+        if (job) {
+            functor(js, job);
+        }
+        functor.~Functor();
+    }
+
+    Job* allocate() noexcept;
+    void free(Job* job) noexcept;
+    uint16_t index_of(Job const* job) const noexcept { return uint16_t(job - m_jobs); }
+
+    struct ThreadLink;
+    static ThreadLink* thread_links() noexcept;
+    ThreadState* get_state() const noexcept;
+    bool link_state(ThreadState* state) noexcept;
+    void unlink_state() noexcept;
+    bool is_local_queue_empty() const noexcept;
+    bool has_completed(Job const* job) const noexcept;
+
+    void loop(ThreadState& state);
+    bool execute(ThreadState& state);
+    Job* steal(ThreadState& state) noexcept;
+    void finish(Job* job) noexcept;
+
+    Job* m_jobs = nullptr;
+    ThreadState* m_states = nullptr;
+    size_t m_thread_count = 0;
+    size_t m_state_count = 0;
+
+    std::atomic<uint64_t> m_free_list{ 0 }; // index of the head and ABA tag
+    std::atomic<size_t> m_adopted_slot_count{ 0 }; // up to the highest slot ever adopted
+    std::atomic<int32_t> m_queued_count{ 0 };
+    std::atomic<bool> m_exit{ false };
+    // notified when jobs are run, complete, and on exit
+    WaitSequence m_idle;
+};
+
+} // namespace sys
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef CHROMA_SYS_MPMC_QUEUE_H
+#define CHROMA_SYS_MPMC_QUEUE_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <system/compiler.h>
+#include <system/noncopyable.h>
+#include <system/wait_sequence.h>
+
+namespace sys {
+
+/*
+ * A bounded lock-free multi-producer multi-consumer queue of CAPACITY items, a power of two
+ * (D. Vyukov, Bounded MPMC queue, 2010). Any thread can push and pop; try_*() never block and
+ * fail when the queue is full or empty, push() and pop() sleep until there is room or an item.
+ *
+ * Each cell carries a sequence number telling which lap of the ring it is ready for: a producer
+ * claims a position with a CAS on the enqueue position, fills the cell and publishes it by
+ * bumping the sequence, the consumers do the same on the dequeue position. The batch versions
+ * claim a run of consecutive ready cells with a single CAS. The two positions live on their own
+ * cache lines. The queue is over-aligned: don't allocate it with a plain new.
+ */
+template<typename T, size_t CAPACITY>
+class MpmcQueue : NonMovable {
+    static_assert(CAPACITY >= 2 && !(CAPACITY & (CAPACITY - 1)),
+            "CAPACITY must be a power of two");
+    static constexpr size_t MASK = CAPACITY - 1;
+
+public:
+    MpmcQueue() noexcept {
+        for (size_t i = 0; i < CAPACITY; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // no thread may be using the queue anymore
+    ~MpmcQueue() noexcept {
+        size_t const tail = m_enqueue_position.load(std::memory_order_relaxed);
+        for (size_t i = m_dequeue_position.load(std::memory_order_relaxed); i != tail; i++) {
+            m_cells[i & MASK].item()->~T();
+        }
+    }
+
+    template<typename... ARGS>
+    bool try_emplace(ARGS&&... args) {
+        size_t position;
+        if (claim(m_enqueue_position, 0, 1, position) == 0) {
+            return false;
+        }
+        Cell& cell = m_cells[position & MASK];
+        new(cell.item()) T(std::forward<ARGS>(args)...);
+        cell.sequence.store(position + 1, std::memory_order_release);
+        m_not_empty.notify();
+        return true;
+    }
+
+    bool try_push(T const& item) { return try_emplace(item); }
+    bool try_push(T&& item) { return try_emplace(std::move(item)); }
+
+    // pushes as many of the count items as fit and returns how many
+    size_t try_push(T const* items, size_t count) {
+        size_t position;
+        size_t const n = claim(m_enqueue_position, 0, count, position);
+        for (size_t i = 0; i < n; i++) {
+            Cell& cell = m_cells[(position + i) & MASK];
+            new(cell.item()) T(items[i]);
+            cell.sequence.store(position + i + 1, std::memory_order_release);
+        }
+        if (n) {
+            m_not_empty.notify();
+        }
+        return n;
+    }
+
+    bool try_pop(T& item) {
+        size_t position;
+        if (claim(m_dequeue_position, 1, 1, position) == 0) {
+            return false;
+        }
+        take(position, item);
+        m_not_full.notify();
+        return true;
+    }
+
+    // pops up to count items and returns how many
+    size_t try_pop(T* items, size_t count) {
+        size_t position;
+        size_t const n = claim(m_dequeue_position, 1, count, position);
+        for (size_t i = 0; i < n; i++) {
+            take(position + i, items[i]);
+        }
+        if (n) {
+            m_not_full.notify();
+        }
+        return n;
+    }
+
+    // waits for room
+    void push(T item) {
+        while (!try_push(std::move(item))) {
+            m_not_full.wait_until([this]() { return claimable(m_enqueue_position, 0); });
+        }
+    }
+
+    // pushes all the items, waiting for room as needed
+    void push(T const* items, size_t count) {
+        while (count) {
+            size_t const n = try_push(items, count);
+            items += n;
+            count -= n;
+            if (count) {
+                m_not_full.wait_until([this]() { return claimable(m_enqueue_position, 0); });
+            }
+        }
+    }
+
+    // waits for an item
+    T pop() {
+        T item;
+        while (!try_pop(item)) {
+            m_not_empty.wait_until([this]() { return claimable(m_dequeue_position, 1); });
+        }
+        return item;
+    }
+
+    // waits for at least one item and pops up to count
+    size_t pop(T* items, size_t count) {
+        assert(count > 0);
+        size_t n;
+        while ((n = try_pop(items, count)) == 0) {
+            m_not_empty.wait_until([this]() { return claimable(m_dequeue_position, 1); });
+        }
+        return n;
+    }
+
+    // a snapshot, counts the items being pushed or popped as well
+    size_t size() const noexcept {
+        size_t const head = m_dequeue_position.load(std::memory_order_acquire);
+        size_t const tail = m_enqueue_position.load(std::memory_order_acquire);
+        // head may be stale by the time tail is read
+        return std::min(tail - head, CAPACITY);
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+    bool full() const noexcept { return size() == CAPACITY; }
+
+    static constexpr size_t capacity() noexcept { return CAPACITY; }
+
+private:
+    struct Cell {
+        using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+        T* item() noexcept { return reinterpret_cast<T*>(&storage); }
+
+        std::atomic<size_t> sequence;
+        Storage storage;
+    };
+
+    // Claims up to count consecutive cells from position, which the producers (lap 0) and the
+    // consumers (lap 1) own once the sequence of a cell is position + lap: returns how many,
+    // the first one in first, 0 when the queue is full or empty.
+    size_t claim(std::atomic<size_t>& position, size_t lap, size_t count,
+            size_t& first) noexcept {
+        size_t pos = position.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t n = 0;
+            intptr_t diff = 0;
+            while (n < count) {
+                size_t const sequence =
+                        m_cells[(pos + n) & MASK].sequence.load(std::memory_order_acquire);
+                diff = intptr_t(sequence) - intptr_t(pos + n + lap);
+                if (diff != 0) {
+                    break;
+                }
+                n++;
+            }
+            if (n == 0) {
+                if (diff < 0) {
+                    // the cell is still a lap behind: full for producers, empty for consumers
+                    return 0;
+                }
+                // another thread claimed it, catch up
+                pos = position.load(std::memory_order_relaxed);
+                continue;
+            }
+            // the cells between pos and pos + n can't be taken from us until the CAS succeeds
+            if (position.compare_exchange_weak(pos, pos + n,
+                    std::memory_order_relaxed, std::memory_order_relaxed)) {
+                first = pos;
+                return n;
+            }
+        }
+    }
+
+    // whether claim() would find a cell, or at least race for it
+    bool claimable(std::atomic<size_t> const& position, size_t lap) const noexcept {
+        size_t const pos = position.load(std::memory_order_relaxed);
+        size_t const sequence = m_cells[pos & MASK].sequence.load(std::memory_order_acquire);
+        return intptr_t(sequence) - intptr_t(pos + lap) >= 0;
+    }
+
+    void take(size_t position, T& item) {
+        Cell& cell = m_cells[position & MASK];
+        T* const p = cell.item();
+        item = std::move(*p);
+        p->~T();
+        // ready for the producers of the next lap
+        cell.sequence.store(position + CAPACITY, std::memory_order_release);
+    }
+
+    alignas(64) std::atomic<size_t> m_enqueue_position{ 0 };
+    WaitSequence m_not_full;
+
+    alignas(64) std::atomic<size_t> m_dequeue_position{ 0 };
+    WaitSequence m_not_empty;
+
+    alignas(64) Cell m_cells[CAPACITY];
+};
+
+template<typename T, size_t CAPACITY>
+constexpr size_t MpmcQueue<T, CAPACITY>::MASK;
+
+} // namespace sys
+
+#endif
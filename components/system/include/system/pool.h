@@ -0,0 +1,218 @@
+#ifndef CHROMA_SYS_POOL_H
+#define CHROMA_SYS_POOL_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <system/allocate_aligned.h>
+#include <system/compiler.h>
+#include <system/noncopyable.h>
+
+namespace sys {
+
+/*
+ * Objects of a single type with stable addresses, created and destroyed in O(1) without going
+ * to the heap once the pool is warm. The objects live in chunks of CHUNK_BYTES allocated as the
+ * pool grows and only released with it. The free slots form a list threaded through the slots
+ * themselves, the most recently freed slot is reused first as it's likely still in the cache.
+ *
+ * The chunks are aligned to their size so that the chunk of an object, and the bit telling
+ * whether its slot is in use, are found from its address: for_each() visits the live objects
+ * in memory order and the objects still alive are destroyed with the pool. Not thread-safe.
+ */
+template<typename T, size_t CHUNK_BYTES = 16384>
+class Pool : NonCopyable {
+    static_assert(CHUNK_BYTES && !(CHUNK_BYTES & (CHUNK_BYTES - 1)),
+            "CHUNK_BYTES must be a power of two");
+    static_assert(alignof(T) <= 64, "T is over-aligned");
+
+    union Slot {
+        Slot* next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type object;
+    };
+
+    // a chunk is the bits of the slots in use, then the slots
+    static constexpr size_t MAX_WORD_COUNT = (CHUNK_BYTES / sizeof(Slot) + 63) / 64;
+    static constexpr size_t HEADER_SIZE =
+            (MAX_WORD_COUNT * sizeof(uint64_t) + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+
+public:
+    static constexpr size_t SLOTS_PER_CHUNK = (CHUNK_BYTES - HEADER_SIZE) / sizeof(Slot);
+    static_assert(SLOTS_PER_CHUNK >= 8, "T is too large for CHUNK_BYTES");
+
+    Pool() noexcept = default;
+
+    Pool(Pool&& rhs) noexcept { swap(rhs); }
+    Pool& operator=(Pool&& rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    ~Pool() noexcept {
+        clear();
+        for (void* chunk : m_chunks) {
+            free_aligned(chunk);
+        }
+    }
+
+    void swap(Pool& rhs) noexcept {
+        std::swap(m_chunks, rhs.m_chunks);
+        std::swap(m_free, rhs.m_free);
+        std::swap(m_size, rhs.m_size);
+    }
+
+    template<typename... ARGS>
+    T* create(ARGS&&... args) {
+        if (SYS_UNLIKELY(!m_free)) {
+            grow();
+        }
+        Slot* const slot = m_free;
+        m_free = slot->next;
+        T* object;
+        try {
+            object = new(&slot->object) T(std::forward<ARGS>(args)...);
+        } catch (...) {
+            // the constructor may have written over the link before throwing
+            slot->next = m_free;
+            m_free = slot;
+            throw;
+        }
+        set_alive(slot, true);
+        m_size++;
+        return object;
+    }
+
+    // object must come from this pool
+    void destroy(T* object) noexcept {
+        if (!object) {
+            return;
+        }
+        assert(owns(object));
+        Slot* const slot = reinterpret_cast<Slot*>(object);
+        assert(is_alive(slot));
+        object->~T();
+        set_alive(slot, false);
+        slot->next = m_free;
+        m_free = slot;
+        m_size--;
+    }
+
+    // destroys all the objects, keeps the chunks
+    void clear() noexcept {
+        m_free = nullptr;
+        // the list is rebuilt from the end so that the first slots are handed out first
+        for (size_t c = m_chunks.size(); c-- > 0;) {
+            Slot* const slots = slots_of(m_chunks[c]);
+            for (size_t i = SLOTS_PER_CHUNK; i-- > 0;) {
+                Slot* const slot = &slots[i];
+                if (is_alive(slot)) {
+                    reinterpret_cast<T*>(&slot->object)->~T();
+                    set_alive(slot, false);
+                }
+                slot->next = m_free;
+                m_free = slot;
+            }
+        }
+        m_size = 0;
+    }
+
+    // calls f(T&) for each live object, in memory order. f must not create or destroy.
+    template<typename F>
+    void for_each(F&& f) {
+        for (void* chunk : m_chunks) {
+            uint64_t const* const words = static_cast<uint64_t const*>(chunk);
+            Slot* const slots = slots_of(chunk);
+            for (size_t w = 0; w < MAX_WORD_COUNT; w++) {
+                for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+                    size_t const i = w * 64 + size_t(count_trailing_zeros(bits));
+                    f(*reinterpret_cast<T*>(&slots[i].object));
+                }
+            }
+        }
+    }
+
+    bool owns(T const* object) const noexcept {
+        return std::find(m_chunks.begin(), m_chunks.end(), chunk_of(object)) != m_chunks.end();
+    }
+
+    size_t size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    size_t capacity() const noexcept { return m_chunks.size() * SLOTS_PER_CHUNK; }
+
+    // allocates the chunks for count objects
+    void reserve(size_t count) {
+        while (capacity() < count) {
+            grow();
+        }
+    }
+
+private:
+    static int count_trailing_zeros(uint64_t bits) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(bits);
+#else
+        int n = 0;
+        for (; !(bits & 1); bits >>= 1) {
+            n++;
+        }
+        return n;
+#endif
+    }
+
+    static void* chunk_of(void const* p) noexcept {
+        uintptr_t const address = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<void*>(address & ~uintptr_t(CHUNK_BYTES - 1));
+    }
+
+    static Slot* slots_of(void* chunk) noexcept {
+        return reinterpret_cast<Slot*>(static_cast<char*>(chunk) + HEADER_SIZE);
+    }
+
+    static bool is_alive(Slot* slot) noexcept {
+        void* const chunk = chunk_of(slot);
+        size_t const i = size_t(slot - slots_of(chunk));
+        return (static_cast<uint64_t const*>(chunk)[i / 64] >> (i % 64)) & 1u;
+    }
+
+    static void set_alive(Slot* slot, bool alive) noexcept {
+        void* const chunk = chunk_of(slot);
+        size_t const i = size_t(slot - slots_of(chunk));
+        uint64_t& word = static_cast<uint64_t*>(chunk)[i / 64];
+        uint64_t const bit = uint64_t(1) << (i % 64);
+        word = alive ? word | bit : word & ~bit;
+    }
+
+    SYS_NOINLINE void grow() {
+        m_chunks.push_back(nullptr);
+        void* const chunk = allocate_aligned(CHUNK_BYTES, CHUNK_BYTES);
+        if (!chunk) {
+            m_chunks.pop_back();
+            throw std::bad_alloc();
+        }
+        m_chunks.back() = chunk;
+        std::fill_n(static_cast<uint64_t*>(chunk), MAX_WORD_COUNT, uint64_t(0));
+        Slot* const slots = slots_of(chunk);
+        for (size_t i = SLOTS_PER_CHUNK; i-- > 0;) {
+            slots[i].next = m_free;
+            m_free = &slots[i];
+        }
+    }
+
+    std::vector<void*> m_chunks;
+    Slot* m_free = nullptr;
+    size_t m_size = 0;
+};
+
+template<typename T, size_t CHUNK_BYTES>
+constexpr size_t Pool<T, CHUNK_BYTES>::SLOTS_PER_CHUNK;
+
+} // namespace sys
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef CHROMA_SYS_SLOT_MAP_H
+#define CHROMA_SYS_SLOT_MAP_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <system/compiler.h>
+
+namespace sys {
+
+/*
+ * A generational handle to an object of a SlotMap<T>: the index of a slot and the generation
+ * the slot had when the object was inserted. A 32-bit handle has 20 bits of index (a million
+ * objects) and 12 of generation, a 64-bit one 32 and 32. The default handle is null, TAG keeps
+ * the handles of different maps apart.
+ */
+template<typename TAG, typename STORAGE = uint32_t>
+class SlotHandle {
+    static_assert(std::is_same<STORAGE, uint32_t>::value ||
+            std::is_same<STORAGE, uint64_t>::value, "handles are 32 or 64 bits");
+
+public:
+    using storage_type = STORAGE;
+
+    static constexpr unsigned INDEX_BITS = sizeof(STORAGE) == 8 ? 32 : 20;
+    static constexpr unsigned GENERATION_BITS = unsigned(sizeof(STORAGE) * 8) - INDEX_BITS;
+    static constexpr STORAGE MAX_INDEX = (STORAGE(1) << INDEX_BITS) - 1;
+    static constexpr STORAGE MAX_GENERATION = (STORAGE(1) << GENERATION_BITS) - 1;
+
+    constexpr SlotHandle() noexcept = default;
+
+    // generation 0 is never used, which makes 0 the null handle
+    constexpr SlotHandle(STORAGE index, STORAGE generation) noexcept
+            : m_value(generation << INDEX_BITS | index) {}
+
+    static constexpr SlotHandle from_value(STORAGE value) noexcept {
+        return SlotHandle(value & MAX_INDEX, value >> INDEX_BITS);
+    }
+
+    constexpr STORAGE index() const noexcept { return m_value & MAX_INDEX; }
+    constexpr STORAGE generation() const noexcept { return m_value >> INDEX_BITS; }
+    constexpr STORAGE value() const noexcept { return m_value; }
+
+    constexpr explicit operator bool() const noexcept { return m_value != 0; }
+
+    constexpr bool operator==(SlotHandle rhs) const noexcept { return m_value == rhs.m_value; }
+    constexpr bool operator!=(SlotHandle rhs) const noexcept { return m_value != rhs.m_value; }
+    constexpr bool operator<(SlotHandle rhs) const noexcept { return m_value < rhs.m_value; }
+
+private:
+    STORAGE m_value = 0;
+};
+
+template<typename TAG, typename STORAGE>
+constexpr unsigned SlotHandle<TAG, STORAGE>::INDEX_BITS;
+
+template<typename TAG, typename STORAGE>
+constexpr unsigned SlotHandle<TAG, STORAGE>::GENERATION_BITS;
+
+template<typename TAG, typename STORAGE>
+constexpr STORAGE SlotHandle<TAG, STORAGE>::MAX_INDEX;
+
+template<typename TAG, typename STORAGE>
+constexpr STORAGE SlotHandle<TAG, STORAGE>::MAX_GENERATION;
+
+/*
+ * Objects addressed by generational handles. insert() and erase() are O(1), a handle to an
+ * erased object is detected and get() returns nullptr for it, until the generation of its slot
+ * wraps around (4096 reuses of the same slot for 32-bit handles).
+ *
+ * The objects are packed in a dense array for iteration: erase() moves the last object in the
+ * hole, so pointers and the iteration order are not stable, the handles are. handle_of(i) is
+ * the handle of the i-th object of the dense array.
+ */
+template<typename T, typename STORAGE = uint32_t>
+class SlotMap {
+public:
+    using Handle = SlotHandle<T, STORAGE>;
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    static constexpr size_t MAX_SIZE = size_t(Handle::MAX_INDEX) + 1;
+
+    // a null handle when the map is full
+    template<typename... ARGS>
+    Handle emplace(ARGS&&... args) {
+        bool const reuse = m_free_head != NONE;
+        if (!reuse && m_slots.size() >= MAX_SIZE) {
+            return Handle();
+        }
+        STORAGE const index = reuse ? m_free_head : STORAGE(m_slots.size());
+        size_t const slot_count = m_slots.size();
+        try {
+            if (!reuse) {
+                m_slots.push_back(Slot{ NONE, 1 });
+            }
+            m_dense_to_slot.push_back(index);
+            m_values.emplace_back(std::forward<ARGS>(args)...);
+        } catch (...) {
+            // emplace_back() leaves m_values as it was, the bookkeeping goes back to match it
+            m_slots.resize(slot_count);
+            m_dense_to_slot.resize(m_values.size());
+            throw;
+        }
+        if (reuse) {
+            STORAGE const next = m_slots[index].dense;
+            m_free_head = next == NONE ? NONE : next & ~FREE;
+        }
+        Slot& slot = m_slots[index];
+        slot.dense = STORAGE(m_values.size() - 1);
+        return Handle(index, slot.generation);
+    }
+
+    Handle insert(const T& value) { return emplace(value); }
+    Handle insert(T&& value) { return emplace(std::move(value)); }
+
+    // false if the handle is stale
+    bool erase(Handle handle) {
+        Slot* const slot = find(handle);
+        if (!slot) {
+            return false;
+        }
+        STORAGE const dense = slot->dense;
+        STORAGE const last = STORAGE(m_values.size() - 1);
+        if (dense != last) {
+            m_values[dense] = std::move(m_values[last]);
+            m_dense_to_slot[dense] = m_dense_to_slot[last];
+            m_slots[m_dense_to_slot[dense]].dense = dense;
+        }
+        m_values.pop_back();
+        m_dense_to_slot.pop_back();
+        // invalidates the handles, generation 0 is skipped
+        slot->generation = slot->generation < Handle::MAX_GENERATION ? slot->generation + 1 : 1;
+        slot->dense = m_free_head | FREE;
+        m_free_head = handle.index();
+        return true;
+    }
+
+    T* get(Handle handle) noexcept {
+        Slot const* const slot = find(handle);
+        return slot ? &m_values[slot->dense] : nullptr;
+    }
+
+    T const* get(Handle handle) const noexcept {
+        Slot const* const slot = find(handle);
+        return slot ? &m_values[slot->dense] : nullptr;
+    }
+
+    bool contains(Handle handle) const noexcept { return find(handle) != nullptr; }
+
+    T& operator[](Handle handle) noexcept {
+        assert(contains(handle));
+        return m_values[m_slots[handle.index()].dense];
+    }
+
+    T const& operator[](Handle handle) const noexcept {
+        assert(contains(handle));
+        return m_values[m_slots[handle.index()].dense];
+    }
+
+    Handle handle_of(size_t dense_index) const noexcept {
+        STORAGE const index = m_dense_to_slot[dense_index];
+        return Handle(index, m_slots[index].generation);
+    }
+
+    // erases all the objects, their handles become stale
+    void clear() {
+        while (!m_values.empty()) {
+            erase(handle_of(m_values.size() - 1));
+        }
+    }
+
+    void reserve(size_t count) {
+        m_values.reserve(count);
+        m_dense_to_slot.reserve(count);
+        m_slots.reserve(count);
+    }
+
+    size_t size() const noexcept { return m_values.size(); }
+    bool empty() const noexcept { return m_values.empty(); }
+
+    T* data() noexcept { return m_values.data(); }
+    T const* data() const noexcept { return m_values.data(); }
+
+    iterator begin() noexcept { return m_values.begin(); }
+    iterator end() noexcept { return m_values.end(); }
+    const_iterator begin() const noexcept { return m_values.begin(); }
+    const_iterator end() const noexcept { return m_values.end(); }
+
+private:
+    static constexpr STORAGE NONE = ~STORAGE(0);
+    // marks the free slots, in which dense is the next free slot
+    static constexpr STORAGE FREE = STORAGE(1) << (sizeof(STORAGE) * 8 - 1);
+
+    struct Slot {
+        STORAGE dense;      // index in m_values, or the next free slot | FREE
+        STORAGE generation;
+    };
+
+    Slot* find(Handle handle) noexcept {
+        return const_cast<Slot*>(static_cast<SlotMap const*>(this)->find(handle));
+    }
+
+    Slot const* find(Handle handle) const noexcept {
+        STORAGE const index = handle.index();
+        if (SYS_UNLIKELY(index >= m_slots.size())) {
+            return nullptr;
+        }
+        Slot const& slot = m_slots[index];
+        // the generation of a free slot is already the one of its next object
+        return slot.generation == handle.generation() && !(slot.dense & FREE) ? &slot : nullptr;
+    }
+
+    std::vector<T> m_values;
+    std::vector<STORAGE> m_dense_to_slot;
+    std::vector<Slot> m_slots;
+    STORAGE m_free_head = NONE;
+};
+
+template<typename T, typename STORAGE>
+constexpr size_t SlotMap<T, STORAGE>::MAX_SIZE;
+
+template<typename T, typename STORAGE>
+constexpr STORAGE SlotMap<T, STORAGE>::NONE;
+
+template<typename T, typename STORAGE>
+constexpr STORAGE SlotMap<T, STORAGE>::FREE;
+
+} // namespace sys
+
+namespace std {
+
+template<typename TAG, typename STORAGE>
+struct hash<::sys::SlotHandle<TAG, STORAGE>> {
+    size_t operator()(::sys::SlotHandle<TAG, STORAGE> handle) const noexcept {
+        return std::hash<STORAGE>()(handle.value());
+    }
+};
+
+} // namespace std
+
+#endif
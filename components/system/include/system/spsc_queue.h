@@ -0,0 +1,195 @@
+#ifndef CHROMA_SYS_SPSC_QUEUE_H
+#define CHROMA_SYS_SPSC_QUEUE_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <system/compiler.h>
+#include <system/noncopyable.h>
+#include <system/wait_sequence.h>
+
+namespace sys {
+
+/*
+ * A bounded wait-free single-producer single-consumer ring of CAPACITY items, a power of two.
+ * One thread pushes, one thread pops; try_*() never block and fail when the ring is full or
+ * empty, push() and pop() sleep until there is room or an item.
+ *
+ * The head (popped by the consumer) and the tail (pushed by the producer) live on their own
+ * cache lines, each side keeps a copy of the other side's index and only reloads it when the
+ * copy says the ring is full or empty, so in the steady state the two threads only share the
+ * cache lines of the items. The queue is over-aligned: don't allocate it with a plain new.
+ */
+template<typename T, size_t CAPACITY>
+class SpscQueue : NonMovable {
+    static_assert(CAPACITY >= 2 && !(CAPACITY & (CAPACITY - 1)),
+            "CAPACITY must be a power of two");
+    static constexpr size_t MASK = CAPACITY - 1;
+
+public:
+    SpscQueue() noexcept = default;
+
+    ~SpscQueue() noexcept {
+        size_t const tail = m_tail.load(std::memory_order_relaxed);
+        for (size_t i = m_head.load(std::memory_order_relaxed); i != tail; i++) {
+            item_at(i)->~T();
+        }
+    }
+
+    // producer thread only
+    template<typename... ARGS>
+    bool try_emplace(ARGS&&... args) {
+        size_t const tail = m_tail.load(std::memory_order_relaxed);
+        if (SYS_UNLIKELY(tail - m_head_cache == CAPACITY)) {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+            if (tail - m_head_cache == CAPACITY) {
+                return false;
+            }
+        }
+        new(item_at(tail)) T(std::forward<ARGS>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        m_not_empty.notify();
+        return true;
+    }
+
+    bool try_push(T const& item) { return try_emplace(item); }
+    bool try_push(T&& item) { return try_emplace(std::move(item)); }
+
+    // producer thread only, pushes as many of the count items as fit and returns how many
+    size_t try_push(T const* items, size_t count) {
+        size_t const tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head_cache + count > CAPACITY) {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+        }
+        size_t const n = std::min(count, CAPACITY - (tail - m_head_cache));
+        if (n == 0) {
+            return 0;
+        }
+        for (size_t i = 0; i < n; i++) {
+            new(item_at(tail + i)) T(items[i]);
+        }
+        // one release and one notification for the whole batch
+        m_tail.store(tail + n, std::memory_order_release);
+        m_not_empty.notify();
+        return n;
+    }
+
+    // consumer thread only
+    bool try_pop(T& item) {
+        size_t const head = m_head.load(std::memory_order_relaxed);
+        if (SYS_UNLIKELY(head == m_tail_cache)) {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tail_cache) {
+                return false;
+            }
+        }
+        T* const p = item_at(head);
+        item = std::move(*p);
+        p->~T();
+        m_head.store(head + 1, std::memory_order_release);
+        m_not_full.notify();
+        return true;
+    }
+
+    // consumer thread only, pops up to count items and returns how many
+    size_t try_pop(T* items, size_t count) {
+        size_t const head = m_head.load(std::memory_order_relaxed);
+        if (m_tail_cache - head < count) {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+        }
+        size_t const n = std::min(count, m_tail_cache - head);
+        if (n == 0) {
+            return 0;
+        }
+        for (size_t i = 0; i < n; i++) {
+            T* const p = item_at(head + i);
+            items[i] = std::move(*p);
+            p->~T();
+        }
+        m_head.store(head + n, std::memory_order_release);
+        m_not_full.notify();
+        return n;
+    }
+
+    // producer thread only, waits for room
+    void push(T item) {
+        while (!try_push(std::move(item))) {
+            m_not_full.wait_until([this]() { return !full(); });
+        }
+    }
+
+    // producer thread only, pushes all the items, waiting for room as needed
+    void push(T const* items, size_t count) {
+        while (count) {
+            size_t const n = try_push(items, count);
+            items += n;
+            count -= n;
+            if (count) {
+                m_not_full.wait_until([this]() { return !full(); });
+            }
+        }
+    }
+
+    // consumer thread only, waits for an item
+    T pop() {
+        T item;
+        while (!try_pop(item)) {
+            m_not_empty.wait_until([this]() { return !empty(); });
+        }
+        return item;
+    }
+
+    // consumer thread only, waits for at least one item and pops up to count
+    size_t pop(T* items, size_t count) {
+        assert(count > 0);
+        size_t n;
+        while ((n = try_pop(items, count)) == 0) {
+            m_not_empty.wait_until([this]() { return !empty(); });
+        }
+        return n;
+    }
+
+    // exact from the producer or the consumer, a snapshot from other threads
+    size_t size() const noexcept {
+        size_t const head = m_head.load(std::memory_order_acquire);
+        // head may be stale by the time tail is read
+        return std::min(m_tail.load(std::memory_order_acquire) - head, CAPACITY);
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+    bool full() const noexcept { return size() == CAPACITY; }
+
+    static constexpr size_t capacity() noexcept { return CAPACITY; }
+
+private:
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    T* item_at(size_t index) noexcept {
+        return reinterpret_cast<T*>(&m_items[index & MASK]);
+    }
+
+    // consumer side: the head and the last tail it read
+    alignas(64) std::atomic<size_t> m_head{ 0 };
+    size_t m_tail_cache = 0;
+    WaitSequence m_not_full;
+
+    // producer side: the tail and the last head it read
+    alignas(64) std::atomic<size_t> m_tail{ 0 };
+    size_t m_head_cache = 0;
+    WaitSequence m_not_empty;
+
+    alignas(64) Storage m_items[CAPACITY];
+};
+
+template<typename T, size_t CAPACITY>
+constexpr size_t SpscQueue<T, CAPACITY>::MASK;
+
+} // namespace sys
+
+#endif
@@ -1,14 +1,18 @@
 #ifndef CHROMA_THREAD_STORAGE_H
 #define CHROMA_THREAD_STORAGE_H
 
-#include <unordered_map> 
-#include <thread> 
-#include <mutex> 
-#include <shared_mutex> 
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <utility>
-#include <vector> 
-#include <memory> 
-#include <algorithm> 
+#include <vector>
+
+#include <system/compiler.h>
+#include <system/noncopyable.h>
 
 namespace sys {
 
@@ -25,85 +29,245 @@ struct ValueStorage : public DynamicStorageBase {
     T value;
 };
 
-template<typename T>
-class ThreadStorage {
-public:
-    unsigned int add(T** obj = nullptr);
+namespace details {
 
-    T* get(unsigned int id);
-    const T* get(unsigned int id) const;
-    bool remove(unsigned int id);
+class ThreadStorageBase;
 
-protected:
-    unsigned int highestID_{};
-    std::vector<unsigned int> ids_;
-    std::unordered_map<std::thread::id, std::unordered_map<unsigned int, T>> objects_;
-    mutable std::shared_mutex mutex_;
+// the objects of one thread in one ThreadStorage
+struct ThreadStorageBlock {
+    virtual ~ThreadStorageBlock() noexcept = default;
+    // forgets the id of the slot, called with the lock of the storage
+    virtual void invalidate(size_t slot) noexcept = 0;
+
+    ThreadStorageBase* owner = nullptr;
+    std::vector<ThreadStorageBlock*>* table = nullptr; // of its thread
 };
 
-using DynamicStoragePtr = std::unique_ptr<DynamicStorageBase>;
-using DynamicThreadStorage = ThreadStorage<DynamicStoragePtr>;
+// the blocks of the calling thread indexed by ThreadStorageBase::m_index, freed when it exits
+struct ThreadStorageBlocks {
+    ~ThreadStorageBlocks() noexcept;
+    std::vector<ThreadStorageBlock*> blocks;
+};
 
+inline ThreadStorageBlocks& thread_storage_blocks() noexcept {
+    static thread_local ThreadStorageBlocks blocks;
+    return blocks;
+}
 
+// registration of the blocks, behind a global mutex: it's only used the first time a thread
+// touches a storage, when a thread exits and when a storage is destroyed. The objects are
+// destroyed outside of it, they can own or use storages themselves.
+class ThreadStorageBase : NonMovable {
+protected:
+    ThreadStorageBase();
+    ~ThreadStorageBase() noexcept;
+
+    ThreadStorageBlock* local_block() const noexcept {
+        std::vector<ThreadStorageBlock*> const& blocks = thread_storage_blocks().blocks;
+        // a destroyed storage takes its blocks out of the tables, a new one reusing its index
+        // finds nullptr
+        return SYS_LIKELY(m_index < blocks.size()) ? blocks[m_index] : nullptr;
+    }
 
+    // makes block the one of the calling thread
+    void attach(ThreadStorageBlock* block);
 
+    // invalidates the slot in the blocks of all the threads
+    void invalidate(size_t slot) noexcept;
 
+private:
+    friend struct ThreadStorageBlocks;
 
+    size_t m_index;
+    std::vector<ThreadStorageBlock*> m_blocks; // of all the threads
+};
 
+} // namespace details
+
+/*
+ * One T per thread and per id. add() allocates an id, get(id) returns the T of the calling
+ * thread for it, default-constructed on first use, and nullptr once the id was removed.
+ *
+ * get() only reads memory of the calling thread when it already has an object for the id: it
+ * finds its own block of objects through a thread_local table indexed by the storage, then
+ * the object in the block by the slot of the id, which must still hold that id. Ids are a slot
+ * and a generation, the next id on a slot has a new generation. remove() clears the id from the
+ * blocks of all the threads, so that the id is only checked against the storage, under its
+ * lock, on a miss. The objects the threads had for the removed id are destroyed when the thread
+ * gets the slot again under a new id, when it exits or when the storage is destroyed.
+ *
+ * A hit is not a single dereference: the thread_local table, the block, its entries and the
+ * entry are four dependent loads, all in memory of the calling thread. A flat T* per slot would
+ * save one but has nowhere to keep the id, which remove() needs to clear without the storage.
+ *
+ * At most CAPACITY ids are alive at the same time. The storage must outlive its use by the
+ * other threads.
+ */
+template<typename T, size_t CAPACITY = 1024>
+class ThreadStorage : public details::ThreadStorageBase {
+    static_assert(CAPACITY > 0 && CAPACITY < (size_t(1) << 16), "CAPACITY must fit in 16 bits");
 
+public:
+    ThreadStorage();
+    ~ThreadStorage() noexcept;
 
+    // 0 when all the slots are taken
+    unsigned int add(T** obj = nullptr);
 
+    T* get(unsigned int id);
+    const T* get(unsigned int id) const;
+    bool remove(unsigned int id);
 
+private:
+    struct Block : public details::ThreadStorageBlock {
+        struct Entry {
+            std::atomic<unsigned int> id{ 0 }; // 0 once removed
+            std::unique_ptr<T> value;
+        };
+
+        ~Block() noexcept override = default;
+
+        void invalidate(size_t slot) noexcept override {
+            if (slot < size) {
+                entries[slot].id.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // resized under the lock of the storage, read without it by the owning thread only
+        std::unique_ptr<Entry[]> entries; // by slot
+        size_t size = 0;
+    };
+
+    static size_t slot_of(unsigned int id) noexcept { return id % CAPACITY; }
+    static uint32_t generation_of(unsigned int id) noexcept { return uint32_t(id / CAPACITY); }
+
+    T* get_slow(Block* block, unsigned int id);
+
+    // add(), remove() and the misses of get()
+    std::mutex m_mutex;
+    // the generation of the live id of each slot, 0 when it's free
+    uint32_t m_generations[CAPACITY];
+    uint32_t m_next_generation[CAPACITY];
+    std::vector<uint32_t> m_free_slots;
+};
 
+using DynamicStoragePtr = std::unique_ptr<DynamicStorageBase>;
+using DynamicThreadStorage = ThreadStorage<DynamicStoragePtr>;
 
-template<typename T>
-unsigned int ThreadStorage<T>::add(T** obj) {
-    std::scoped_lock lock(mutex_);
-    auto id = ++highestID_;
-    ids_.push_back(id);
-    if (obj) {
-        *obj = &objects_[std::this_thread::get_id()][id];
+template<typename T, size_t CAPACITY>
+ThreadStorage<T, CAPACITY>::ThreadStorage() {
+    m_free_slots.reserve(CAPACITY);
+    for (size_t i = 0; i < CAPACITY; i++) {
+        m_generations[i] = 0;
+        m_next_generation[i] = 1;
+        m_free_slots.push_back(uint32_t(CAPACITY - 1 - i));
     }
+}
 
+template<typename T, size_t CAPACITY>
+ThreadStorage<T, CAPACITY>::~ThreadStorage() noexcept = default;
+
+template<typename T, size_t CAPACITY>
+unsigned int ThreadStorage<T, CAPACITY>::add(T** obj) {
+    unsigned int id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free_slots.empty()) {
+            return 0;
+        }
+        uint32_t const slot = m_free_slots.back();
+        m_free_slots.pop_back();
+        uint32_t const generation = m_next_generation[slot];
+        // generation 0 means free, and keeps the ids non-zero
+        // the largest one whose ids, up to slot CAPACITY - 1, don't wrap
+        uint32_t const max_generation = uint32_t((~0u - (CAPACITY - 1)) / CAPACITY);
+        m_next_generation[slot] = generation < max_generation ? generation + 1 : 1;
+        m_generations[slot] = generation;
+        id = unsigned(generation * CAPACITY + slot);
+    }
+    if (obj) {
+        *obj = get(id);
+    }
     return id;
 }
 
-template<typename T>
-T* ThreadStorage<T>::get(unsigned int id) {
-    std::shared_lock lock(mutex_);
-    if (std::find(ids_.begin(), ids_.end(), id) == ids_.end()) {
-        return nullptr;
+template<typename T, size_t CAPACITY>
+T* ThreadStorage<T, CAPACITY>::get(unsigned int id) {
+    size_t const slot = slot_of(id);
+    Block* const block = static_cast<Block*>(local_block());
+    if (SYS_LIKELY(block && slot < block->size)) {
+        typename Block::Entry const& entry = block->entries[slot];
+        // a removed id is never found, remove() cleared it
+        if (SYS_LIKELY(entry.id.load(std::memory_order_relaxed) == id && id != 0)) {
+            return entry.value.get();
+        }
     }
+    return get_slow(block, id);
+}
 
-    return &objects_[std::this_thread::get_id()][id];
+template<typename T, size_t CAPACITY>
+const T* ThreadStorage<T, CAPACITY>::get(unsigned int id) const {
+    // creating the object of the calling thread doesn't change the storage as seen by others
+    return const_cast<ThreadStorage*>(this)->get(id);
 }
 
-template<typename T>
-const T* ThreadStorage<T>::get(unsigned int id) const {
-    std::shared_lock lock(mutex_);
-    if (std::find(ids_.begin(), ids_.end(), id) == ids_.end()) {
+template<typename T, size_t CAPACITY>
+SYS_NOINLINE
+T* ThreadStorage<T, CAPACITY>::get_slow(Block* block, unsigned int id) {
+    size_t const slot = slot_of(id);
+    uint32_t const generation = generation_of(id);
+    // T is created and destroyed outside of the lock, it may use the storage: the lock is
+    // released before value on every return
+    std::unique_ptr<T> value;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (generation == 0 || m_generations[slot] != generation) {
         return nullptr;
     }
-
-    return &objects_[std::this_thread::get_id()][id];
+    lock.unlock();
+    value.reset(new T());
+    T* const result = value.get();
+    lock.lock();
+    if (m_generations[slot] != generation) {
+        // removed meanwhile
+        return nullptr;
+    }
+    if (!block) {
+        std::unique_ptr<Block> created(new Block);
+        attach(created.get());
+        block = created.release();
+    }
+    if (slot >= block->size) {
+        size_t const size = std::min(std::max(slot + 1, block->size * 2), CAPACITY);
+        std::unique_ptr<typename Block::Entry[]> entries(new typename Block::Entry[size]);
+        for (size_t i = 0; i < block->size; i++) {
+            entries[i].id.store(block->entries[i].id.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+            entries[i].value = std::move(block->entries[i].value);
+        }
+        block->entries = std::move(entries);
+        block->size = size;
+    }
+    // first use of the slot, or the object of an id that was removed since
+    typename Block::Entry& entry = block->entries[slot];
+    std::swap(entry.value, value);
+    entry.id.store(id, std::memory_order_relaxed);
+    return result;
 }
 
-template<typename T>
-bool ThreadStorage<T>::remove(unsigned int id) {
-    std::scoped_lock lock(mutex_);
-    auto it = std::find(ids_.begin(), ids_.end(), id);
-    if (it == ids_.end()) {
+template<typename T, size_t CAPACITY>
+bool ThreadStorage<T, CAPACITY>::remove(unsigned int id) {
+    size_t const slot = slot_of(id);
+    uint32_t const generation = generation_of(id);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (generation == 0 || m_generations[slot] != generation) {
         return false;
     }
-
-    ids_.erase(it);
-    for (auto& obj : objects_) {
-        obj.second.erase(id);
-    }
-
+    m_generations[slot] = 0;
+    m_free_slots.push_back(uint32_t(slot));
+    invalidate(slot);
     return true;
 }
 
 } // namespace sys
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,81 @@
+#ifndef CHROMA_SYS_WAIT_SEQUENCE_H
+#define CHROMA_SYS_WAIT_SEQUENCE_H
+
+#include <stdint.h>
+#include <atomic>
+
+#if !defined(__linux__)
+#   include <condition_variable>
+#   include <mutex>
+#endif
+
+#include <system/compiler.h>
+#include <system/noncopyable.h>
+
+namespace sys {
+
+/*
+ * Lets threads sleep until a condition on lock-free state becomes true:
+ *
+ *     consumer:  waiter.wait_until([&]() { return !queue.empty(); });
+ *     producer:  queue.push(item); waiter.notify();
+ *
+ * The waiters sleep on a futex (a condition variable outside of Linux) keyed on a sequence
+ * notify() bumps. notify() only makes a system call when a thread went to sleep since the last
+ * one, otherwise it costs a fence and a load.
+ */
+class WaitSequence : NonMovable {
+public:
+    WaitSequence() noexcept;
+    ~WaitSequence() noexcept;
+
+    // returns once pred() is true, spinning with SYS_PAUSE() for a while before sleeping
+    template<typename P>
+    void wait_until(P&& pred) noexcept {
+        for (int i = 0; i < SPIN_COUNT; i++) {
+            if (pred()) {
+                return;
+            }
+            SYS_PAUSE();
+        }
+        while (!pred()) {
+            uint32_t const sequence = m_sequence.load(std::memory_order_seq_cst);
+            m_waiter_count.fetch_add(1, std::memory_order_seq_cst);
+            // against the fence of notify(): either it sees us waiting or we see the change
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!pred()) {
+                wait(sequence);
+            }
+            // the count is reset by notify(), a waiter that didn't sleep costs one extra wake
+        }
+    }
+
+    // after the change that makes the condition of the waiters true, wakes all of them
+    void notify() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (SYS_UNLIKELY(m_waiter_count.load(std::memory_order_relaxed) > 0)) {
+            // the waiters keep their registration until they run again: wake them only once
+            if (m_waiter_count.exchange(0, std::memory_order_seq_cst) > 0) {
+                wake();
+            }
+        }
+    }
+
+private:
+    static constexpr int SPIN_COUNT = 64;
+
+    // sleeps unless the sequence moved past sequence, may return spuriously
+    void wait(uint32_t sequence) noexcept;
+    void wake() noexcept;
+
+    std::atomic<uint32_t> m_sequence{ 0 };
+    std::atomic<uint32_t> m_waiter_count{ 0 };
+#if !defined(__linux__)
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+#endif
+};
+
+} // namespace sys
+
+#endif
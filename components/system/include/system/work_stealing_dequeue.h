@@ -0,0 +1,108 @@
+#ifndef CHROMA_SYS_WORK_STEALING_DEQUEUE_H
+#define CHROMA_SYS_WORK_STEALING_DEQUEUE_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+namespace sys {
+
+/*
+ * A fixed-size lock-free work-stealing dequeue (D. Chase, Y. Lev, Dynamic Circular
+ * Work-Stealing Deque, 2005, with the memory orders of N.M. Le et al., Correct and Efficient
+ * Work-Stealing for Weak Memory Models, 2013).
+ *
+ * The owner thread push()es and pop()s at the bottom, any other thread can steal() from the
+ * top. TYPE must be trivially copyable and fit in a std::atomic, an empty TYPE() is returned
+ * when there is nothing to pop or steal. The dequeue holds at most COUNT items, a power of
+ * two; pushing more is a bug.
+ */
+template<typename TYPE, size_t COUNT>
+class WorkStealingDequeue {
+    static_assert(!(COUNT & (COUNT - 1)), "COUNT must be a power of two");
+    static constexpr size_t MASK = COUNT - 1;
+
+    // signed, so that bottom can go one below top while popping an empty dequeue
+    using index_t = int64_t;
+
+public:
+    // owner thread only
+    void push(TYPE item) noexcept {
+        index_t const bottom = m_bottom.load(std::memory_order_relaxed);
+        assert(bottom - m_top.load(std::memory_order_relaxed) < index_t(COUNT));
+        set_item_at(bottom, item);
+        // the item is visible to the thieves before the new bottom
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    // owner thread only
+    TYPE pop() noexcept {
+        // reserve the bottom item, thieves that read the old bottom may still race for it
+        index_t const bottom = m_bottom.fetch_sub(1, std::memory_order_seq_cst) - 1;
+        index_t const top = m_top.load(std::memory_order_seq_cst);
+        if (top < bottom) {
+            // more than one item, no thief can get to this one
+            return get_item_at(bottom);
+        }
+        TYPE item{};
+        if (top == bottom) {
+            // the last item, the thieves might take it as well: same CAS as in steal()
+            item = get_item_at(bottom);
+            index_t expected = top;
+            if (!m_top.compare_exchange_strong(expected, top + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = TYPE();
+            }
+        }
+        // empty either way now, restore bottom to top
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return item;
+    }
+
+    // any thread
+    TYPE steal() noexcept {
+        while (true) {
+            index_t top = m_top.load(std::memory_order_seq_cst);
+            index_t const bottom = m_bottom.load(std::memory_order_seq_cst);
+            if (top >= bottom) {
+                return TYPE();
+            }
+            TYPE const item = get_item_at(top);
+            if (m_top.compare_exchange_strong(top, top + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return item;
+            }
+            // another thief or pop() took it, try the next one
+        }
+    }
+
+    // approximate when other threads are active
+    size_t size() const noexcept {
+        index_t const bottom = m_bottom.load(std::memory_order_relaxed);
+        index_t const top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? size_t(bottom - top) : 0;
+    }
+
+    static constexpr size_t capacity() noexcept { return COUNT; }
+
+private:
+    // the items are atomics so that a thief reading a slot the owner is overwriting is not a
+    // data race, the CAS on top decides who got it
+    TYPE get_item_at(index_t index) const noexcept {
+        return m_items[index & MASK].load(std::memory_order_relaxed);
+    }
+
+    void set_item_at(index_t index, TYPE item) noexcept {
+        m_items[index & MASK].store(item, std::memory_order_relaxed);
+    }
+
+    // top and bottom on their own cache lines, they are written by different threads
+    alignas(64) std::atomic<index_t> m_top{ 0 };
+    alignas(64) std::atomic<index_t> m_bottom{ 0 };
+    alignas(64) std::atomic<TYPE> m_items[COUNT];
+};
+
+} // namespace sys
+
+#endif
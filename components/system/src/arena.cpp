@@ -0,0 +1,62 @@
+#include <system/arena.h>
+#include <system/allocate_aligned.h>
+
+#include <stdexcept>
+
+namespace sys {
+
+constexpr size_t FrameAllocator::MAX_FRAME_COUNT;
+
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+LinearArena::LinearArena(size_t capacity) {
+    void* const p = allocate_aligned(capacity, CACHE_LINE_SIZE);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    m_begin = static_cast<char*>(p);
+    m_end = m_begin + capacity;
+    m_top = m_begin;
+    m_owned = true;
+#if SYS_ARENA_POISON
+    memset(m_begin, 0xDD, capacity);
+#endif
+}
+
+LinearArena::LinearArena(void* begin, size_t capacity) noexcept
+        : m_begin(static_cast<char*>(begin)),
+          m_end(static_cast<char*>(begin) + capacity),
+          m_top(static_cast<char*>(begin)) {
+}
+
+LinearArena::~LinearArena() noexcept {
+    if (m_owned) {
+        free_aligned(m_begin);
+    }
+}
+
+FrameAllocator::FrameAllocator(size_t frame_capacity, size_t frame_count)
+        : m_frame_count(frame_count) {
+    // in every build: the arenas are a fixed array and begin_frame() divides by the count
+    if (frame_count < 1 || frame_count > MAX_FRAME_COUNT) {
+        throw std::invalid_argument("FrameAllocator: frame_count out of range");
+    }
+    // each arena starts on a cache line
+    size_t const stride = (frame_capacity + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+    m_memory = LinearArena(stride * frame_count);
+    for (size_t i = 0; i < frame_count; i++) {
+        m_arenas[i] = LinearArena(m_memory.allocate(stride, CACHE_LINE_SIZE), frame_capacity);
+    }
+}
+
+FrameAllocator::~FrameAllocator() noexcept = default;
+
+size_t FrameAllocator::peak() const noexcept {
+    size_t peak = 0;
+    for (size_t i = 0; i < m_frame_count; i++) {
+        peak = m_arenas[i].peak() > peak ? m_arenas[i].peak() : peak;
+    }
+    return peak;
+}
+
+} // namespace sys
@@ -1,6 +1,7 @@
 #include <system/c_str.h>
 #include <system/compiler.h>
 #include <memory>
+#include <string.h>
 
 namespace sys {
 
@@ -0,0 +1,380 @@
+#include <system/job_system.h>
+#include <system/allocate_aligned.h>
+#include <system/work_stealing_dequeue.h>
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#if defined(__linux__)
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+namespace sys {
+
+constexpr size_t JobSystem::MAX_JOB_COUNT;
+constexpr size_t JobSystem::MAX_JOB_SYSTEMS_PER_THREAD;
+constexpr size_t JobSystem::Job::STORAGE_SIZE;
+constexpr uint16_t JobSystem::Job::NONE;
+constexpr uint16_t JobSystem::Job::OWNS_FUNCTOR;
+
+struct JobSystem::ThreadState {
+    WorkStealingDequeue<Job*, MAX_JOB_COUNT> queue;
+    std::thread thread;
+    JobSystem* js = nullptr;
+    uint32_t rng = 0;
+    std::atomic<bool> adopted{ false };
+};
+
+// a job system the current thread is a worker of or adopted, and its state in it
+struct JobSystem::ThreadLink {
+    JobSystem const* js;
+    ThreadState* state;
+};
+
+JobSystem::ThreadLink* JobSystem::thread_links() noexcept {
+    static thread_local ThreadLink links[MAX_JOB_SYSTEMS_PER_THREAD] = {};
+    return links;
+}
+
+template<typename T>
+static T* new_aligned_array(size_t count) {
+    void* const p = allocate_aligned(sizeof(T) * count, alignof(T));
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    T* array = static_cast<T*>(p);
+    for (size_t i = 0; i < count; i++) {
+        new(array + i) T();
+    }
+    return array;
+}
+
+template<typename T>
+static void delete_aligned_array(T* array, size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        array[i].~T();
+    }
+    free_aligned(array);
+}
+
+static void pin_to_core(std::thread& thread, size_t core) noexcept {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+
+JobSystem::JobSystem(size_t thread_count, size_t adoptable_count, bool pin_threads) {
+    if (thread_count == 0) {
+        unsigned const cores = std::thread::hardware_concurrency();
+        thread_count = cores > 1 ? cores - 1 : 0;
+    }
+    m_thread_count = thread_count;
+    m_state_count = thread_count + adoptable_count;
+
+    m_jobs = new_aligned_array<Job>(MAX_JOB_COUNT);
+    for (size_t i = 0; i < MAX_JOB_COUNT; i++) {
+        m_jobs[i].m_next_free.store(uint16_t(i + 1 < MAX_JOB_COUNT ? i + 1 : Job::NONE),
+                std::memory_order_relaxed);
+    }
+    m_free_list.store(0, std::memory_order_relaxed);
+
+    m_states = new_aligned_array<ThreadState>(m_state_count);
+    for (size_t i = 0; i < m_state_count; i++) {
+        m_states[i].js = this;
+        m_states[i].rng = uint32_t(i * 0x9E3779B9u + 1u);
+    }
+    unsigned const cores = std::max(std::thread::hardware_concurrency(), 1u);
+    for (size_t i = 0; i < m_thread_count; i++) {
+        ThreadState& state = m_states[i];
+        state.thread = std::thread(&JobSystem::loop, this, std::ref(state));
+        if (pin_threads) {
+            pin_to_core(state.thread, i % cores);
+        }
+    }
+}
+
+JobSystem::~JobSystem() noexcept {
+    m_exit.store(true, std::memory_order_seq_cst);
+    m_idle.notify();
+    for (size_t i = 0; i < m_thread_count; i++) {
+        m_states[i].thread.join();
+    }
+    delete_aligned_array(m_states, m_state_count);
+    delete_aligned_array(m_jobs, MAX_JOB_COUNT);
+}
+
+bool JobSystem::adopt() {
+    if (get_state()) {
+        // already adopted
+        return true;
+    }
+    if (!link_state(nullptr)) {
+        // no room to remember one more job system in this thread
+        return false;
+    }
+    for (size_t i = m_thread_count; i < m_state_count; i++) {
+        // acquire the queue as the previous owner left it
+        bool expected = false;
+        if (m_states[i].adopted.compare_exchange_strong(expected, true,
+                std::memory_order_acquire, std::memory_order_relaxed)) {
+            // the thieves look at the slots up to the highest one in use so far
+            size_t const count = i - m_thread_count + 1;
+            size_t slots = m_adopted_slot_count.load(std::memory_order_relaxed);
+            while (slots < count && !m_adopted_slot_count.compare_exchange_weak(slots, count,
+                    std::memory_order_relaxed, std::memory_order_relaxed)) {
+            }
+            link_state(&m_states[i]);
+            return true;
+        }
+    }
+    unlink_state();
+    return false;
+}
+
+void JobSystem::emancipate() noexcept {
+    ThreadState* const state = get_state();
+    assert(state && state->queue.size() == 0);
+    if (state) {
+        unlink_state();
+        // the thieves may still look at the dequeue, they only find it empty
+        state->adopted.store(false, std::memory_order_release);
+    }
+}
+
+JobSystem::ThreadState* JobSystem::get_state() const noexcept {
+    ThreadLink const* const links = thread_links();
+    for (size_t i = 0; i < MAX_JOB_SYSTEMS_PER_THREAD; i++) {
+        if (links[i].js == this) {
+            return links[i].state;
+        }
+    }
+    return nullptr;
+}
+
+// links this job system to the current thread, or sets the state of the existing link
+bool JobSystem::link_state(ThreadState* state) noexcept {
+    ThreadLink* const links = thread_links();
+    ThreadLink* free_link = nullptr;
+    for (size_t i = 0; i < MAX_JOB_SYSTEMS_PER_THREAD; i++) {
+        if (links[i].js == this) {
+            links[i].state = state;
+            return true;
+        }
+        if (!links[i].js && !free_link) {
+            free_link = &links[i];
+        }
+    }
+    if (!free_link) {
+        return false;
+    }
+    *free_link = ThreadLink{ this, state };
+    return true;
+}
+
+void JobSystem::unlink_state() noexcept {
+    ThreadLink* const links = thread_links();
+    for (size_t i = 0; i < MAX_JOB_SYSTEMS_PER_THREAD; i++) {
+        if (links[i].js == this) {
+            links[i] = ThreadLink{ nullptr, nullptr };
+        }
+    }
+}
+
+bool JobSystem::is_local_queue_empty() const noexcept {
+    ThreadState const* const state = get_state();
+    return state && state->queue.size() == 0;
+}
+
+bool JobSystem::has_completed(Job const* job) const noexcept {
+    return job->m_running_job_count.load(std::memory_order_seq_cst) == 0;
+}
+
+// --------------------------------------------------------------------------------------------
+// job pool
+
+JobSystem::Job* JobSystem::allocate() noexcept {
+    uint64_t head = m_free_list.load(std::memory_order_acquire);
+    while (true) {
+        uint16_t const index = uint16_t(head & 0xFFFF);
+        if (index == Job::NONE) {
+            return nullptr;
+        }
+        // the tag in the upper bits changes on every pop, so that a head popped and pushed
+        // back by other threads in the meantime doesn't match
+        uint64_t const next = ((head >> 32) + 1) << 32 |
+                m_jobs[index].m_next_free.load(std::memory_order_relaxed);
+        if (m_free_list.compare_exchange_weak(head, next,
+                std::memory_order_acquire, std::memory_order_acquire)) {
+            return &m_jobs[index];
+        }
+    }
+}
+
+void JobSystem::free(Job* job) noexcept {
+    uint16_t const index = index_of(job);
+    uint64_t head = m_free_list.load(std::memory_order_relaxed);
+    do {
+        job->m_next_free.store(uint16_t(head & 0xFFFF), std::memory_order_relaxed);
+    } while (!m_free_list.compare_exchange_weak(head, (head & ~uint64_t(0xFFFF)) | index,
+            std::memory_order_release, std::memory_order_relaxed));
+}
+
+JobSystem::Job* JobSystem::create(Job* parent, JobFunc func) {
+    Job* job = allocate();
+    while (SYS_UNLIKELY(!job)) {
+        // all the jobs are in flight, help finishing them
+        ThreadState* const state = get_state();
+        if (!state || !execute(*state)) {
+            std::this_thread::yield();
+        }
+        job = allocate();
+    }
+    job->m_function = func;
+    job->m_parent = Job::NONE;
+    job->m_running_job_count.store(1, std::memory_order_relaxed);
+    job->m_ref_count.store(1, std::memory_order_relaxed);
+    if (parent) {
+        assert(parent->m_running_job_count.load(std::memory_order_relaxed) > 0);
+        parent->m_running_job_count.fetch_add(1, std::memory_order_relaxed);
+        job->m_parent = index_of(parent);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::retain(Job* job) noexcept {
+    job->m_ref_count.fetch_add(1, std::memory_order_relaxed);
+    return job;
+}
+
+void JobSystem::release(Job*& job) noexcept {
+    if (job->m_ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // a job that ran has completed, and its functor was destroyed by invoke()
+        if ((job->m_parent & Job::OWNS_FUNCTOR) &&
+                job->m_running_job_count.load(std::memory_order_relaxed) > 0) {
+            job->m_function(job->m_storage, *this, nullptr);
+        }
+        free(job);
+    }
+    job = nullptr;
+}
+
+// --------------------------------------------------------------------------------------------
+// scheduling
+
+void JobSystem::run(Job*& job) {
+    ThreadState* const state = get_state();
+    assert(state && "run() from a thread that is not a worker and didn't adopt()");
+    state->queue.push(job);
+    job = nullptr;
+    m_queued_count.fetch_add(1, std::memory_order_relaxed);
+    // wakes all the idle threads, but only makes a system call if one went to sleep since
+    m_idle.notify();
+}
+
+JobSystem::Job* JobSystem::run_and_retain(Job* job) {
+    Job* const retained = retain(job);
+    run(job);
+    return retained;
+}
+
+void JobSystem::wait_and_release(Job*& job) {
+    assert(job->m_ref_count.load(std::memory_order_relaxed) >= 1);
+    ThreadState* const state = get_state();
+    while (!has_completed(job)) {
+        if (state && execute(*state)) {
+            continue;
+        }
+        // nothing to run, the job is running on other threads: sleep until it completes, or
+        // until there is more to run when we can run it
+        m_idle.wait_until([this, state, job]() {
+            return has_completed(job) ||
+                    (state && m_queued_count.load(std::memory_order_relaxed) > 0);
+        });
+    }
+    release(job);
+}
+
+bool JobSystem::execute(ThreadState& state) {
+    Job* job = state.queue.pop();
+    if (!job) {
+        job = steal(state);
+        if (!job) {
+            return false;
+        }
+    }
+    m_queued_count.fetch_sub(1, std::memory_order_relaxed);
+    if (job->m_function) {
+        job->m_function(job->m_storage, *this, job);
+    }
+    finish(job);
+    return true;
+}
+
+JobSystem::Job* JobSystem::steal(ThreadState& state) noexcept {
+    size_t const count = m_thread_count + m_adopted_slot_count.load(std::memory_order_relaxed);
+    if (count < 2) {
+        return nullptr;
+    }
+    // xorshift32, start from a random victim and try them all once
+    uint32_t r = state.rng;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    state.rng = r;
+    size_t const self = size_t(&state - m_states);
+    size_t victim = r % count;
+    for (size_t i = 0; i < count; i++, victim = victim + 1 < count ? victim + 1 : 0) {
+        if (victim != self) {
+            Job* const job = m_states[victim].queue.steal();
+            if (job) {
+                return job;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::finish(Job* job) noexcept {
+    bool completed = false;
+    while (job) {
+        // makes the writes of the children visible to whoever sees the parent complete
+        if (job->m_running_job_count.fetch_sub(1, std::memory_order_seq_cst) != 1) {
+            break;
+        }
+        completed = true;
+        uint16_t const index = uint16_t(job->m_parent & ~Job::OWNS_FUNCTOR);
+        Job* const parent = index == Job::NONE ? nullptr : &m_jobs[index];
+        release(job);
+        job = parent;
+    }
+    // a thread might be sleeping in wait_and_release() on one of them
+    if (completed) {
+        m_idle.notify();
+    }
+}
+
+void JobSystem::loop(ThreadState& state) {
+    bool const linked = link_state(&state);
+    assert(linked);
+    (void)linked;
+    while (!m_exit.load(std::memory_order_relaxed)) {
+        if (execute(state)) {
+            continue;
+        }
+        m_idle.wait_until([this]() {
+            return m_queued_count.load(std::memory_order_relaxed) > 0 ||
+                    m_exit.load(std::memory_order_relaxed);
+        });
+    }
+    unlink_state();
+}
+
+} // namespace sys
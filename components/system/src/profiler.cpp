@@ -9,6 +9,7 @@
 #endif
 
 #include <algorithm>
+#include <iterator>
 #include <memory>
 
 #if defined(__linux__)
@@ -0,0 +1,93 @@
+#include <system/thread_storage.h>
+
+#include <algorithm>
+
+namespace sys {
+namespace details {
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<size_t> free_indices;
+    size_t next_index = 0;
+};
+
+// a storage can be created during static initialization
+Registry& registry() {
+    static Registry* const instance = new Registry; // never destroyed, used by exiting threads
+    return *instance;
+}
+
+} // anonymous namespace
+
+ThreadStorageBase::ThreadStorageBase() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (!r.free_indices.empty()) {
+        m_index = r.free_indices.back();
+        r.free_indices.pop_back();
+    } else {
+        m_index = r.next_index++;
+    }
+}
+
+ThreadStorageBase::~ThreadStorageBase() noexcept {
+    Registry& r = registry();
+    std::vector<ThreadStorageBlock*> blocks;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        // no thread uses the storage anymore, only its exit could look at the blocks
+        for (ThreadStorageBlock* block : m_blocks) {
+            (*block->table)[m_index] = nullptr;
+        }
+        blocks.swap(m_blocks);
+        r.free_indices.push_back(m_index);
+    }
+    for (ThreadStorageBlock* block : blocks) {
+        delete block;
+    }
+}
+
+void ThreadStorageBase::attach(ThreadStorageBlock* block) {
+    std::vector<ThreadStorageBlock*>& blocks = thread_storage_blocks().blocks;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (m_index >= blocks.size()) {
+        blocks.resize(m_index + 1, nullptr);
+    }
+    assert(!blocks[m_index]);
+    m_blocks.push_back(block);
+    block->owner = this;
+    block->table = &blocks;
+    blocks[m_index] = block;
+}
+
+void ThreadStorageBase::invalidate(size_t slot) noexcept {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (ThreadStorageBlock* block : m_blocks) {
+        block->invalidate(slot);
+    }
+}
+
+ThreadStorageBlocks::~ThreadStorageBlocks() noexcept {
+    Registry& r = registry();
+    std::vector<ThreadStorageBlock*> exiting;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (ThreadStorageBlock* block : blocks) {
+            if (block) {
+                std::vector<ThreadStorageBlock*>& owned = block->owner->m_blocks;
+                owned.erase(std::find(owned.begin(), owned.end(), block));
+            }
+        }
+        exiting.swap(blocks);
+    }
+    for (ThreadStorageBlock* block : exiting) {
+        delete block;
+    }
+}
+
+} // namespace details
+} // namespace sys
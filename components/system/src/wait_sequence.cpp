@@ -0,0 +1,55 @@
+#include <system/wait_sequence.h>
+
+#if defined(__linux__)
+#   include <limits.h>
+#   include <unistd.h>
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#endif
+
+namespace sys {
+
+constexpr int WaitSequence::SPIN_COUNT;
+
+WaitSequence::WaitSequence() noexcept = default;
+
+WaitSequence::~WaitSequence() noexcept = default;
+
+#if defined(__linux__)
+
+static long futex(std::atomic<uint32_t>* address, int op, uint32_t value) noexcept {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex on a std::atomic");
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), op, value, nullptr,
+            nullptr, 0);
+}
+
+void WaitSequence::wait(uint32_t sequence) noexcept {
+    futex(&m_sequence, FUTEX_WAIT_PRIVATE, sequence);
+}
+
+void WaitSequence::wake() noexcept {
+    m_sequence.fetch_add(1, std::memory_order_seq_cst);
+    futex(&m_sequence, FUTEX_WAKE_PRIVATE, INT_MAX);
+}
+
+#else
+
+void WaitSequence::wait(uint32_t sequence) noexcept {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this, sequence]() {
+        return m_sequence.load(std::memory_order_seq_cst) != sequence;
+    });
+}
+
+void WaitSequence::wake() noexcept {
+    {
+        // under the lock so that the change can't fall between the check and the wait
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sequence.fetch_add(1, std::memory_order_seq_cst);
+    }
+    m_condition.notify_all();
+}
+
+#endif
+
+} // namespace sys
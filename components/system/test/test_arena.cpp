@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include <system/arena.h>
+
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+using namespace sys;
+
+// counts the heap allocations of the test executable
+static std::atomic<size_t> g_allocation_count{ 0 };
+
+void* operator new(size_t size) {
+    g_allocation_count++;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+TEST(LinearArena, Allocate) {
+    LinearArena arena(1024);
+    EXPECT_EQ(arena.capacity(), 1024u);
+    EXPECT_EQ(arena.used(), 0u);
+
+    void* const a = arena.allocate(3, 1);
+    void* const b = arena.allocate(16, 16);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 16, 0u);
+    EXPECT_GE(static_cast<char*>(b), static_cast<char*>(a) + 3);
+    EXPECT_TRUE(arena.owns(a));
+    EXPECT_FALSE(arena.owns(&arena));
+
+    // full
+    EXPECT_EQ(arena.allocate(2048), nullptr);
+    EXPECT_EQ(arena.make_array<uint64_t>(size_t(1) << 60), nullptr);
+    EXPECT_EQ(arena.allocate(SIZE_MAX, 1), nullptr);
+    EXPECT_EQ(arena.allocate(SIZE_MAX - 15, 16), nullptr);
+    EXPECT_NE(arena.allocate(arena.available(), 1), nullptr);
+    EXPECT_EQ(arena.available(), 0u);
+    EXPECT_EQ(arena.allocate(1, 1), nullptr);
+    EXPECT_EQ(arena.peak(), 1024u);
+
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_EQ(arena.allocate(16, 16), a);
+}
+
+TEST(LinearArena, Make) {
+    LinearArena arena(256);
+    struct Item {
+        int a;
+        float b;
+        Item(int a, float b) : a(a), b(b) {}
+    };
+    Item* const item = arena.make<Item>(7, 2.0f);
+    ASSERT_NE(item, nullptr);
+    EXPECT_EQ(item->a, 7);
+    EXPECT_EQ(item->b, 2.0f);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(item) % alignof(Item), 0u);
+
+    uint32_t* const array = arena.make_array<uint32_t>(10);
+    ASSERT_NE(array, nullptr);
+    std::fill(array, array + 10, 5u);
+    EXPECT_EQ(array[9], 5u);
+}
+
+TEST(LinearArena, Scope) {
+    LinearArena arena(256);
+    arena.allocate(10, 1);
+    size_t const used = arena.used();
+    {
+        ArenaScope scope(arena);
+        unsigned char* const p = static_cast<unsigned char*>(arena.allocate(100, 1));
+        ASSERT_NE(p, nullptr);
+#if SYS_ARENA_POISON
+        EXPECT_EQ(p[0], 0xCD);
+        EXPECT_EQ(p[99], 0xCD);
+#endif
+        {
+            ArenaScope inner(arena);
+            arena.allocate(50);
+        }
+        EXPECT_EQ(arena.used(), used + 100);
+    }
+    EXPECT_EQ(arena.used(), used);
+#if SYS_ARENA_POISON
+    unsigned char const* const freed = static_cast<unsigned char*>(arena.allocate(1, 1));
+    EXPECT_EQ(freed[0], 0xCD);
+    EXPECT_EQ(freed[1], 0xDD);
+#endif
+}
+
+TEST(ArenaAllocator, Vector) {
+    LinearArena arena(4096);
+    {
+        ArenaScope scope(arena);
+        std::vector<int, ArenaAllocator<int>> v{ ArenaAllocator<int>(arena) };
+        v.reserve(100);
+        for (int i = 0; i < 100; i++) {
+            v.push_back(i);
+        }
+        EXPECT_EQ(v[99], 99);
+        EXPECT_TRUE(arena.owns(v.data()));
+        EXPECT_EQ(arena.used(), 100 * sizeof(int));
+
+        // the last allocation is given back
+        v.clear();
+        v.shrink_to_fit();
+        EXPECT_EQ(arena.used(), 0u);
+
+        ArenaAllocator<double> other(v.get_allocator());
+        EXPECT_TRUE(other == v.get_allocator());
+    }
+    std::vector<char, ArenaAllocator<char>> big{ ArenaAllocator<char>(arena) };
+    EXPECT_THROW(big.resize(8192), std::bad_alloc);
+}
+
+TEST(FrameAllocator, Frames) {
+    FrameAllocator frames(1024, 3);
+    EXPECT_EQ(frames.frame_count(), 3u);
+
+    void* first[3];
+    for (int i = 0; i < 3; i++) {
+        LinearArena& arena = frames.begin_frame();
+        EXPECT_EQ(&arena, &frames.current());
+        EXPECT_EQ(arena.capacity(), 1024u);
+        first[i] = frames.allocate(64, 64);
+        ASSERT_NE(first[i], nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(first[i]) % 64, 0u);
+        // the previous frames are still valid
+        for (int j = 0; j < i; j++) {
+            EXPECT_NE(first[i], first[j]);
+        }
+    }
+    // the 4th frame reuses the memory of the 1st one
+    frames.begin_frame();
+    EXPECT_EQ(frames.current().used(), 0u);
+    EXPECT_EQ(frames.allocate(64, 64), first[0]);
+    EXPECT_EQ(frames.frame(), 4u);
+    EXPECT_EQ(frames.peak(), 64u);
+
+    EXPECT_THROW(FrameAllocator(1024, 0), std::invalid_argument);
+    EXPECT_THROW(FrameAllocator(1024, FrameAllocator::MAX_FRAME_COUNT + 1),
+            std::invalid_argument);
+}
+
+TEST(FrameAllocator, NoHeapAllocationPerFrame) {
+    FrameAllocator frames(64 * 1024);
+    size_t const before = g_allocation_count.load();
+    for (int frame = 0; frame < 100; frame++) {
+        LinearArena& arena = frames.begin_frame();
+        std::vector<uint32_t, ArenaAllocator<uint32_t>> visible{ ArenaAllocator<uint32_t>(arena) };
+        visible.reserve(1000);
+        for (uint32_t i = 0; i < 1000; i++) {
+            visible.push_back(i * 7 % 1000);
+        }
+        std::sort(visible.begin(), visible.end());
+        ArenaScope scope(arena);
+        float* const keys = arena.make_array<float>(1000);
+        keys[0] = float(visible[0]);
+    }
+    EXPECT_EQ(g_allocation_count.load(), before);
+}
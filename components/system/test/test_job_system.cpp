@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+
+#include <system/job_system.h>
+#include <system/work_stealing_dequeue.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace sys;
+
+TEST(WorkStealingDequeue, PushPopSteal) {
+    WorkStealingDequeue<int*, 16> queue;
+    int values[4] = {};
+    EXPECT_EQ(queue.pop(), nullptr);
+    EXPECT_EQ(queue.steal(), nullptr);
+
+    for (int& v : values) {
+        queue.push(&v);
+    }
+    EXPECT_EQ(queue.size(), 4u);
+    // the owner is LIFO, the thieves FIFO
+    EXPECT_EQ(queue.pop(), &values[3]);
+    EXPECT_EQ(queue.steal(), &values[0]);
+    EXPECT_EQ(queue.pop(), &values[2]);
+    EXPECT_EQ(queue.pop(), &values[1]);
+    EXPECT_EQ(queue.pop(), nullptr);
+    EXPECT_EQ(queue.steal(), nullptr);
+    EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST(WorkStealingDequeue, ConcurrentSteal) {
+    constexpr int COUNT = 100000;
+    WorkStealingDequeue<intptr_t, 1024> queue;
+    std::atomic<bool> done{ false };
+    std::atomic<int64_t> stolen_sum{ 0 };
+    std::atomic<int> stolen_count{ 0 };
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; t++) {
+        thieves.emplace_back([&]() {
+            while (!done.load()) {
+                intptr_t const v = queue.steal();
+                if (v) {
+                    stolen_sum += v;
+                    stolen_count++;
+                }
+            }
+        });
+    }
+    int64_t popped_sum = 0;
+    int popped_count = 0;
+    for (intptr_t i = 1; i <= COUNT; i++) {
+        queue.push(i);
+        if (i % 3 == 0) {
+            intptr_t const v = queue.pop();
+            if (v) {
+                popped_sum += v;
+                popped_count++;
+            }
+        }
+        while (queue.size() > 512) {
+            std::this_thread::yield();
+        }
+    }
+    while (intptr_t const v = queue.pop()) {
+        popped_sum += v;
+        popped_count++;
+    }
+    done = true;
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+    // every item was taken exactly once
+    EXPECT_EQ(popped_count + stolen_count.load(), COUNT);
+    EXPECT_EQ(popped_sum + stolen_sum.load(), int64_t(COUNT) * (COUNT + 1) / 2);
+}
+
+TEST(JobSystem, RunAndWait) {
+    JobSystem js(3);
+    js.adopt();
+    std::atomic<int> count{ 0 };
+    JobSystem::Job* root = js.create();
+    for (int i = 0; i < 1000; i++) {
+        JobSystem::Job* job = js.create(root, [&count](JobSystem&, JobSystem::Job*) {
+            count++;
+        });
+        js.run(job);
+        EXPECT_EQ(job, nullptr);
+    }
+    js.run_and_wait(root);
+    EXPECT_EQ(count.load(), 1000);
+    js.emancipate();
+}
+
+TEST(JobSystem, Children) {
+    JobSystem js(2);
+    js.adopt();
+    // each job spawns children, the root completes after all the descendants
+    std::atomic<int> count{ 0 };
+    struct Spawn {
+        std::atomic<int>* count;
+        int depth;
+        void operator()(JobSystem& js, JobSystem::Job* job) {
+            (*count)++;
+            if (depth > 0) {
+                for (int i = 0; i < 4; i++) {
+                    JobSystem::Job* child = js.create(job, Spawn{ count, depth - 1 });
+                    js.run(child);
+                }
+            }
+        }
+    };
+    JobSystem::Job* root = js.create(nullptr, Spawn{ &count, 5 });
+    js.run_and_wait(root);
+    // 1 + 4 + ... + 4^5
+    EXPECT_EQ(count.load(), 1365);
+    js.emancipate();
+}
+
+TEST(JobSystem, ManyJobs) {
+    // more jobs than the pool holds, create() runs some to free the others
+    JobSystem js(1);
+    js.adopt();
+    std::atomic<int> count{ 0 };
+    JobSystem::Job* root = js.create();
+    for (size_t i = 0; i < JobSystem::MAX_JOB_COUNT * 4; i++) {
+        JobSystem::Job* job = js.create(root, [&count](JobSystem&, JobSystem::Job*) {
+            count++;
+        });
+        js.run(job);
+    }
+    js.run_and_wait(root);
+    EXPECT_EQ(count.load(), int(JobSystem::MAX_JOB_COUNT * 4));
+    js.emancipate();
+}
+
+TEST(JobSystem, ParallelFor) {
+    JobSystem js(3, 1, true);
+    js.adopt();
+    std::vector<std::atomic<int>> hits(100000);
+    for (auto& h : hits) {
+        h = 0;
+    }
+    std::atomic<int> calls{ 0 };
+    JobSystem::Job* job = js.parallel_for(nullptr, 0, uint32_t(hits.size()),
+            [&hits, &calls](uint32_t start, uint32_t count) {
+                calls++;
+                for (uint32_t i = start; i < start + count; i++) {
+                    hits[i]++;
+                }
+            }, 64);
+    js.run_and_wait(job);
+    for (size_t i = 0; i < hits.size(); i++) {
+        ASSERT_EQ(hits[i].load(), 1) << i;
+    }
+    EXPECT_GE(calls.load(), int(hits.size() / 64));
+    js.emancipate();
+}
+
+TEST(JobSystem, DefaultThreadCount) {
+    // no workers on a single core, everything runs on the waiting thread
+    JobSystem js;
+    js.adopt();
+    std::atomic<int> sum{ 0 };
+    JobSystem::Job* job = js.parallel_for(nullptr, 0, 1000,
+            [&sum](uint32_t start, uint32_t count) {
+                for (uint32_t i = start; i < start + count; i++) {
+                    sum += int(i);
+                }
+            }, 10);
+    js.run_and_wait(job);
+    EXPECT_EQ(sum.load(), 999 * 1000 / 2);
+    js.emancipate();
+}
+
+TEST(JobSystem, AdoptEmancipate) {
+    JobSystem js(1, 2);
+    auto const sum_jobs = [&js]() {
+        std::atomic<int> sum{ 0 };
+        JobSystem::Job* job = js.parallel_for(nullptr, 0, 100,
+                [&sum](uint32_t start, uint32_t count) {
+                    for (uint32_t i = start; i < start + count; i++) {
+                        sum += int(i);
+                    }
+                });
+        js.run_and_wait(job);
+        return sum.load();
+    };
+
+    EXPECT_TRUE(js.adopt());
+    EXPECT_TRUE(js.adopt());
+    // the slots are given back, many more threads than slots can take turns
+    for (int i = 0; i < 8; i++) {
+        std::thread thread([&]() {
+            EXPECT_TRUE(js.adopt());
+            EXPECT_EQ(sum_jobs(), 99 * 100 / 2);
+            // the two slots are taken
+            std::thread([&]() { EXPECT_FALSE(js.adopt()); }).join();
+            js.emancipate();
+        });
+        thread.join();
+    }
+    EXPECT_EQ(sum_jobs(), 99 * 100 / 2);
+    js.emancipate();
+    EXPECT_TRUE(js.adopt());
+    EXPECT_EQ(sum_jobs(), 99 * 100 / 2);
+    js.emancipate();
+}
+
+TEST(JobSystem, AdoptSeveral) {
+    auto const sum_jobs = [](JobSystem& js) {
+        std::atomic<int> sum{ 0 };
+        JobSystem::Job* job = js.parallel_for(nullptr, 0, 100,
+                [&sum](uint32_t start, uint32_t count) {
+                    for (uint32_t i = start; i < start + count; i++) {
+                        sum += int(i);
+                    }
+                });
+        js.run_and_wait(job);
+        return sum.load();
+    };
+
+    std::vector<std::unique_ptr<JobSystem>> systems;
+    for (size_t i = 0; i <= JobSystem::MAX_JOB_SYSTEMS_PER_THREAD; i++) {
+        systems.emplace_back(new JobSystem(1));
+    }
+    for (size_t i = 0; i < JobSystem::MAX_JOB_SYSTEMS_PER_THREAD; i++) {
+        EXPECT_TRUE(systems[i]->adopt());
+    }
+    EXPECT_FALSE(systems.back()->adopt());
+    // adopting one doesn't hide the others
+    for (size_t i = 0; i < JobSystem::MAX_JOB_SYSTEMS_PER_THREAD; i++) {
+        EXPECT_EQ(sum_jobs(*systems[i]), 99 * 100 / 2);
+    }
+    systems[0]->emancipate();
+    EXPECT_TRUE(systems.back()->adopt());
+    EXPECT_EQ(sum_jobs(*systems.back()), 99 * 100 / 2);
+    EXPECT_EQ(sum_jobs(*systems[1]), 99 * 100 / 2);
+    for (size_t i = 1; i <= JobSystem::MAX_JOB_SYSTEMS_PER_THREAD; i++) {
+        systems[i]->emancipate();
+    }
+}
+
+TEST(JobSystem, ReleaseWithoutRunning) {
+    JobSystem js(1);
+    js.adopt();
+    std::shared_ptr<int> const value = std::make_shared<int>(0);
+    JobSystem::Job* job = js.create(nullptr, [value](JobSystem&, JobSystem::Job*) {
+        ++*value;
+    });
+    EXPECT_EQ(value.use_count(), 2);
+    // the functor is destroyed without being called
+    js.release(job);
+    EXPECT_EQ(value.use_count(), 1);
+    EXPECT_EQ(*value, 0);
+
+    // and only once when the job runs
+    job = js.create(nullptr, [value](JobSystem&, JobSystem::Job*) {
+        ++*value;
+    });
+    js.run_and_wait(job);
+    EXPECT_EQ(value.use_count(), 1);
+    EXPECT_EQ(*value, 1);
+    js.emancipate();
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <system/pool.h>
+
+#include <set>
+#include <vector>
+
+using namespace sys;
+
+namespace {
+
+struct Tracked {
+    static int alive;
+    int value;
+    explicit Tracked(int v) noexcept : value(v) { alive++; }
+    ~Tracked() noexcept { alive--; }
+};
+
+int Tracked::alive = 0;
+
+// fills its slot, where the link to the next free slot was, before throwing
+struct Throwing {
+    explicit Throwing(bool fail) : bits(~uint64_t(0)) {
+        if (fail) {
+            throw 1;
+        }
+    }
+    uint64_t bits;
+};
+
+} // anonymous namespace
+
+TEST(Pool, CreateDestroy) {
+    Pool<Tracked> pool;
+    EXPECT_TRUE(pool.empty());
+    Tracked* const a = pool.create(1);
+    Tracked* const b = pool.create(2);
+    EXPECT_EQ(a->value, 1);
+    EXPECT_EQ(b->value, 2);
+    EXPECT_EQ(pool.size(), 2u);
+    EXPECT_EQ(Tracked::alive, 2);
+    EXPECT_TRUE(pool.owns(a));
+    EXPECT_GE(pool.capacity(), Pool<Tracked>::SLOTS_PER_CHUNK);
+
+    // the last freed slot is reused first
+    pool.destroy(a);
+    EXPECT_EQ(Tracked::alive, 1);
+    Tracked* const c = pool.create(3);
+    EXPECT_EQ(c, a);
+    EXPECT_EQ(b->value, 2);
+
+    pool.destroy(nullptr);
+    pool.destroy(b);
+    pool.destroy(c);
+    EXPECT_TRUE(pool.empty());
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(Pool, Chunks) {
+    size_t const count = Pool<Tracked, 4096>::SLOTS_PER_CHUNK * 3 + 5;
+    std::vector<Tracked*> objects;
+    {
+        Pool<Tracked, 4096> pool;
+        pool.reserve(count / 2);
+        size_t const capacity = pool.capacity();
+        EXPECT_GE(capacity, count / 2);
+        for (size_t i = 0; i < count; i++) {
+            objects.push_back(pool.create(int(i)));
+        }
+        EXPECT_GE(pool.capacity(), count);
+        // stable addresses, all distinct
+        EXPECT_EQ(std::set<Tracked*>(objects.begin(), objects.end()).size(), count);
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_EQ(objects[i]->value, int(i));
+        }
+
+        for (size_t i = 0; i < count; i += 2) {
+            pool.destroy(objects[i]);
+        }
+        size_t visited = 0;
+        long long sum = 0;
+        pool.for_each([&](Tracked& t) {
+            visited++;
+            sum += t.value;
+            EXPECT_EQ(t.value % 2, 1);
+        });
+        EXPECT_EQ(visited, pool.size());
+        EXPECT_EQ(visited, count / 2);
+        long long expected = 0;
+        for (size_t i = 1; i < count; i += 2) {
+            expected += int(i);
+        }
+        EXPECT_EQ(sum, expected);
+
+        // no new chunk while there are free slots
+        size_t const before = pool.capacity();
+        for (size_t i = 0; i < count / 2; i++) {
+            pool.create(0);
+        }
+        EXPECT_EQ(pool.capacity(), before);
+    }
+    // the objects still alive are destroyed with the pool
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(Pool, Clear) {
+    Pool<Tracked> pool;
+    Tracked* const first = pool.create(1);
+    for (int i = 0; i < 100; i++) {
+        pool.create(i);
+    }
+    pool.clear();
+    EXPECT_EQ(pool.size(), 0u);
+    EXPECT_EQ(Tracked::alive, 0);
+    EXPECT_EQ(pool.create(7), first);
+    pool.clear();
+}
+
+TEST(Pool, ThrowingConstructor) {
+    Pool<Throwing, 4096> pool;
+    Throwing* const a = pool.create(false);
+    EXPECT_THROW(pool.create(true), int);
+    EXPECT_EQ(pool.size(), 1u);
+    // the slot and the rest of the free list are intact
+    std::set<Throwing*> created{ a };
+    for (size_t i = 0; i < Pool<Throwing, 4096>::SLOTS_PER_CHUNK * 2; i++) {
+        Throwing* const p = pool.create(false);
+        EXPECT_TRUE(pool.owns(p));
+        EXPECT_TRUE(created.insert(p).second);
+    }
+    EXPECT_EQ(pool.size(), created.size());
+}
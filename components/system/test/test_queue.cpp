@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <system/mpmc_queue.h>
+#include <system/spsc_queue.h>
+#include <system/wait_sequence.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sys;
+
+TEST(WaitSequence, WaitUntil) {
+    WaitSequence waiter;
+    std::atomic<int> value{ 0 };
+    std::thread thread([&]() {
+        waiter.wait_until([&]() { return value.load() == 3; });
+        value.store(4);
+        waiter.notify();
+    });
+    for (int i = 1; i <= 3; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        value.store(i);
+        waiter.notify();
+    }
+    waiter.wait_until([&]() { return value.load() == 4; });
+    thread.join();
+}
+
+TEST(SpscQueue, PushPop) {
+    SpscQueue<std::string, 4> queue;
+    std::string s;
+    EXPECT_FALSE(queue.try_pop(s));
+    EXPECT_TRUE(queue.try_push("a"));
+    EXPECT_TRUE(queue.try_emplace(2, 'b'));
+    EXPECT_TRUE(queue.try_push("c"));
+    EXPECT_TRUE(queue.try_push("d"));
+    EXPECT_TRUE(queue.full());
+    EXPECT_FALSE(queue.try_push("e"));
+    EXPECT_EQ(queue.size(), 4u);
+
+    EXPECT_TRUE(queue.try_pop(s));
+    EXPECT_EQ(s, "a");
+    EXPECT_EQ(queue.pop(), "bb");
+    EXPECT_TRUE(queue.try_push("e"));
+
+    // wraps around
+    std::string out[8];
+    EXPECT_EQ(queue.try_pop(out, 8), 3u);
+    EXPECT_EQ(out[0], "c");
+    EXPECT_EQ(out[1], "d");
+    EXPECT_EQ(out[2], "e");
+    EXPECT_TRUE(queue.empty());
+
+    std::string const in[] = { "1", "2", "3", "4", "5", "6" };
+    EXPECT_EQ(queue.try_push(in, 6), 4u);
+    EXPECT_EQ(queue.try_push(in + 4, 2), 0u);
+    EXPECT_EQ(queue.pop(out, 2), 2u);
+    EXPECT_EQ(out[1], "2");
+}
+
+TEST(SpscQueue, DestroysItems) {
+    auto const item = std::make_shared<int>(1);
+    {
+        SpscQueue<std::shared_ptr<int>, 8> queue;
+        queue.push(item);
+        queue.push(item);
+        queue.pop();
+        EXPECT_EQ(item.use_count(), 2);
+    }
+    EXPECT_EQ(item.use_count(), 1);
+}
+
+TEST(SpscQueue, Concurrent) {
+    constexpr uint32_t COUNT = 200000;
+    static SpscQueue<uint32_t, 64> queue;
+    std::thread producer([]() {
+        uint32_t batch[7];
+        for (uint32_t i = 0; i < COUNT;) {
+            if (i % 3) {
+                queue.push(i++);
+            } else {
+                uint32_t n = 0;
+                while (n < 7 && i < COUNT) {
+                    batch[n++] = i++;
+                }
+                queue.push(batch, n);
+            }
+        }
+    });
+    // in order, nothing lost or duplicated
+    uint32_t next = 0;
+    uint32_t batch[5];
+    while (next < COUNT) {
+        if (next % 2) {
+            EXPECT_EQ(queue.pop(), next);
+            next++;
+        } else {
+            size_t const n = queue.pop(batch, 5);
+            for (size_t i = 0; i < n; i++) {
+                EXPECT_EQ(batch[i], next++);
+            }
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpmcQueue, PushPop) {
+    MpmcQueue<std::string, 4> queue;
+    std::string s;
+    EXPECT_FALSE(queue.try_pop(s));
+    EXPECT_TRUE(queue.try_push("a"));
+    EXPECT_TRUE(queue.try_emplace(2, 'b'));
+    std::string const in[] = { "c", "d", "e" };
+    EXPECT_EQ(queue.try_push(in, 3), 2u);
+    EXPECT_TRUE(queue.full());
+    EXPECT_FALSE(queue.try_push("e"));
+
+    EXPECT_EQ(queue.pop(), "a");
+    EXPECT_TRUE(queue.try_pop(s));
+    EXPECT_EQ(s, "bb");
+    queue.push("e");
+
+    // wraps around
+    std::string out[8];
+    EXPECT_EQ(queue.try_pop(out, 8), 3u);
+    EXPECT_EQ(out[0], "c");
+    EXPECT_EQ(out[1], "d");
+    EXPECT_EQ(out[2], "e");
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.try_pop(out, 8), 0u);
+}
+
+TEST(MpmcQueue, DestroysItems) {
+    auto const item = std::make_shared<int>(1);
+    {
+        MpmcQueue<std::shared_ptr<int>, 8> queue;
+        queue.push(item);
+        queue.push(item);
+        queue.pop();
+        EXPECT_EQ(item.use_count(), 2);
+    }
+    EXPECT_EQ(item.use_count(), 1);
+}
+
+TEST(MpmcQueue, Concurrent) {
+    constexpr uint32_t PRODUCERS = 4;
+    constexpr uint32_t CONSUMERS = 4;
+    constexpr uint32_t COUNT = 50000;
+    static MpmcQueue<uint32_t, 64> queue;
+
+    // each producer pushes its id in the top bits and a counter in the bottom ones
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        threads.emplace_back([p]() {
+            uint32_t batch[3];
+            for (uint32_t i = 0; i < COUNT;) {
+                if (i % 2) {
+                    queue.push(p << 24 | i++);
+                } else {
+                    uint32_t n = 0;
+                    while (n < 3 && i < COUNT) {
+                        batch[n++] = p << 24 | i++;
+                    }
+                    queue.push(batch, n);
+                }
+            }
+        });
+    }
+    std::atomic<uint64_t> sum{ 0 };
+    std::atomic<uint32_t> popped{ 0 };
+    std::atomic<bool> in_order{ true };
+    for (uint32_t c = 0; c < CONSUMERS; c++) {
+        threads.emplace_back([&]() {
+            // the items of one producer reach a consumer in order
+            std::vector<int64_t> last(PRODUCERS, -1);
+            uint32_t batch[4];
+            while (popped.load() < PRODUCERS * COUNT) {
+                size_t const n = queue.try_pop(batch, 4);
+                for (size_t i = 0; i < n; i++) {
+                    uint32_t const p = batch[i] >> 24;
+                    int64_t const counter = batch[i] & 0xFFFFFF;
+                    if (counter <= last[p]) {
+                        in_order.store(false);
+                    }
+                    last[p] = counter;
+                    sum.fetch_add(counter);
+                }
+                popped.fetch_add(uint32_t(n));
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(popped.load(), PRODUCERS * COUNT);
+    EXPECT_EQ(sum.load(), uint64_t(PRODUCERS) * COUNT * (COUNT - 1) / 2);
+    EXPECT_TRUE(in_order.load());
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpmcQueue, BlockingConsumers) {
+    constexpr uint32_t CONSUMERS = 3;
+    constexpr uint32_t COUNT = 30000;
+    static MpmcQueue<uint32_t, 16> queue;
+    std::atomic<uint64_t> sum{ 0 };
+    std::vector<std::thread> consumers;
+    for (uint32_t c = 0; c < CONSUMERS; c++) {
+        consumers.emplace_back([&]() {
+            // 0 stops the consumer
+            while (uint32_t const value = queue.pop()) {
+                sum.fetch_add(value);
+            }
+        });
+    }
+    for (uint32_t i = 1; i <= COUNT; i++) {
+        queue.push(i);
+    }
+    for (uint32_t c = 0; c < CONSUMERS; c++) {
+        queue.push(0);
+    }
+    for (auto& thread : consumers) {
+        thread.join();
+    }
+    EXPECT_EQ(sum.load(), uint64_t(COUNT) * (COUNT + 1) / 2);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <system/slot_map.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace sys;
+
+namespace {
+
+struct Throwing {
+    explicit Throwing(int v) : value(v) {
+        if (v < 0) {
+            throw v;
+        }
+    }
+    int value;
+};
+
+} // anonymous namespace
+
+TEST(SlotHandle, Layout) {
+    using Handle32 = SlotHandle<int>;
+    using Handle64 = SlotHandle<int, uint64_t>;
+    static_assert(sizeof(Handle32) == 4, "32-bit handle");
+    static_assert(sizeof(Handle64) == 8, "64-bit handle");
+
+    EXPECT_FALSE(Handle32());
+    Handle32 const h(12345, 67);
+    EXPECT_TRUE(h);
+    EXPECT_EQ(h.index(), 12345u);
+    EXPECT_EQ(h.generation(), 67u);
+    EXPECT_EQ(Handle32::from_value(h.value()), h);
+    EXPECT_EQ(Handle32::MAX_INDEX, (1u << 20) - 1);
+    EXPECT_EQ(Handle32::MAX_GENERATION, (1u << 12) - 1);
+
+    Handle64 const g(0xFFFFFFFFu, 0x12345678u);
+    EXPECT_EQ(g.index(), 0xFFFFFFFFu);
+    EXPECT_EQ(g.generation(), 0x12345678u);
+}
+
+TEST(SlotMap, InsertGetErase) {
+    SlotMap<std::string> map;
+    auto const a = map.insert("a");
+    auto const b = map.emplace(3, 'b');
+    auto const c = map.insert("c");
+    EXPECT_EQ(map.size(), 3u);
+    EXPECT_EQ(*map.get(a), "a");
+    EXPECT_EQ(map[b], "bbb");
+    EXPECT_TRUE(map.contains(c));
+    EXPECT_EQ(map.get(SlotMap<std::string>::Handle()), nullptr);
+
+    // the last object fills the hole, the handles stay valid
+    EXPECT_TRUE(map.erase(a));
+    EXPECT_FALSE(map.erase(a));
+    EXPECT_EQ(map.get(a), nullptr);
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map[b], "bbb");
+    EXPECT_EQ(map[c], "c");
+    EXPECT_EQ(map.data()[0], "c");
+    EXPECT_EQ(map.handle_of(0), c);
+
+    // the slot is reused with a new generation
+    auto const d = map.insert("d");
+    EXPECT_EQ(d.index(), a.index());
+    EXPECT_NE(d, a);
+    EXPECT_EQ(map.get(a), nullptr);
+    EXPECT_EQ(map[d], "d");
+
+    // a handle made up for a free slot doesn't match
+    EXPECT_TRUE(map.erase(d));
+    using Handle = SlotMap<std::string>::Handle;
+    EXPECT_EQ(map.get(Handle(d.index(), d.generation() + 1)), nullptr);
+    EXPECT_EQ(map.get(Handle(100, 1)), nullptr);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.get(b), nullptr);
+    EXPECT_EQ(map.get(c), nullptr);
+}
+
+TEST(SlotMap, DenseIteration) {
+    SlotMap<int, uint64_t> map;
+    std::vector<SlotMap<int, uint64_t>::Handle> handles;
+    for (int i = 0; i < 1000; i++) {
+        handles.push_back(map.insert(i));
+    }
+    for (int i = 0; i < 1000; i += 3) {
+        EXPECT_TRUE(map.erase(handles[i]));
+    }
+    int sum = 0;
+    for (int v : map) {
+        sum += v;
+    }
+    int expected = 0;
+    for (int i = 0; i < 1000; i++) {
+        expected += i % 3 ? i : 0;
+    }
+    EXPECT_EQ(sum, expected);
+    for (size_t i = 0; i < map.size(); i++) {
+        EXPECT_EQ(*map.get(map.handle_of(i)), map.data()[i]);
+    }
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(map.contains(handles[i]), i % 3 != 0);
+    }
+    std::unordered_set<SlotMap<int, uint64_t>::Handle> set(handles.begin(), handles.end());
+    EXPECT_EQ(set.size(), handles.size());
+}
+
+TEST(SlotMap, GenerationWrap) {
+    SlotMap<int> map;
+    auto const first = map.insert(0);
+    map.erase(first);
+    auto h = first;
+    for (uint32_t i = 0; i < SlotMap<int>::Handle::MAX_GENERATION - 1; i++) {
+        h = map.insert(1);
+        EXPECT_NE(h, first);
+        map.erase(h);
+    }
+    EXPECT_EQ(h.generation(), SlotMap<int>::Handle::MAX_GENERATION);
+    // generation 0 is skipped, the slot comes back to generation 1
+    EXPECT_EQ(map.insert(2), first);
+}
+
+TEST(SlotMap, ThrowingConstructor) {
+    SlotMap<Throwing> map;
+    auto const a = map.emplace(1);
+    auto const b = map.emplace(2);
+    EXPECT_TRUE(map.erase(a));
+    // a reused slot, then a new one
+    EXPECT_THROW(map.emplace(-1), int);
+    EXPECT_THROW(map.emplace(-1), int);
+    EXPECT_EQ(map.size(), 1u);
+
+    // the slots and the dense array still agree
+    auto const c = map.emplace(3);
+    auto const d = map.emplace(4);
+    EXPECT_TRUE(map.erase(b));
+    EXPECT_EQ(map.get(c)->value, 3);
+    EXPECT_EQ(map.get(d)->value, 4);
+    int sum = 0;
+    for (Throwing const& t : map) {
+        sum += t.value;
+    }
+    EXPECT_EQ(sum, 7);
+}
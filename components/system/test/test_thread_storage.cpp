@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <system/thread_storage.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace sys;
+
+namespace {
+
+struct Counted {
+    static std::atomic<int> alive;
+    Counted() noexcept { alive++; }
+    ~Counted() noexcept { alive--; }
+    int value = 0;
+};
+
+std::atomic<int> Counted::alive{ 0 };
+
+// an object owning a storage, destroying it registers again
+struct Nested {
+    ThreadStorage<int> inner;
+    unsigned int const id = inner.add();
+};
+
+} // anonymous namespace
+
+TEST(ThreadStorage, AddGetRemove) {
+    ThreadStorage<int> storage;
+    int* obj = nullptr;
+    unsigned int const id = storage.add(&obj);
+    EXPECT_NE(id, 0u);
+    ASSERT_NE(obj, nullptr);
+    EXPECT_EQ(*obj, 0);
+    *obj = 42;
+    EXPECT_EQ(storage.get(id), obj);
+    EXPECT_EQ(*static_cast<const ThreadStorage<int>&>(storage).get(id), 42);
+
+    EXPECT_TRUE(storage.remove(id));
+    EXPECT_FALSE(storage.remove(id));
+    EXPECT_EQ(storage.get(id), nullptr);
+    EXPECT_EQ(storage.get(0), nullptr);
+
+    // the slot is reused with a new generation, the old id stays dead
+    unsigned int const other = storage.add();
+    EXPECT_NE(other, id);
+    EXPECT_EQ(storage.get(id), nullptr);
+    ASSERT_NE(storage.get(other), nullptr);
+    EXPECT_EQ(*storage.get(other), 0);
+}
+
+TEST(ThreadStorage, Capacity) {
+    ThreadStorage<int, 4> storage;
+    unsigned int ids[4];
+    for (unsigned int& id : ids) {
+        id = storage.add();
+        EXPECT_NE(id, 0u);
+    }
+    EXPECT_EQ(storage.add(), 0u);
+    EXPECT_TRUE(storage.remove(ids[2]));
+    EXPECT_NE(storage.add(), 0u);
+}
+
+TEST(ThreadStorage, GenerationWrap) {
+    // not a power of two: the ids of the last slot reach UINT32_MAX before its generations wrap
+    constexpr size_t CAPACITY = 60000;
+    std::unique_ptr<ThreadStorage<int, CAPACITY>> storage(new ThreadStorage<int, CAPACITY>);
+    unsigned int id = 0;
+    for (size_t i = 0; i < CAPACITY; i++) {
+        id = storage->add();
+    }
+    bool aliased = false;
+    for (uint32_t i = 0; i < uint32_t(~0u / CAPACITY) + 2; i++) {
+        EXPECT_TRUE(storage->remove(id));
+        id = storage->add();
+        aliased |= id == 0 || id % CAPACITY != CAPACITY - 1;
+    }
+    EXPECT_FALSE(aliased);
+}
+
+TEST(ThreadStorage, PerThread) {
+    ThreadStorage<int> storage;
+    unsigned int const a = storage.add();
+    unsigned int const b = storage.add();
+    *storage.get(a) = -1;
+
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{ 0 };
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&storage, &failures, a, b, t]() {
+            int* const pa = storage.get(a);
+            int* const pb = storage.get(b);
+            if (!pa || !pb || pa == pb || *pa != 0) {
+                failures++;
+                return;
+            }
+            for (int i = 0; i < 1000; i++) {
+                *storage.get(a) += t;
+                *storage.get(b) += 1;
+            }
+            if (*pa != 1000 * t || *pb != 1000) {
+                failures++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(*storage.get(a), -1);
+}
+
+TEST(ThreadStorage, RemoveFromOtherThread) {
+    ThreadStorage<int> storage;
+    unsigned int const id = storage.add();
+    *storage.get(id) = 1;
+    // the objects the threads already have are found without the storage, not once removed
+    std::thread([&storage, id]() { EXPECT_TRUE(storage.remove(id)); }).join();
+    EXPECT_EQ(storage.get(id), nullptr);
+    unsigned int const other = storage.add();
+    ASSERT_NE(storage.get(other), nullptr);
+    EXPECT_EQ(*storage.get(other), 0);
+}
+
+TEST(ThreadStorage, Lifetime) {
+    {
+        ThreadStorage<Counted> storage;
+        unsigned int const id = storage.add();
+        std::thread([&storage, id]() {
+            EXPECT_NE(storage.get(id), nullptr);
+            EXPECT_EQ(Counted::alive.load(), 1);
+        }).join();
+        // destroyed with the thread
+        EXPECT_EQ(Counted::alive.load(), 0);
+
+        storage.get(id);
+        EXPECT_EQ(Counted::alive.load(), 1);
+        EXPECT_TRUE(storage.remove(id));
+        unsigned int const other = storage.add();
+        // the object of the removed id is replaced when the slot is used again
+        storage.get(other);
+        EXPECT_EQ(Counted::alive.load(), 1);
+    }
+    // and with the storage
+    EXPECT_EQ(Counted::alive.load(), 0);
+
+    // a new storage gets the index of the old one, not its objects
+    ThreadStorage<Counted> storage;
+    Counted* obj = nullptr;
+    storage.add(&obj);
+    ASSERT_NE(obj, nullptr);
+    EXPECT_EQ(obj->value, 0);
+    EXPECT_EQ(Counted::alive.load(), 1);
+}
+
+TEST(ThreadStorage, NestedStorages) {
+    DynamicThreadStorage outer;
+    unsigned int const id = outer.add();
+    auto const fill = [&outer, id]() {
+        DynamicStoragePtr* const ptr = outer.get(id);
+        ptr->reset(new ValueStorage<Nested>());
+        Nested& nested = static_cast<ValueStorage<Nested>*>(ptr->get())->value;
+        *nested.inner.get(nested.id) = 1;
+    };
+    // destroyed with the thread
+    std::thread(fill).join();
+    // and with the storage
+    fill();
+}